@@ -0,0 +1,391 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     Arduino.cpp                                                                                */
+/* Description:                                                                                   */
+/*     Minimal Arduino API to build the firmware on the host (native). Serial is mapped to        */
+/*     stdin/stdout and time to the host monotonic clock (or to a virtual clock that advances a   */
+/*     fixed step each loop, if NATIVE_VIRTUAL_TIME environment variable is set).                 */
+/*     Serial input can be paced to a link rate (NATIVE_SERIAL_BAUDS environment variable, 10    */
+/*     bits per byte), and also stopped while the firmware has sent XOFF until it sends XON      */
+/*     (NATIVE_SERIAL_XONXOFF), as a host writing to a serial port would be. A paced input can   */
+/*     also lose the bytes received while the buffer is full (NATIVE_SERIAL_LOSSY), as a UART    */
+/*     link without USB flow control would.                                                       */
+/*     Serial bauds can also be negotiated by the firmware up to NATIVE_SERIAL_BAUDS_MAX (0 by    */
+/*     default, as USB Serial bauds can't be changed), and a paced input follows them.            */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "Arduino.h"
+#include "NativeHID.h"
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Time without Serial input nor HID output to exit once stdin has been closed (ms)
+#ifndef NATIVE_EXIT_IDLE_MS
+    #define NATIVE_EXIT_IDLE_MS 3000
+#endif
+
+// Sleep time between loop() calls to not use a full host CPU (us), also the virtual clock step
+#ifndef NATIVE_LOOP_SLEEP_US
+    #define NATIVE_LOOP_SLEEP_US 50
+#endif
+
+// Serial input link flow control characters
+#define NATIVE_XON 0x11
+#define NATIVE_XOFF 0x13
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+NativeSerial Serial;
+
+// Time of last Serial input or HID output activity
+static uint32_t last_activity_ms = 0;
+
+// Virtual clock, used instead of the host one so time is the same in each run of a script
+// (deterministic HID reports timestamps)
+static bool virtual_time = (getenv("NATIVE_VIRTUAL_TIME") != NULL);
+static uint64_t virtual_us = 0;
+
+// loop() has already waited for next event (idle sleep), so no sleep is needed after it
+static bool idle_waited = false;
+
+// Idle sleeps hook (NULL if not used)
+static t_native_idle_hook idle_hook = NULL;
+
+/**************************************************************************************************/
+
+/* Time Functions */
+
+static uint64_t monotonic_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static uint64_t start_us = monotonic_us();
+
+static uint64_t elapsed_us(void)
+{
+    if(virtual_time)
+        return virtual_us;
+    return monotonic_us() - start_us;
+}
+
+uint32_t micros(void)
+{
+    return (uint32_t)elapsed_us();
+}
+
+uint32_t millis(void)
+{
+    return (uint32_t)(elapsed_us() / 1000);
+}
+
+void delay(uint32_t ms)
+{
+    delayMicroseconds(ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    if(virtual_time)
+        virtual_us = virtual_us + us;
+    else
+        usleep(us);
+}
+
+// Wait until Serial input is received or next millis() tick
+// With the virtual clock (or once stdin is closed) there is no input to wait for, and a paced
+// input is received at its own rate. Input already received doesn't end the wait, as it doesn't
+// raise another interrupt (the firmware only sleeps with it while it can't take it)
+void native_idle_wait(void)
+{
+    uint32_t tick_us = 1000 - (uint32_t)(elapsed_us() % 1000);
+    struct pollfd fds = { STDIN_FILENO, POLLIN, 0 };
+    struct timespec timeout = { 0, (long)tick_us * 1000 };
+
+    if(idle_hook != NULL)
+        idle_hook(micros());
+    idle_waited = true;
+    if(virtual_time || Serial.closed() || Serial.paced())
+    {
+        delayMicroseconds(tick_us);
+        return;
+    }
+    ppoll(&fds, 1, &timeout, NULL);
+}
+
+// Set the idle sleeps hook (NULL if not used)
+void native_set_idle_hook(t_native_idle_hook hook)
+{
+    idle_hook = hook;
+}
+
+// Use the virtual clock (as NATIVE_VIRTUAL_TIME environment variable does), from time 0
+void native_virtual_time(void)
+{
+    virtual_time = true;
+    virtual_us = 0;
+}
+
+/**************************************************************************************************/
+
+/* Print Functions */
+
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+    size_t n = 0;
+    while(size--)
+        n = n + write(*buffer++);
+    return n;
+}
+
+size_t Print::write(const char* buffer, size_t size)
+{
+    return write((const uint8_t*)buffer, size);
+}
+
+size_t Print::print(const char* str)
+{
+    return write((const uint8_t*)str, strlen(str));
+}
+
+size_t Print::print(const __FlashStringHelper* str)
+{
+    return print((const char*)str);
+}
+
+size_t Print::print(char c)
+{
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    char str[16];
+    snprintf(str, sizeof(str), (base == HEX) ? "%lX" : "%lu", n);
+    return print(str);
+}
+
+size_t Print::print(long n, int base)
+{
+    char str[16];
+    if(base != DEC)
+        return print((unsigned long)n, base);
+    snprintf(str, sizeof(str), "%ld", n);
+    return print(str);
+}
+
+size_t Print::print(unsigned int n, int base)
+{
+    return print((unsigned long)n, base);
+}
+
+size_t Print::print(int n, int base)
+{
+    return print((long)n, base);
+}
+
+size_t Print::print(unsigned char n, int base)
+{
+    return print((unsigned long)n, base);
+}
+
+size_t Print::println(void)
+{
+    return print("\r\n");
+}
+
+/**************************************************************************************************/
+
+/* Native Serial Functions */
+
+// Start the Serial port
+// First bauds are the link nominal ones (paced at NATIVE_SERIAL_BAUDS), other bauds have been
+// negotiated by the firmware and the host sends at them too, until the first ones are restored
+void NativeSerial::begin(unsigned long bauds)
+{
+    const char* env_bauds = getenv("NATIVE_SERIAL_BAUDS");
+    const char* env_bauds_max = getenv("NATIVE_SERIAL_BAUDS_MAX");
+
+    fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+
+    // Input link rate (start bit, 8 data bits and stop bit per byte)
+    if((env_bauds != NULL) && (strtoul(env_bauds, NULL, 10) > 0))
+        byte_us = 10000000UL / strtoul(env_bauds, NULL, 10);
+    xonxoff = (getenv("NATIVE_SERIAL_XONXOFF") != NULL);
+    lossy = paced() && (getenv("NATIVE_SERIAL_LOSSY") != NULL);
+    next_byte_us = micros();
+    link_bauds_max = (env_bauds_max != NULL) ? strtoul(env_bauds_max, NULL, 10) : 0;
+
+    // Negotiated bauds
+    if(link_bauds_first == 0)
+        link_bauds_first = bauds;
+    else if(bauds != link_bauds)
+    {
+        link_changes = link_changes + 1;
+        link_change_us = micros();
+        link_change_output = output_len;
+    }
+    link_bauds = bauds;
+    if(paced() && (bauds != link_bauds_first))
+        byte_us = 10000000UL / bauds;
+}
+
+// Read stdin into the reception buffer
+// A paced input byte is received once the link has had time to send it. While the buffer is full
+// the link is stopped (USB flow control), so it doesn't send a burst of bytes once there is space,
+// unless the link is lossy and the bytes it sends meanwhile are lost
+void NativeSerial::fill(void)
+{
+    ssize_t n = 0;
+    uint8_t byte = 0;
+    uint32_t now = micros();
+
+    if(paced() && (((count == sizeof(buffer)) && !lossy) || stopped) &&
+       ((int32_t)(now - next_byte_us) > 0))
+        next_byte_us = now;
+
+    while(!eof && ((count < sizeof(buffer)) || lossy) && !stopped)
+    {
+        if(paced() && ((int32_t)(now - next_byte_us) < 0))
+            break;
+
+        n = ::read(STDIN_FILENO, &byte, 1);
+        if(n == 1)
+        {
+            if(count < sizeof(buffer))
+            {
+                buffer[(head + count) % sizeof(buffer)] = byte;
+                count = count + 1;
+            }
+            else
+                lost = lost + 1;
+            next_byte_us = next_byte_us + byte_us;
+            last_activity_ms = millis();
+            continue;
+        }
+        if((n == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK)))
+        {
+            eof = true;
+            eof_us = now;
+        }
+        break;
+    }
+}
+
+int NativeSerial::available(void)
+{
+    fill();
+    return count;
+}
+
+int NativeSerial::read(void)
+{
+    int byte = 0;
+
+    fill();
+    if(count == 0)
+        return -1;
+    byte = buffer[head];
+    head = (head + 1) % sizeof(buffer);
+    count = count - 1;
+    return byte;
+}
+
+int NativeSerial::peek(void)
+{
+    fill();
+    if(count == 0)
+        return -1;
+    return buffer[head];
+}
+
+size_t NativeSerial::write(uint8_t byte)
+{
+    return write(&byte, 1);
+}
+
+size_t NativeSerial::write(const uint8_t* buffer, size_t size)
+{
+    // Input link flow control
+    for(size_t i = 0; xonxoff && (i < size); i++)
+    {
+        if(buffer[i] == NATIVE_XOFF)
+            stopped = true;
+        else if(buffer[i] == NATIVE_XON)
+            stopped = false;
+    }
+
+    output_len = output_len + size;
+    return ::write(STDOUT_FILENO, buffer, size);
+}
+
+uint16_t NativeSerial::overflow(void)
+{
+    uint16_t lost_bytes = 0;
+
+    fill();
+    lost_bytes = lost;
+    lost = 0;
+    return lost_bytes;
+}
+
+bool NativeSerial::closed(void)
+{
+    fill();
+    return (eof && (count == 0));
+}
+
+/**************************************************************************************************/
+
+/* Main Functions */
+
+// Run the firmware until Serial input is closed and there is nothing else to do
+int native_main(void)
+{
+    uint32_t reports = 0;
+
+    setup();
+
+    while(true)
+    {
+        loop();
+
+        // Exit once there is nothing else to do
+        if(native_hid_reports() != reports)
+        {
+            reports = native_hid_reports();
+            last_activity_ms = millis();
+        }
+        if(Serial.closed() && ((millis() - last_activity_ms) > NATIVE_EXIT_IDLE_MS))
+            break;
+
+        if(!idle_waited)
+            delayMicroseconds(NATIVE_LOOP_SLEEP_US);
+        idle_waited = false;
+    }
+
+    native_hid_summary();
+
+    return 0;
+}
+
+// Program entry point, weak so a test program can have its own one (and run the firmware with
+// native_main())
+__attribute__((weak)) int main(void)
+{
+    return native_main();
+}
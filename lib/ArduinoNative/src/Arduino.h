@@ -0,0 +1,200 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     Arduino.h                                                                                  */
+/* Description:                                                                                   */
+/*     Minimal Arduino API to build the firmware on the host (native). Serial is mapped to        */
+/*     stdin/stdout and time to the host monotonic clock.                                         */
+/*     Serial input can be paced to a link rate (NATIVE_SERIAL_BAUDS environment variable, 10    */
+/*     bits per byte), and also stopped while the firmware has sent XOFF until it sends XON      */
+/*     (NATIVE_SERIAL_XONXOFF), as a host writing to a serial port would be. A paced input can   */
+/*     also lose the bytes received while the buffer is full (NATIVE_SERIAL_LOSSY), as a UART    */
+/*     link without USB flow control would.                                                       */
+/*     Serial bauds can also be negotiated by the firmware up to NATIVE_SERIAL_BAUDS_MAX (0 by    */
+/*     default, as USB Serial bauds can't be changed), and a paced input follows them.            */
+/**************************************************************************************************/
+
+#ifndef ARDUINO_NATIVE_H_
+#define ARDUINO_NATIVE_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Program memory (flash) access, on the host everything is in RAM
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define memcpy_P memcpy
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strlen_P strlen
+
+// Same hardware Serial reception buffer size than the atmega32u4 core
+#ifndef SERIAL_RX_BUFFER_SIZE
+    #define SERIAL_RX_BUFFER_SIZE 64
+#endif
+
+// Print numbers base
+#define DEC 10
+#define HEX 16
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Flash strings (just plain strings on the host)
+class __FlashStringHelper;
+
+// Idle sleep hook (sleep start timestamp)
+typedef void (*t_native_idle_hook)(const uint32_t us);
+
+// Print interface
+class Print
+{
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t byte) = 0;
+        virtual size_t write(const uint8_t* buffer, size_t size);
+        size_t write(const char* buffer, size_t size);
+        size_t print(const char* str);
+        size_t print(const __FlashStringHelper* str);
+        size_t print(char c);
+        size_t print(unsigned long n, int base=DEC);
+        size_t print(long n, int base=DEC);
+        size_t print(unsigned int n, int base=DEC);
+        size_t print(int n, int base=DEC);
+        size_t print(unsigned char n, int base=DEC);
+        size_t println(void);
+        template<typename T> size_t println(T value)
+        { size_t n = print(value); return n + println(); }
+        template<typename T> size_t println(T value, int base)
+        { size_t n = print(value, base); return n + println(); }
+};
+
+// Stream interface
+class Stream : public Print
+{
+    public:
+        virtual int available(void) = 0;
+        virtual int read(void) = 0;
+        virtual int peek(void) = 0;
+        virtual int availableForWrite(void) { return 64; }
+        virtual void flush(void) {}
+        using Print::write;
+};
+
+// USB CDC Serial mapped to stdin/stdout
+class NativeSerial : public Stream
+{
+    public:
+        void begin(unsigned long bauds);
+        void end(void) {}
+        int available(void);
+        int read(void);
+        int peek(void);
+        size_t write(uint8_t byte);
+        size_t write(const uint8_t* buffer, size_t size);
+        operator bool(void) { return true; }
+        using Print::write;
+
+        // Check if stdin has been closed (and all its data read)
+        bool closed(void);
+
+        // Get the time when stdin was found closed (us)
+        uint32_t closed_us(void) { return eof_us; }
+
+        // Check if input is paced to a link rate
+        bool paced(void) { return (byte_us > 0); }
+
+        // Get the number of input bytes lost since last call (lossy link)
+        uint16_t overflow(void);
+
+        // Get the maximum bauds the firmware can negotiate (0 if they can't be changed)
+        uint32_t bauds_max(void) { return link_bauds_max; }
+
+        // Get the current link bauds and the number of times they have been changed
+        uint32_t bauds(void) { return link_bauds; }
+        uint32_t bauds_changes(void) { return link_changes; }
+
+        // Get the time of the last link bauds change (us) and the output written until then
+        uint32_t bauds_change_us(void) { return link_change_us; }
+        size_t bauds_change_output(void) { return link_change_output; }
+
+    private:
+        void fill(void);
+        uint8_t buffer[SERIAL_RX_BUFFER_SIZE];
+        uint16_t head = 0;
+        uint16_t count = 0;
+        bool eof = false;
+        uint32_t eof_us = 0;
+        uint32_t byte_us = 0;       // Input link time of a byte (0 if input is not paced)
+        uint32_t next_byte_us = 0;  // Input link time when next byte is received
+        bool xonxoff = false;       // Input link is stopped by XOFF
+        bool stopped = false;       // XOFF has been sent
+        bool lossy = false;         // Bytes received while the buffer is full are lost
+        uint16_t lost = 0;          // Bytes lost since last overflow check
+        size_t output_len = 0;      // Bytes written to stdout
+        uint32_t link_bauds_max = 0;    // Maximum negotiated bauds (0 if they can't be changed)
+        uint32_t link_bauds_first = 0;  // Bauds of the first begin() (the link nominal ones)
+        uint32_t link_bauds = 0;        // Current bauds
+        uint32_t link_changes = 0;      // Number of bauds changes
+        uint32_t link_change_us = 0;    // Time of the last bauds change
+        size_t link_change_output = 0;  // Bytes written to stdout before the last bauds change
+};
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+extern NativeSerial Serial;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Time since program start
+uint32_t millis(void);
+uint32_t micros(void);
+
+// Blocking waits
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// Interrupts (there are none on the host)
+inline void noInterrupts(void) {}
+inline void interrupts(void) {}
+
+// Wait until Serial input is received or next millis() tick, as an idle sleep MCU is woken up by
+// reception or Timer0 interrupts
+void native_idle_wait(void);
+
+// Set the idle sleeps hook (NULL if not used)
+void native_set_idle_hook(t_native_idle_hook hook);
+
+// Use the virtual clock (as NATIVE_VIRTUAL_TIME environment variable does), from time 0
+void native_virtual_time(void);
+
+// Run the firmware until Serial input is closed and there is nothing else to do
+int native_main(void);
+
+// Firmware entry points
+void setup(void);
+void loop(void);
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,101 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     EEPROM.cpp                                                                                 */
+/* Description:                                                                                   */
+/*     Native (host) mock of the Arduino EEPROM library. The emulated EEPROM is kept in memory    */
+/*     and, if NATIVE_EEPROM environment variable sets a file path, loaded from and saved to it.  */
+/*     A byte write takes the atmega32u4 write time, accessing the EEPROM meanwhile waits for it. */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "EEPROM.h"
+#include <stdlib.h>
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+EEPROMClass EEPROM;
+
+/**************************************************************************************************/
+
+/* EEPROM Mock Functions */
+
+uint8_t EEPROMClass::read(int address)
+{
+    load();
+    wait();
+    if((address < 0) || (address >= NATIVE_EEPROM_SIZE))
+        return 0xFF;
+    return data[address];
+}
+
+void EEPROMClass::write(int address, uint8_t value)
+{
+    load();
+    wait();
+    if((address < 0) || (address >= NATIVE_EEPROM_SIZE))
+        return;
+    data[address] = value;
+    save();
+    write_end_us = micros() + NATIVE_EEPROM_WRITE_US;
+    writing = true;
+}
+
+void EEPROMClass::update(int address, uint8_t value)
+{
+    if(read(address) != value)
+        write(address, value);
+}
+
+// Check if there is no write in progress
+bool EEPROMClass::ready(void)
+{
+    if(writing && ((int32_t)(micros() - write_end_us) >= 0))
+        writing = false;
+    return !writing;
+}
+
+// Wait for the write in progress to end (the CPU is blocked meanwhile, as in avr-libc)
+void EEPROMClass::wait(void)
+{
+    if(!ready())
+        delayMicroseconds(write_end_us - micros());
+    writing = false;
+}
+
+// Load EEPROM file content on first access (an erased EEPROM has all bytes set to 0xFF)
+void EEPROMClass::load(void)
+{
+    const char* path = getenv("NATIVE_EEPROM");
+    FILE* file = NULL;
+
+    if(loaded)
+        return;
+    loaded = true;
+
+    memset(data, 0xFF, sizeof(data));
+    if(path == NULL)
+        return;
+    file = fopen(path, "rb");
+    if(file == NULL)
+        return;
+    if(fread(data, 1, sizeof(data), file) == 0)
+        fprintf(stderr, "EEPROM file %s is empty\n", path);
+    fclose(file);
+}
+
+void EEPROMClass::save(void)
+{
+    const char* path = getenv("NATIVE_EEPROM");
+    FILE* file = NULL;
+
+    if(path == NULL)
+        return;
+    file = fopen(path, "wb");
+    if(file == NULL)
+        return;
+    fwrite(data, 1, sizeof(data), file);
+    fclose(file);
+}
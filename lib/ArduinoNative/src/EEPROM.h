@@ -0,0 +1,79 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     EEPROM.h                                                                                   */
+/* Description:                                                                                   */
+/*     Native (host) mock of the Arduino EEPROM library. The emulated EEPROM is kept in memory    */
+/*     and, if NATIVE_EEPROM environment variable sets a file path, loaded from and saved to it.  */
+/*     A byte write takes the atmega32u4 write time, accessing the EEPROM meanwhile waits for it. */
+/**************************************************************************************************/
+
+#ifndef EEPROM_NATIVE_H_
+#define EEPROM_NATIVE_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "Arduino.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Emulated EEPROM size (atmega32u4)
+#define NATIVE_EEPROM_SIZE 1024
+
+// Byte write time (us), a write runs in the background and next EEPROM access waits for it
+#ifndef NATIVE_EEPROM_WRITE_US
+    #define NATIVE_EEPROM_WRITE_US 3300
+#endif
+
+// Last EEPROM address
+#ifndef E2END
+    #define E2END (NATIVE_EEPROM_SIZE - 1)
+#endif
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+class EEPROMClass
+{
+    public:
+        uint8_t read(int address);
+        void write(int address, uint8_t value);
+        void update(int address, uint8_t value);
+        uint16_t length(void) { return NATIVE_EEPROM_SIZE; }
+
+        // Load the EEPROM again on next access (i.e. once NATIVE_EEPROM has been changed)
+        void reload(void) { loaded = false; writing = false; }
+
+        // Check if there is no write in progress
+        bool ready(void);
+
+    private:
+        void load(void);
+        void save(void);
+        void wait(void);
+        bool loaded = false;
+        uint32_t write_end_us = 0;
+        bool writing = false;
+        uint8_t data[NATIVE_EEPROM_SIZE];
+};
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+extern EEPROMClass EEPROM;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Check if the EEPROM can be accessed without waiting for a write (avr/eeprom.h)
+inline bool eeprom_is_ready(void) { return EEPROM.ready(); }
+
+/**************************************************************************************************/
+
+#endif
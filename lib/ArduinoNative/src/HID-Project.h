@@ -0,0 +1,13 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     HID-Project.h                                                                              */
+/* Description:                                                                                   */
+/*     Native (host) mock of the HID-Project library Keyboard.                                    */
+/**************************************************************************************************/
+
+#ifndef HID_PROJECT_NATIVE_H_
+#define HID_PROJECT_NATIVE_H_
+
+#include "NativeHID.h"
+
+#endif
@@ -0,0 +1,394 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     NativeHID.cpp                                                                              */
+/* Description:                                                                                   */
+/*     Native (host) mock of the HID-Project library Keyboard. Every sent report is recorded in   */
+/*     stderr with its timestamp: "HID <us> <modifiers> <key1> ... <key6>", and also in the trace */
+/*     file set by NATIVE_HID_TRACE environment variable (if any). A test program can get the    */
+/*     reports through a hook instead of stderr.                                                  */
+/*     A host that needs NATIVE_HOST_REPORT_US to process each report can be simulated: reports   */
+/*     wait in a NATIVE_HOST_QUEUE reports queue (lost if it is full) and lock keys toggle the    */
+/*     keyboard LEDs once they are processed.                                                     */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "NativeHID.h"
+#include <stdlib.h>
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// ASCII map shift flag
+#define SHIFT 0x80
+
+// Left Shift modifier key code
+#define KEY_LEFT_SHIFT 0xE1
+
+// Lock keys codes
+#define KEY_NUM_LOCK 0x53
+#define KEY_CAPS_LOCK 0x39
+#define KEY_SCROLL_LOCK 0x47
+
+// Keyboard LEDs bits
+#define LED_NUM_LOCK 0x01
+#define LED_CAPS_LOCK 0x02
+#define LED_SCROLL_LOCK 0x04
+
+// Default simulated host reports queue size
+#define HOST_QUEUE_DEFAULT 32
+
+// Maximum simulated host reports queue size
+#define HOST_QUEUE_MAX 256
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// US layout ASCII to key code map (same as HID-Project library one)
+static const uint8_t ASCII_MAP[128] =
+{
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                         // NUL - BEL
+    0x2A, 0x2B, 0x28, 0x00, 0x00, 0x00, 0x00, 0x00,                         // BS TAB LF ...
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x29, 0x00, 0x00, 0x00, 0x00,                         // ... ESC ...
+    0x2C, 0x1E|SHIFT, 0x34|SHIFT, 0x20|SHIFT,                               // ' ' ! " #
+    0x21|SHIFT, 0x22|SHIFT, 0x24|SHIFT, 0x34,                               // $ % & '
+    0x26|SHIFT, 0x27|SHIFT, 0x25|SHIFT, 0x2E|SHIFT,                         // ( ) * +
+    0x36, 0x2D, 0x37, 0x38,                                                 // , - . /
+    0x27, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26,             // 0 - 9
+    0x33|SHIFT, 0x33, 0x36|SHIFT, 0x2E, 0x37|SHIFT, 0x38|SHIFT, 0x1F|SHIFT, // : ; < = > ? @
+    0x04|SHIFT, 0x05|SHIFT, 0x06|SHIFT, 0x07|SHIFT, 0x08|SHIFT, 0x09|SHIFT, // A - F
+    0x0A|SHIFT, 0x0B|SHIFT, 0x0C|SHIFT, 0x0D|SHIFT, 0x0E|SHIFT, 0x0F|SHIFT, // G - L
+    0x10|SHIFT, 0x11|SHIFT, 0x12|SHIFT, 0x13|SHIFT, 0x14|SHIFT, 0x15|SHIFT, // M - R
+    0x16|SHIFT, 0x17|SHIFT, 0x18|SHIFT, 0x19|SHIFT, 0x1A|SHIFT, 0x1B|SHIFT, // S - X
+    0x1C|SHIFT, 0x1D|SHIFT,                                                 // Y Z
+    0x2F, 0x31, 0x30, 0x23|SHIFT, 0x2D|SHIFT, 0x35,                         // [ \ ] ^ _ `
+    0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, // a - l
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, // m - x
+    0x1C, 0x1D,                                                             // y z
+    0x2F|SHIFT, 0x31|SHIFT, 0x30|SHIFT, 0x35|SHIFT, 0x00                    // { | } ~ DEL
+};
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+NativeKeyboard Keyboard;
+
+// Number of sent HID reports
+static uint32_t reports_sent = 0;
+
+// Host keyboard LEDs state
+static uint8_t host_leds = 0;
+
+// First and last sent report times (us)
+static uint32_t first_report_us = 0;
+static uint32_t last_report_us = 0;
+
+// Reports trace file (NULL if not used)
+static FILE* trace = NULL;
+
+// Sent reports hook (NULL if not used)
+static t_native_hid_hook report_hook = NULL;
+
+// Simulated host (reports waiting to be processed and last processed one)
+static const char* host_report_env = getenv("NATIVE_HOST_REPORT_US");
+static uint32_t host_report_us = (host_report_env != NULL) ? strtoul(host_report_env, NULL, 10) : 0;
+static t_native_hid_report host_queue[HOST_QUEUE_MAX];
+static uint32_t host_queue_arrival[HOST_QUEUE_MAX];
+static uint16_t host_queue_head = 0;
+static uint16_t host_queue_count = 0;
+static uint16_t host_queue_size = 0;
+static uint32_t host_free_us = 0;
+static t_native_hid_report host_last_report;
+static uint32_t host_lost_reports = 0;
+
+/**************************************************************************************************/
+
+/* Simulated Host Functions */
+
+// Get the simulated host reports queue size
+static uint16_t host_queue_capacity(void)
+{
+    const char* env = NULL;
+
+    if(host_queue_size == 0)
+    {
+        env = getenv("NATIVE_HOST_QUEUE");
+        host_queue_size = (env != NULL) ? strtoul(env, NULL, 10) : HOST_QUEUE_DEFAULT;
+        if((host_queue_size == 0) || (host_queue_size > HOST_QUEUE_MAX))
+            host_queue_size = HOST_QUEUE_DEFAULT;
+    }
+
+    return host_queue_size;
+}
+
+// Check if a key is pressed in a report
+static bool report_has_key(const t_native_hid_report* report, const uint8_t key)
+{
+    for(uint8_t i = 0; i < 6; i++)
+    {
+        if(report->keys[i] == key)
+            return true;
+    }
+    return false;
+}
+
+// Process a report in the host, newly pressed lock keys toggle their LEDs
+static void host_process(const t_native_hid_report* report)
+{
+    if(report_has_key(report, KEY_NUM_LOCK) && !report_has_key(&host_last_report, KEY_NUM_LOCK))
+        host_leds = host_leds ^ LED_NUM_LOCK;
+    if(report_has_key(report, KEY_CAPS_LOCK) && !report_has_key(&host_last_report, KEY_CAPS_LOCK))
+        host_leds = host_leds ^ LED_CAPS_LOCK;
+    if(report_has_key(report, KEY_SCROLL_LOCK) &&
+       !report_has_key(&host_last_report, KEY_SCROLL_LOCK))
+        host_leds = host_leds ^ LED_SCROLL_LOCK;
+    host_last_report = *report;
+}
+
+// Process the queued reports that the host has had time to process
+static void host_update(void)
+{
+    uint32_t now = micros();
+    uint32_t start = 0;
+
+    while(host_queue_count > 0)
+    {
+        start = host_queue_arrival[host_queue_head];
+        if((int32_t)(host_free_us - start) > 0)
+            start = host_free_us;
+        if((int32_t)(now - (start + host_report_us)) < 0)
+            break;
+
+        host_process(&(host_queue[host_queue_head]));
+        host_free_us = start + host_report_us;
+        host_queue_head = (host_queue_head + 1) % HOST_QUEUE_MAX;
+        host_queue_count = host_queue_count - 1;
+    }
+}
+
+// Send a report to the host, it is lost if the host queue is full
+static void host_send(const t_native_hid_report* report)
+{
+    uint16_t tail = 0;
+
+    host_update();
+    if(host_queue_count >= host_queue_capacity())
+    {
+        host_lost_reports = host_lost_reports + 1;
+        return;
+    }
+
+    tail = (host_queue_head + host_queue_count) % HOST_QUEUE_MAX;
+    host_queue[tail] = *report;
+    host_queue_arrival[tail] = micros();
+    host_queue_count = host_queue_count + 1;
+    host_update();
+}
+
+/**************************************************************************************************/
+
+/* Keyboard Mock Functions */
+
+size_t NativeKeyboard::add(KeyboardKeycode key)
+{
+    // Modifiers
+    if((key >= 0xE0) && (key <= 0xE7))
+    {
+        report.modifiers = report.modifiers | (1 << (key - 0xE0));
+        return 1;
+    }
+
+    // Already pressed
+    for(uint8_t i = 0; i < 6; i++)
+    {
+        if(report.keys[i] == key)
+            return 1;
+    }
+
+    for(uint8_t i = 0; i < 6; i++)
+    {
+        if(report.keys[i] == 0)
+        {
+            report.keys[i] = key;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+size_t NativeKeyboard::remove(KeyboardKeycode key)
+{
+    if((key >= 0xE0) && (key <= 0xE7))
+    {
+        report.modifiers = report.modifiers & ~(1 << (key - 0xE0));
+        return 1;
+    }
+
+    for(uint8_t i = 0; i < 6; i++)
+    {
+        if(report.keys[i] == key)
+        {
+            report.keys[i] = 0;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int NativeKeyboard::send(void)
+{
+    last_report_us = micros();
+    if(reports_sent == 0)
+        first_report_us = last_report_us;
+    reports_sent = reports_sent + 1;
+
+    if(report_hook != NULL)
+        report_hook(&report, last_report_us);
+    else
+    {
+        fprintf(stderr, "HID %u %02X %02X %02X %02X %02X %02X %02X\n", last_report_us,
+            report.modifiers, report.keys[0], report.keys[1], report.keys[2], report.keys[3],
+            report.keys[4], report.keys[5]);
+    }
+
+    // Open trace file on first report
+    if((reports_sent == 1) && (getenv("NATIVE_HID_TRACE") != NULL))
+        trace = fopen(getenv("NATIVE_HID_TRACE"), "w");
+    if(trace != NULL)
+    {
+        fprintf(trace, "HID %u %02X %02X %02X %02X %02X %02X %02X\n", last_report_us,
+            report.modifiers, report.keys[0], report.keys[1], report.keys[2], report.keys[3],
+            report.keys[4], report.keys[5]);
+    }
+
+    host_send(&report);
+
+    return 0;
+}
+
+size_t NativeKeyboard::press(KeyboardKeycode key)
+{
+    size_t n = add(key);
+    if(n)
+        send();
+    return n;
+}
+
+size_t NativeKeyboard::release(KeyboardKeycode key)
+{
+    size_t n = remove(key);
+    if(n)
+        send();
+    return n;
+}
+
+size_t NativeKeyboard::press(uint8_t ascii)
+{
+    uint8_t key = 0;
+
+    if(ascii >= sizeof(ASCII_MAP))
+        return 0;
+    key = ASCII_MAP[ascii];
+    if(key == 0)
+        return 0;
+
+    if(key & SHIFT)
+        add(KeyboardKeycode(KEY_LEFT_SHIFT));
+    add(KeyboardKeycode(key & ~SHIFT));
+    send();
+
+    return 1;
+}
+
+size_t NativeKeyboard::release(uint8_t ascii)
+{
+    uint8_t key = 0;
+
+    if(ascii >= sizeof(ASCII_MAP))
+        return 0;
+    key = ASCII_MAP[ascii];
+    if(key == 0)
+        return 0;
+
+    if(key & SHIFT)
+        remove(KeyboardKeycode(KEY_LEFT_SHIFT));
+    remove(KeyboardKeycode(key & ~SHIFT));
+    send();
+
+    return 1;
+}
+
+size_t NativeKeyboard::releaseAll(void)
+{
+    memset(&report, 0, sizeof(report));
+    send();
+    return 1;
+}
+
+size_t NativeKeyboard::write(KeyboardKeycode key)
+{
+    size_t n = press(key);
+    release(key);
+    return n;
+}
+
+size_t NativeKeyboard::write(uint8_t ascii)
+{
+    size_t n = press(ascii);
+    release(ascii);
+    return n;
+}
+
+uint8_t NativeKeyboard::getLeds(void)
+{
+    host_update();
+    return host_leds;
+}
+
+/**************************************************************************************************/
+
+/* Native HID Functions */
+
+// Get the number of HID reports sent
+uint32_t native_hid_reports(void)
+{
+    return reports_sent;
+}
+
+// Set host keyboard LEDs state (as an output report from the host would do)
+void native_hid_set_leds(const uint8_t leds)
+{
+    host_leds = leds;
+}
+
+// Set the simulated host time to process each report (us, 0 for a host that processes them as
+// they are sent), instead of NATIVE_HOST_REPORT_US
+void native_hid_set_host(const uint32_t report_us)
+{
+    host_update();
+    host_report_us = report_us;
+}
+
+// Write HID output summary to stderr
+void native_hid_summary(void)
+{
+    fprintf(stderr, "HID reports: %u\n", reports_sent);
+    fprintf(stderr, "HID output time: %u us\n", last_report_us - first_report_us);
+    if(host_report_us != 0)
+        fprintf(stderr, "HID lost reports: %u\n", host_lost_reports);
+
+    if(trace != NULL)
+        fclose(trace);
+}
+
+// Set the sent reports hook (NULL to record them in stderr)
+void native_hid_set_hook(t_native_hid_hook hook)
+{
+    report_hook = hook;
+}
@@ -0,0 +1,92 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     NativeHID.h                                                                                */
+/* Description:                                                                                   */
+/*     Native (host) mock of the HID-Project library Keyboard. Every sent report is recorded in   */
+/*     stderr with its timestamp: "HID <us> <modifiers> <key1> ... <key6>", and also in the trace */
+/*     file set by NATIVE_HID_TRACE environment variable (if any). A test program can get the    */
+/*     reports through a hook instead of stderr.                                                  */
+/**************************************************************************************************/
+
+#ifndef NATIVEHID_H_
+#define NATIVEHID_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "Arduino.h"
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Raw USB-HID keyboard key codes (HID-Project names are not needed by the firmware)
+enum KeyboardKeycode : uint8_t
+{
+    KEY_RESERVED = 0
+};
+
+// Boot keyboard report
+typedef struct
+{
+    uint8_t modifiers;
+    uint8_t reserved;
+    uint8_t keys[6];
+} t_native_hid_report;
+
+// Sent report hook (report and its timestamp)
+typedef void (*t_native_hid_hook)(const t_native_hid_report* report, const uint32_t us);
+
+// Keyboard mock with HID-Project API
+class NativeKeyboard : public Print
+{
+    public:
+        void begin(void) {}
+        void end(void) {}
+        size_t add(KeyboardKeycode key);
+        size_t remove(KeyboardKeycode key);
+        int send(void);
+        size_t press(KeyboardKeycode key);
+        size_t release(KeyboardKeycode key);
+        size_t press(uint8_t ascii);
+        size_t release(uint8_t ascii);
+        size_t releaseAll(void);
+        size_t write(KeyboardKeycode key);
+        size_t write(uint8_t ascii);
+        uint8_t getLeds(void);
+        using Print::write;
+
+    private:
+        t_native_hid_report report;
+};
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+extern NativeKeyboard Keyboard;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Get the number of HID reports sent
+uint32_t native_hid_reports(void);
+
+// Set host keyboard LEDs state (as an output report from the host would do)
+void native_hid_set_leds(const uint8_t leds);
+
+// Set the simulated host time to process each report (us, 0 for a host that processes them as
+// they are sent), instead of NATIVE_HOST_REPORT_US
+void native_hid_set_host(const uint32_t report_us);
+
+// Write HID output summary to stderr
+void native_hid_summary(void);
+
+// Set the sent reports hook (NULL to record them in stderr)
+void native_hid_set_hook(t_native_hid_hook hook);
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,282 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     NativeRun.cpp                                                                              */
+/* Description:                                                                                   */
+/*     Run the firmware from a test program. Each run is a child process with the virtual clock, */
+/*     that reads the given Serial input and returns the sent HID reports, the Serial output and  */
+/*     the idle sleeps times.                                                                     */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "NativeRun.h"
+#include "EEPROM.h"
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Run results shared by the child process
+typedef struct
+{
+    uint32_t reports_n;
+    uint32_t input_closed_us;
+    uint32_t end_us;
+    uint64_t start_ns;
+    uint64_t host_ns;
+    uint32_t bauds;
+    uint32_t bauds_changes;
+    uint32_t bauds_change_us;
+    size_t bauds_change_output;
+    t_native_run_report reports[NATIVE_RUN_MAX_REPORTS];
+    uint32_t sleeps_n;
+    uint32_t sleeps_us[NATIVE_RUN_MAX_SLEEPS];
+} t_native_run_shared;
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+// Results of the current run (written by the child process)
+static t_native_run_shared* shared = NULL;
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions Prototypes */
+
+// Run the firmware in a child process with a Serial input and output files
+// Returns 0 if the run has finished, or -1 on error
+static int run_process(const t_native_run_options* options, FILE* input, FILE* output);
+
+// Run the firmware in the child process (stdin and stdout are the run input and output)
+static void run_child(const t_native_run_options* options);
+
+// Copy the shared results and the Serial output to the run results
+// Returns 0 on success, or -1 on error
+static int run_results(FILE* output, t_native_run* run);
+
+// Record a sent report in the shared results
+static void run_hook(const t_native_hid_report* report, const uint32_t us);
+
+// Record an idle sleep in the shared results
+static void run_idle_hook(const uint32_t us);
+
+// Set an environment variable to a number, or remove it if the number is 0
+static void run_setenv(const char* name, const uint32_t value);
+
+// Get the host monotonic clock (ns)
+static uint64_t monotonic_ns(void);
+
+/**************************************************************************************************/
+
+/* Native Run Functions */
+
+// Run the firmware with a Serial input until it has nothing else to do
+// Returns 0 if the run has finished, or -1 on error
+int native_run(const t_native_run_options* options, t_native_run* run)
+{
+    FILE* input = tmpfile();
+    FILE* output = tmpfile();
+    int rc = -1;
+
+    memset(run, 0, sizeof(t_native_run));
+    shared = (t_native_run_shared*)mmap(NULL, sizeof(t_native_run_shared),
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(shared == MAP_FAILED)
+        shared = NULL;
+
+    if((input != NULL) && (output != NULL) && (shared != NULL))
+    {
+        memset(shared, 0, sizeof(t_native_run_shared));
+        rc = run_process(options, input, output);
+    }
+    if(rc == 0)
+        rc = run_results(output, run);
+
+    if(input != NULL)
+        fclose(input);
+    if(output != NULL)
+        fclose(output);
+    if(shared != NULL)
+        munmap(shared, sizeof(t_native_run_shared));
+    shared = NULL;
+    if(rc != 0)
+        native_run_free(run);
+
+    return rc;
+}
+
+// Free a run results
+void native_run_free(t_native_run* run)
+{
+    free(run->reports);
+    free(run->sleeps_us);
+    free(run->output);
+    run->reports = NULL;
+    run->sleeps_us = NULL;
+    run->output = NULL;
+}
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Run the firmware in a child process with a Serial input and output files
+// Returns 0 if the run has finished, or -1 on error
+static int run_process(const t_native_run_options* options, FILE* input, FILE* output)
+{
+    pid_t pid = 0;
+    int status = 0;
+
+    if(fwrite(options->input, 1, options->input_len, input) != options->input_len)
+        return -1;
+    fflush(input);
+    rewind(input);
+
+    fflush(stdout);
+    fflush(stderr);
+    pid = fork();
+    if(pid < 0)
+        return -1;
+    if(pid == 0)
+    {
+        dup2(fileno(input), STDIN_FILENO);
+        dup2(fileno(output), STDOUT_FILENO);
+        run_child(options);
+    }
+
+    if((waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+        return -1;
+    return 0;
+}
+
+// Run the firmware in the child process (stdin and stdout are the run input and output)
+// The HID summary written to stderr is discarded, reports are recorded by the hook
+static void run_child(const t_native_run_options* options)
+{
+    int null = open("/dev/null", O_WRONLY);
+
+    if(null >= 0)
+        dup2(null, STDERR_FILENO);
+    if(options->eeprom != NULL)
+        setenv("NATIVE_EEPROM", options->eeprom, 1);
+    else
+        unsetenv("NATIVE_EEPROM");
+    EEPROM.reload();
+    unsetenv("NATIVE_HID_TRACE");
+    run_setenv("NATIVE_SERIAL_BAUDS", options->bauds);
+    run_setenv("NATIVE_SERIAL_XONXOFF", options->xonxoff);
+    run_setenv("NATIVE_SERIAL_LOSSY", options->lossy);
+    run_setenv("NATIVE_SERIAL_BAUDS_MAX", options->bauds_max);
+
+    native_virtual_time();
+    native_hid_set_hook(run_hook);
+    native_set_idle_hook(run_idle_hook);
+    shared->start_ns = monotonic_ns();
+    native_main();
+    shared->input_closed_us = Serial.closed_us();
+    shared->end_us = micros();
+    shared->bauds = Serial.bauds();
+    shared->bauds_changes = Serial.bauds_changes();
+    shared->bauds_change_us = Serial.bauds_change_us();
+    shared->bauds_change_output = Serial.bauds_change_output();
+
+    _exit(0);
+}
+
+// Copy the shared results and the Serial output to the run results
+// Returns 0 on success, or -1 on error
+static int run_results(FILE* output, t_native_run* run)
+{
+    uint32_t kept = shared->reports_n;
+    uint32_t sleeps_kept = shared->sleeps_n;
+    long output_len = 0;
+
+    if(kept > NATIVE_RUN_MAX_REPORTS)
+        kept = NATIVE_RUN_MAX_REPORTS;
+    if(sleeps_kept > NATIVE_RUN_MAX_SLEEPS)
+        sleeps_kept = NATIVE_RUN_MAX_SLEEPS;
+    run->reports_n = shared->reports_n;
+    run->sleeps_n = shared->sleeps_n;
+    run->input_closed_us = shared->input_closed_us;
+    run->end_us = shared->end_us;
+    run->host_ns = shared->host_ns;
+    run->bauds = shared->bauds;
+    run->bauds_changes = shared->bauds_changes;
+    run->bauds_change_us = shared->bauds_change_us;
+    run->bauds_change_output = shared->bauds_change_output;
+
+    // Reports (at least one allocated, so there is always a reports array)
+    run->reports = (t_native_run_report*)malloc(sizeof(t_native_run_report) * (kept + 1));
+    if(run->reports == NULL)
+        return -1;
+    memcpy(run->reports, shared->reports, sizeof(t_native_run_report) * kept);
+
+    // Idle sleeps (at least one allocated too)
+    run->sleeps_us = (uint32_t*)malloc(sizeof(uint32_t) * (sleeps_kept + 1));
+    if(run->sleeps_us == NULL)
+        return -1;
+    memcpy(run->sleeps_us, shared->sleeps_us, sizeof(uint32_t) * sleeps_kept);
+
+    // Serial output (null terminated, to check text replies)
+    fseek(output, 0, SEEK_END);
+    output_len = ftell(output);
+    rewind(output);
+    if(output_len < 0)
+        return -1;
+    run->output = (uint8_t*)malloc(output_len + 1);
+    if(run->output == NULL)
+        return -1;
+    run->output_len = fread(run->output, 1, output_len, output);
+    run->output[run->output_len] = '\0';
+
+    return 0;
+}
+
+// Record a sent report in the shared results
+static void run_hook(const t_native_hid_report* report, const uint32_t us)
+{
+    if(shared->reports_n < NATIVE_RUN_MAX_REPORTS)
+    {
+        shared->reports[shared->reports_n].us = us;
+        shared->reports[shared->reports_n].report = *report;
+    }
+    shared->reports_n = shared->reports_n + 1;
+    shared->host_ns = monotonic_ns() - shared->start_ns;
+}
+
+// Record an idle sleep in the shared results
+static void run_idle_hook(const uint32_t us)
+{
+    if(shared->sleeps_n < NATIVE_RUN_MAX_SLEEPS)
+        shared->sleeps_us[shared->sleeps_n] = us;
+    shared->sleeps_n = shared->sleeps_n + 1;
+}
+
+// Set an environment variable to a number, or remove it if the number is 0
+static void run_setenv(const char* name, const uint32_t value)
+{
+    char text[16];
+
+    if(value == 0)
+    {
+        unsetenv(name);
+        return;
+    }
+    snprintf(text, sizeof(text), "%u", value);
+    setenv(name, text, 1);
+}
+
+// Get the host monotonic clock (ns)
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
@@ -0,0 +1,84 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     NativeRun.h                                                                                */
+/* Description:                                                                                   */
+/*     Run the firmware from a test program. Each run is a child process with the virtual clock, */
+/*     that reads the given Serial input and returns the sent HID reports, the Serial output and  */
+/*     the idle sleeps times.                                                                     */
+/**************************************************************************************************/
+
+#ifndef NATIVERUN_H_
+#define NATIVERUN_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "Arduino.h"
+#include "NativeHID.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Maximum number of HID reports kept from a run
+#define NATIVE_RUN_MAX_REPORTS 65536
+
+// Maximum number of idle sleeps kept from a run
+#define NATIVE_RUN_MAX_SLEEPS 65536
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Run options
+typedef struct
+{
+    const uint8_t* input;   // Serial input
+    size_t input_len;
+    const char* eeprom;     // Emulated EEPROM file (NULL for an erased EEPROM not saved)
+    uint32_t bauds;         // Serial input link rate (0 to not pace it)
+    bool xonxoff;           // Serial input link is stopped by XOFF
+    bool lossy;             // Paced Serial input received while its buffer is full is lost
+    uint32_t bauds_max;     // Serial link maximum negotiated bauds (0 if they can't be changed)
+} t_native_run_options;
+
+// Sent HID report
+typedef struct
+{
+    uint32_t us;
+    t_native_hid_report report;
+} t_native_run_report;
+
+// Run results
+typedef struct
+{
+    t_native_run_report* reports;
+    uint32_t reports_n;     // Number of sent reports (only NATIVE_RUN_MAX_REPORTS are kept)
+    uint32_t* sleeps_us;    // Idle sleeps start times
+    uint32_t sleeps_n;      // Number of idle sleeps (only NATIVE_RUN_MAX_SLEEPS are kept)
+    uint8_t* output;        // Serial output
+    size_t output_len;
+    uint32_t input_closed_us;   // Time when all Serial input was received
+    uint32_t end_us;        // Time when the firmware had nothing else to do
+    uint64_t host_ns;       // Host time from the run start to the last report
+    uint32_t bauds;         // Serial link bauds at the end
+    uint32_t bauds_changes; // Number of Serial link bauds changes
+    uint32_t bauds_change_us;   // Time of the last Serial link bauds change
+    size_t bauds_change_output; // Serial output written before the last bauds change
+} t_native_run;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Run the firmware with a Serial input until it has nothing else to do
+// Returns 0 if the run has finished, or -1 on error
+int native_run(const t_native_run_options* options, t_native_run* run);
+
+// Free a run results
+void native_run_free(t_native_run* run);
+
+/**************************************************************************************************/
+
+#endif
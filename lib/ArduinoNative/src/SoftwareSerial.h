@@ -0,0 +1,40 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     SoftwareSerial.h                                                                           */
+/* Description:                                                                                   */
+/*     Native (host) mock of the SoftwareSerial library (no input, output is discarded).          */
+/**************************************************************************************************/
+
+#ifndef SOFTWARESERIAL_NATIVE_H_
+#define SOFTWARESERIAL_NATIVE_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "Arduino.h"
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+class SoftwareSerial : public Stream
+{
+    public:
+        SoftwareSerial(uint8_t rx_pin, uint8_t tx_pin) {}
+        void begin(long bauds) {}
+        void end(void) {}
+        bool listen(void) { return true; }
+        bool isListening(void) { return true; }
+        bool overflow(void) { return false; }
+        int available(void) { return 0; }
+        int read(void) { return -1; }
+        int peek(void) { return -1; }
+        size_t write(uint8_t byte) { return 1; }
+        operator bool(void) { return true; }
+        using Print::write;
+};
+
+/**************************************************************************************************/
+
+#endif
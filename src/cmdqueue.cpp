@@ -0,0 +1,62 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     cmdqueue.cpp                                                                               */
+/* Description:                                                                                   */
+/*     Fixed capacity queue of compiled commands between line reception and HID execution.       */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <string.h>
+#include "cmdqueue.h"
+
+/**************************************************************************************************/
+
+/* Commands Queue Functions */
+
+// Get the next free queue slot to compile a command into it (NULL if queue is full)
+t_ducky_cmd* cmd_queue_reserve(t_cmd_queue* queue)
+{
+    if(queue->count >= CMD_QUEUE_DEPTH)
+        return NULL;
+    return &(queue->slots[(queue->head + queue->count) % CMD_QUEUE_SLOTS]);
+}
+
+// Add the reserved slot command to the queue
+void cmd_queue_commit(t_cmd_queue* queue)
+{
+    if(queue->count < CMD_QUEUE_DEPTH)
+        queue->count = queue->count + 1;
+}
+
+// Get the oldest queued command without removing it (NULL if queue is empty)
+t_ducky_cmd* cmd_queue_peek(t_cmd_queue* queue)
+{
+    if(queue->count == 0)
+        return NULL;
+    return &(queue->slots[queue->head]);
+}
+
+// Remove the oldest queued command, keeping it as last executed command or not
+// When it is not kept, current last command is moved into its slot (the only copy case)
+void cmd_queue_pop(t_cmd_queue* queue, const bool keep_as_last)
+{
+    if(queue->count == 0)
+        return;
+
+    if(!keep_as_last && queue->has_last)
+        memcpy(&(queue->slots[queue->head]), cmd_queue_last(queue), sizeof(t_ducky_cmd));
+    else if(keep_as_last)
+        queue->has_last = true;
+
+    queue->head = (queue->head + 1) % CMD_QUEUE_SLOTS;
+    queue->count = queue->count - 1;
+}
+
+// Get the last executed command kept (NULL if there is none)
+t_ducky_cmd* cmd_queue_last(t_cmd_queue* queue)
+{
+    if(!queue->has_last)
+        return NULL;
+    return &(queue->slots[(queue->head + CMD_QUEUE_SLOTS - 1) % CMD_QUEUE_SLOTS]);
+}
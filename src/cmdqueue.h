@@ -0,0 +1,66 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     cmdqueue.h                                                                                 */
+/* Description:                                                                                   */
+/*     Fixed capacity queue of compiled commands between line reception and HID execution.       */
+/**************************************************************************************************/
+
+#ifndef CMDQUEUE_H_
+#define CMDQUEUE_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "duckyparser.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Number of compiled commands that can be queued (each one takes sizeof(t_ducky_cmd) of SRAM)
+// Can be tuned at build time through build_flags (i.e. -DCMD_QUEUE_DEPTH=2)
+#ifndef CMD_QUEUE_DEPTH
+    #define CMD_QUEUE_DEPTH 4
+#endif
+
+// Number of queue slots (one extra slot keeps the last executed command for REPEAT)
+#define CMD_QUEUE_SLOTS (CMD_QUEUE_DEPTH + 1)
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Compiled commands queue
+// The slot just before head keeps the last executed command, so it can be replayed without copies
+typedef struct
+{
+    t_ducky_cmd slots[CMD_QUEUE_SLOTS];
+    uint8_t head;   // Oldest queued command
+    uint8_t count;  // Number of queued commands
+    bool has_last;  // The slot before head has a valid last executed command
+} t_cmd_queue;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Get the next free queue slot to compile a command into it (NULL if queue is full)
+t_ducky_cmd* cmd_queue_reserve(t_cmd_queue* queue);
+
+// Add the reserved slot command to the queue
+void cmd_queue_commit(t_cmd_queue* queue);
+
+// Get the oldest queued command without removing it (NULL if queue is empty)
+t_ducky_cmd* cmd_queue_peek(t_cmd_queue* queue);
+
+// Remove the oldest queued command, keeping it as last executed command or not
+void cmd_queue_pop(t_cmd_queue* queue, const bool keep_as_last);
+
+// Get the last executed command kept (NULL if there is none)
+t_ducky_cmd* cmd_queue_last(t_cmd_queue* queue);
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,243 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckybytecode.cpp                                                                          */
+/* Description:                                                                                   */
+/*     Compact binary encoding of compiled Ducky Script commands.                                 */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "duckybytecode.h"
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions Prototypes */
+
+// Get the arguments type of a bytecode opcode (-1 if invalid opcode)
+static int8_t opcode_arg_type(const uint8_t opcode);
+
+// Get the size of a varint (0 if more bytes are needed, -1 if invalid)
+static int8_t varint_size(const uint8_t* code, const uint16_t code_len);
+
+// Write a varint, returns its size or 0 if it doesn't fit
+static uint8_t varint_write(uint32_t value, uint8_t* code, const uint16_t code_size);
+
+// Read a varint, returns its size or 0 if not valid
+static uint8_t varint_read(const uint8_t* code, const uint16_t code_len, uint32_t* value);
+
+/**************************************************************************************************/
+
+/* Bytecode Functions */
+
+// Check if a byte is a bytecode opcode (start of a bytecode command)
+bool ducky_bytecode_is_opcode(const uint8_t byte)
+{
+    return ((byte & DUCKY_BYTECODE_OPCODE_MARK) != 0);
+}
+
+// Get the size of the bytecode command at the start of a buffer
+// Returns the command size, 0 if more bytes are needed to know it or -1 if it is not valid
+int16_t ducky_bytecode_size(const uint8_t* code, const uint16_t code_len)
+{
+    int8_t arg_type = 0;
+    int8_t num_size = 0;
+    uint16_t i = 1;
+
+    if(code_len == 0)
+        return 0;
+
+    arg_type = opcode_arg_type(code[0]);
+    if(arg_type < 0)
+        return -1;
+
+    // Number operand
+    if((arg_type == ARG_NUM) || (arg_type == ARG_NUM_TEXT))
+    {
+        num_size = varint_size(&(code[i]), code_len - i);
+        if(num_size <= 0)
+            return num_size;
+        i = i + num_size;
+    }
+
+    switch(arg_type)
+    {
+        case ARG_KEY:
+        case ARG_KEYWORD_KEY:
+            return i + 1;
+
+        case ARG_CHORD:
+            return i + 2;
+
+        case ARG_TEXT:
+        case ARG_NUM_TEXT:
+            if(code_len <= i)
+                return 0;
+            if((code[i] == 0) || (code[i] > DUCKY_TEXT_MAX_LENGTH))
+                return -1;
+            return i + 1 + code[i];
+
+        default:
+            return i;
+    }
+}
+
+// Encode a compiled command into bytecode, returns encoded size or 0 if it doesn't fit
+uint16_t ducky_bytecode_encode(const t_ducky_cmd* cmd, uint8_t* code, const uint16_t code_size)
+{
+    int8_t arg_type = opcode_arg_type(DUCKY_BYTECODE_OPCODE_MARK | cmd->cmd);
+    uint16_t i = 0;
+    uint8_t n = 0;
+
+    if((arg_type < 0) || (code_size < 1))
+        return 0;
+    code[i++] = DUCKY_BYTECODE_OPCODE_MARK | cmd->cmd;
+
+    // Number operand
+    if((arg_type == ARG_NUM) || (arg_type == ARG_NUM_TEXT))
+    {
+        n = varint_write(cmd->num, &(code[i]), code_size - i);
+        if(n == 0)
+            return 0;
+        i = i + n;
+    }
+
+    switch(arg_type)
+    {
+        case ARG_KEY:
+        case ARG_KEYWORD_KEY:
+            if(code_size < i + 1)
+                return 0;
+            code[i++] = cmd->key;
+            break;
+
+        case ARG_CHORD:
+            if(code_size < i + 2)
+                return 0;
+            code[i++] = cmd->modifiers;
+            code[i++] = cmd->key;
+            break;
+
+        case ARG_TEXT:
+        case ARG_NUM_TEXT:
+            if(code_size < i + 1 + cmd->text_len)
+                return 0;
+            code[i++] = cmd->text_len;
+            memcpy(&(code[i]), cmd->text, cmd->text_len);
+            i = i + cmd->text_len;
+            break;
+
+        default:
+            break;
+    }
+
+    return i;
+}
+
+// Decode a bytecode command into a compiled command record
+int8_t ducky_bytecode_decode(const uint8_t* code, const uint16_t code_len, t_ducky_cmd* cmd)
+{
+    int16_t size = ducky_bytecode_size(code, code_len);
+    uint8_t arg_type = 0;
+    uint16_t i = 1;
+
+    if((size <= 0) || (size != code_len))
+        return RC_INVALID_INPUT;
+
+    arg_type = ducky_cmd_init(code[0] & ~DUCKY_BYTECODE_OPCODE_MARK, cmd);
+
+    // Number operand
+    if((arg_type == ARG_NUM) || (arg_type == ARG_NUM_TEXT))
+        i = i + varint_read(&(code[i]), code_len - i, &(cmd->num));
+
+    switch(arg_type)
+    {
+        case ARG_KEY:
+        case ARG_KEYWORD_KEY:
+            if(code[i] != 0)
+                cmd->key = code[i];
+            else if(arg_type == ARG_KEYWORD_KEY)
+                return RC_BAD;
+            break;
+
+        case ARG_CHORD:
+            cmd->modifiers = code[i];
+            cmd->key = code[i+1];
+            break;
+
+        case ARG_TEXT:
+        case ARG_NUM_TEXT:
+            cmd->text_len = code[i];
+            memcpy(cmd->text, &(code[i+1]), cmd->text_len);
+            break;
+
+        default:
+            break;
+    }
+
+    return RC_OK;
+}
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Get the arguments type of a bytecode opcode (-1 if invalid opcode)
+static int8_t opcode_arg_type(const uint8_t opcode)
+{
+    t_ducky_cmd cmd;
+    uint8_t cmd_id = opcode & ~DUCKY_BYTECODE_OPCODE_MARK;
+
+    // Comments are never encoded
+    if(!ducky_bytecode_is_opcode(opcode) || (cmd_id >= CMD_NUM) || (cmd_id == CMD_REM))
+        return -1;
+
+    return ducky_cmd_init(cmd_id, &cmd);
+}
+
+// Get the size of a varint (0 if more bytes are needed, -1 if invalid)
+static int8_t varint_size(const uint8_t* code, const uint16_t code_len)
+{
+    for(uint8_t i = 0; i < 5; i++)
+    {
+        if(i >= code_len)
+            return 0;
+        if((code[i] & 0x80) == 0)
+            return i + 1;
+    }
+
+    return -1;
+}
+
+// Write a varint, returns its size or 0 if it doesn't fit
+static uint8_t varint_write(uint32_t value, uint8_t* code, const uint16_t code_size)
+{
+    uint8_t i = 0;
+
+    do
+    {
+        if(i >= code_size)
+            return 0;
+        code[i] = value & 0x7F;
+        value = value >> 7;
+        if(value != 0)
+            code[i] = code[i] | 0x80;
+        i = i + 1;
+    } while(value != 0);
+
+    return i;
+}
+
+// Read a varint, returns its size or 0 if not valid
+static uint8_t varint_read(const uint8_t* code, const uint16_t code_len, uint32_t* value)
+{
+    *value = 0;
+
+    for(uint8_t i = 0; (i < 5) && (i < code_len); i++)
+    {
+        *value = *value | ((uint32_t)(code[i] & 0x7F) << (7*i));
+        if((code[i] & 0x80) == 0)
+            return i + 1;
+    }
+
+    return 0;
+}
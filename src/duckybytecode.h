@@ -0,0 +1,78 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckybytecode.h                                                                            */
+/* Description:                                                                                   */
+/*     Compact binary encoding of compiled Ducky Script commands.                                 */
+/**************************************************************************************************/
+
+/* Bytecode Format:
+ *
+ * Each command is encoded as an opcode byte followed by its operands. The opcode byte has its
+ * most significant bit set (text lines are 7 bits ASCII, so both formats can be mixed in the
+ * same link) and the command ID (CMD_* values) in its lower bits:
+ *
+ *     [0x80 | command ID] [operands]
+ *
+ * Operands depend on the command arguments type:
+ *
+ *     ARG_NONE                 No operands
+ *     ARG_NUM                  [number]
+ *     ARG_KEY, ARG_KEYWORD_KEY [key]
+ *     ARG_TEXT                 [length] [text bytes]
+ *     ARG_NUM_TEXT             [number] [length] [text bytes]
+ *     ARG_CHORD                [modifiers] [key]
+ *
+ * Where [key] is the USB-HID key code (0 for none), [modifiers] is the modifier keys bitmask (as
+ * the HID report modifiers byte), [length] is a single byte and [number] is an unsigned LEB128
+ * varint (7 bits per byte, least significant group first, bit 7 set in all bytes but the last
+ * one, 1 to 5 bytes for uint32_t).
+ *
+ * Examples:
+ *
+ *     "CTRL-ALT DELETE"  -> 87 4C
+ *     "DELAY 500"        -> 84 F4 03
+ *     "STRING hi"        -> 85 02 68 69
+ *     "GUI-SHIFT s"      -> 9B 0A 16
+ */
+
+#ifndef DUCKYBYTECODE_H_
+#define DUCKYBYTECODE_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "returncodes.h"
+#include "duckyparser.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Opcode byte mark
+#define DUCKY_BYTECODE_OPCODE_MARK 0x80
+
+// Maximum size of an encoded command
+#define DUCKY_BYTECODE_MAX_SIZE (1 + 5 + 1 + DUCKY_TEXT_MAX_LENGTH)
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Check if a byte is a bytecode opcode (start of a bytecode command)
+bool ducky_bytecode_is_opcode(const uint8_t byte);
+
+// Get the size of the bytecode command at the start of a buffer
+// Returns the command size, 0 if more bytes are needed to know it or -1 if it is not valid
+int16_t ducky_bytecode_size(const uint8_t* code, const uint16_t code_len);
+
+// Encode a compiled command into bytecode, returns encoded size or 0 if it doesn't fit
+uint16_t ducky_bytecode_encode(const t_ducky_cmd* cmd, uint8_t* code, const uint16_t code_size);
+
+// Decode a bytecode command into a compiled command record
+int8_t ducky_bytecode_decode(const uint8_t* code, const uint16_t code_len, t_ducky_cmd* cmd);
+
+/**************************************************************************************************/
+
+#endif
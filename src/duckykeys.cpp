@@ -0,0 +1,147 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckykeys.cpp                                                                              */
+/* Description:                                                                                   */
+/*     Ducky Script key names to USB-HID key codes conversion.                                    */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "duckykeys.h"
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Multi-character key names table (stored in flash)
+// Note: Entries must be kept sorted in strcmp() order, the table is binary searched
+static const t_ducky_name DUCKY_KEYS[] PROGMEM =
+{
+    { "APP", KEY_MENU },
+    { "BREAK", KEY_PAUSE },
+    { "CAPSLOCK", KEY_CAPS_LOCK },
+    { "CAPS_LOCK", KEY_CAPS_LOCK },
+    { "DEL", KEY_DELETE },
+    { "DELETE", KEY_DELETE },
+    { "DOWN", KEY_DOWN },
+    { "DOWNARROW", KEY_DOWN },
+    { "END", KEY_END },
+    { "ENTER", KEY_ENTER },
+    { "ESC", KEY_ESC },
+    { "ESCAPE", KEY_ESC },
+    { "F1", KEY_F1 },
+    { "F10", KEY_F10 },
+    { "F11", KEY_F11 },
+    { "F12", KEY_F12 },
+    { "F2", KEY_F2 },
+    { "F3", KEY_F3 },
+    { "F4", KEY_F4 },
+    { "F5", KEY_F5 },
+    { "F6", KEY_F6 },
+    { "F7", KEY_F7 },
+    { "F8", KEY_F8 },
+    { "F9", KEY_F9 },
+    { "HOME", KEY_HOME },
+    { "INSERT", KEY_INSERT },
+    { "LEFT", KEY_LEFT },
+    { "LEFTARROW", KEY_LEFT },
+    { "MEDIA_MUTE", KEY_MEDIA_MUTE },
+    { "MEDIA_PLAY_PAUSE", KEY_MEDIA_PLAY_PAUSE },
+    { "MEDIA_STOP", KEY_MEDIA_STOP },
+    { "MEDIA_VOLUME_DEC", KEY_MEDIA_VOLUME_DEC },
+    { "MEDIA_VOLUME_INC", KEY_MEDIA_VOLUME_INC },
+    { "MENU", KEY_MENU },
+    { "MUTE", KEY_MEDIA_MUTE },
+    { "NUMLOCK", KEY_NUM_LOCK },
+    { "NUM_LOCK", KEY_NUM_LOCK },
+    { "PAGEDOWN", KEY_PAGEDOWN },
+    { "PAGEUP", KEY_PAGEUP },
+    { "PAUSE", KEY_MEDIA_PLAY_PAUSE },
+    { "PLAY", KEY_MEDIA_PLAY_PAUSE },
+    { "POWER", KEY_POWER },
+    { "PRINTSCREEN", KEY_PRINTSCREEN },
+    { "RIGHT", KEY_RIGHT },
+    { "RIGHTARROW", KEY_RIGHT },
+    { "SCROLLLOCK", KEY_SCROLL_LOCK },
+    { "SCROLL_LOCK", KEY_SCROLL_LOCK },
+    { "SPACE", KEY_SPACE },
+    { "STOP", KEY_MEDIA_STOP },
+    { "TAB", KEY_TAB },
+    { "UP", KEY_UP },
+    { "UPARROW", KEY_UP },
+    { "VOLUMEDOWN", KEY_MEDIA_VOLUME_DEC },
+    { "VOLUMEUP", KEY_MEDIA_VOLUME_INC }
+};
+
+// Number of elements of multi-character key names table
+#define DUCKY_KEYS_N (sizeof(DUCKY_KEYS)/sizeof(DUCKY_KEYS[0]))
+
+/**************************************************************************************************/
+
+/* Ducky Key Functions */
+
+// Convert a single character key (letter or digit) into corresponding USB-HID Code byte
+static uint8_t ducky_char_to_hid_byte(const char c)
+{
+    // Letters (case insensitive), "a"/"A" to "z"/"Z"
+    if((c >= 'a') && (c <= 'z'))
+        return KEY_A + (c - 'a');
+    if((c >= 'A') && (c <= 'Z'))
+        return KEY_A + (c - 'A');
+
+    // Digits, "1" to "9" and then "0" (USB-HID order)
+    if(c == '0')
+        return KEY_0;
+    if((c >= '1') && (c <= '9'))
+        return KEY_1 + (c - '1');
+
+    return KEY_UNDEFINED_ERROR;
+}
+
+// Convert Ducky Script key name into corresponding USB-HID Code byte
+uint8_t ducky_key_to_hid_byte(const char* key, const size_t key_len)
+{
+    // Check for empty key
+    if(key_len == 0)
+        return KEY_UNDEFINED_ERROR;
+
+    // Single character keys are directly indexed from their ASCII value
+    if(key_len == 1)
+        return ducky_char_to_hid_byte(key[0]);
+
+    return ducky_name_lookup(DUCKY_KEYS, DUCKY_KEYS_N, key, key_len, KEY_UNDEFINED_ERROR);
+}
+
+// Search a name in a flash stored and strcmp() sorted names table and get its value
+uint8_t ducky_name_lookup(const t_ducky_name* table, const size_t table_n, const char* name,
+    const size_t name_len, const uint8_t not_found_value)
+{
+    int16_t first = 0;
+    int16_t last = table_n - 1;
+    int16_t middle = 0;
+    int cmp = 0;
+
+    // Names longer than any table element can't match
+    if((name_len == 0) || (name_len > DUCKY_NAME_MAX_LENGTH))
+        return not_found_value;
+
+    // Binary search the name in the sorted table
+    while(first <= last)
+    {
+        middle = (first + last) / 2;
+        cmp = strncmp_P(name, table[middle].name, name_len);
+
+        // Provided name is a prefix of the element name, so it goes before it
+        if((cmp == 0) && (pgm_read_byte(&(table[middle].name[name_len])) != '\0'))
+            cmp = -1;
+
+        if(cmp == 0)
+            return pgm_read_byte(&(table[middle].value));
+        if(cmp < 0)
+            last = middle - 1;
+        else
+            first = middle + 1;
+    }
+
+    return not_found_value;
+}
@@ -0,0 +1,49 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckykeys.h                                                                                */
+/* Description:                                                                                   */
+/*     Ducky Script key names to USB-HID key codes conversion.                                    */
+/**************************************************************************************************/
+
+#ifndef DUCKYKEYS_H_
+#define DUCKYKEYS_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "hidkeys.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Maximum length of a multi-character name (i.e. "MEDIA_PLAY_PAUSE")
+#define DUCKY_NAME_MAX_LENGTH 16
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Name to value table element (tables of this elements are stored in flash)
+typedef struct
+{
+    char name[DUCKY_NAME_MAX_LENGTH+1];
+    uint8_t value;
+} t_ducky_name;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Convert Ducky Script key name into corresponding USB-HID Code byte
+uint8_t ducky_key_to_hid_byte(const char* key, const size_t key_len);
+
+// Search a name in a flash stored and strcmp() sorted names table and get its value
+uint8_t ducky_name_lookup(const t_ducky_name* table, const size_t table_n, const char* name,
+    const size_t name_len, const uint8_t not_found_value);
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,150 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckylz.cpp                                                                                */
+/* Description:                                                                                   */
+/*     Compressed Ducky Script text lines (static dictionary plus short LZ back-references).      */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "duckylz.h"
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Static dictionary of common Ducky Script words, each entry prefixed by its length (stored in
+// flash). Note: Entries can be appended, but not changed nor removed (encoded indexes)
+static const char LZ_DICT[] PROGMEM =
+    "\x07" "STRING "       "\x06" "DELAY "        "\x05" "ENTER"         "\x04" "GUI "
+    "\x05" "CTRL "         "\x04" "ALT "          "\x06" "SHIFT "        "\x07" "REPEAT "
+    "\x0E" "DEFAULT_DELAY " "\x0D" "STRING_DELAY " "\x09" "CTRL-ALT "   "\x0B" "CTRL-SHIFT "
+    "\x0A" "ALT-SHIFT "    "\x03" "TAB"           "\x06" "ESCAPE"        "\x05" "SPACE"
+    "\x06" "DELETE"        "\x09" "BACKSPACE"     "\x07" "UPARROW"       "\x09" "DOWNARROW"
+    "\x09" "LEFTARROW"     "\x0A" "RIGHTARROW"    "\x0A" "powershell"    "\x03" "cmd"
+    "\x07" "http://"       "\x08" "https://"      "\x04" "www."          "\x04" ".com"
+    "\x04" ".exe"          "\x0E" "Start-Process " "\x07" "Invoke-"      "\x0D" "-WindowStyle "
+    "\x06" "Hidden"        "\x0B" "-NoProfile "   "\x0B" "C:\\Windows\\" "\x08" "System32"
+    "\x04" "the "          "\x04" "and "          "\x04" "ing "          "\x04" "tion"
+    "\x05" "echo "         "\x05" "sudo "         "\x05" "/bin/"         "\x08" "terminal"
+    "\x07" "notepad"       "\x05" "Hello"         "\x05" "World"         "\x03" "100"
+    "\x03" "500"           "\x04" "1000"          "\x03" "200"           "\x05" "open "
+    "\x09" "-Command "     "\x04" "Get-"          "\x0B" "New-Object "   "\x05" "curl "
+    "\x05" "wget "         "\x09" "chmod +x "     "\x03" "run"           "\x08" "Download"
+    "\x07" "String("       "\x04" "File"          "\x04" "Path"          "\x03" " > ";
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions Prototypes */
+
+// Append a decoded character to the history and to the line (if it is not full)
+static inline void put_char(t_lz_state* lz, const char c, char* line, uint16_t* line_len,
+    const uint16_t line_size);
+
+/**************************************************************************************************/
+
+/* Decoder Functions */
+
+// Decode a compressed line byte, appending decoded characters to a line (truncated when full)
+// Characters are added to the history even if the line is full, so it keeps the encoder one
+// Returns the new line length
+uint16_t ducky_lz_decode(t_lz_state* lz, const uint8_t byte, char* line, uint16_t line_len,
+    const uint16_t line_size)
+{
+    uint8_t from = 0;
+    uint8_t length = 0;
+    const char* entry = LZ_DICT;
+
+    // Back-reference distance
+    if(lz->ref_length != 0)
+    {
+        from = lz->head - ((byte & ~LZ_DICT_TOKEN) + 1);
+        for(uint8_t i = 0; i < lz->ref_length; i++)
+        {
+            put_char(lz, lz->history[from % LZ_WINDOW_SIZE], line, &line_len, line_size);
+            from = from + 1;
+        }
+        lz->ref_length = 0;
+        return line_len;
+    }
+
+    // Literal
+    if((byte & LZ_DICT_TOKEN) == 0)
+    {
+        put_char(lz, (char)byte, line, &line_len, line_size);
+        return line_len;
+    }
+
+    // Back-reference length, its distance is the next byte
+    if((byte & LZ_TOKEN_MASK) == LZ_REF_TOKEN)
+    {
+        lz->ref_length = (byte & ~LZ_TOKEN_MASK) + LZ_REF_MIN_LENGTH;
+        return line_len;
+    }
+
+    // Dictionary entry (skip previous ones through their lengths)
+    for(uint8_t i = (byte & ~LZ_TOKEN_MASK); i > 0; i--)
+    {
+        length = pgm_read_byte(entry);
+        if(length == 0)
+            return line_len;
+        entry = entry + 1 + length;
+    }
+    length = pgm_read_byte(entry);
+    for(uint8_t i = 1; i <= length; i++)
+        put_char(lz, (char)pgm_read_byte(entry + i), line, &line_len, line_size);
+
+    return line_len;
+}
+
+// Get a dictionary entry into a buffer (at least LZ_REF_MAX_LENGTH bytes), returns its length
+uint8_t ducky_lz_dict_entry(const uint8_t index, char* entry)
+{
+    const char* dict = LZ_DICT;
+    uint8_t length = 0;
+
+    for(uint8_t i = 0; i <= index; i++)
+    {
+        length = pgm_read_byte(dict);
+        if(length == 0)
+            return 0;
+        if(i < index)
+            dict = dict + 1 + length;
+    }
+    memcpy_P(entry, dict + 1, length);
+
+    return length;
+}
+
+// Get the number of dictionary entries
+uint8_t ducky_lz_dict_entries(void)
+{
+    const char* dict = LZ_DICT;
+    uint8_t entries = 0;
+
+    while((entries < LZ_DICT_MAX_ENTRIES) && (pgm_read_byte(dict) != 0))
+    {
+        dict = dict + 1 + pgm_read_byte(dict);
+        entries = entries + 1;
+    }
+
+    return entries;
+}
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Append a decoded character to the history and to the line (if it is not full)
+static inline void put_char(t_lz_state* lz, const char c, char* line, uint16_t* line_len,
+    const uint16_t line_size)
+{
+    lz->history[lz->head % LZ_WINDOW_SIZE] = c;
+    lz->head = lz->head + 1;
+
+    if(*line_len < line_size)
+    {
+        line[*line_len] = c;
+        *line_len = *line_len + 1;
+    }
+}
@@ -0,0 +1,84 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckylz.h                                                                                  */
+/* Description:                                                                                   */
+/*     Compressed Ducky Script text lines (static dictionary plus short LZ back-references).      */
+/**************************************************************************************************/
+
+/* Compressed Line Format:
+ *
+ * A compressed line starts with LZ_LINE_MARK and ends with '\r' or '\n' as a text line does. Its
+ * bytes in between are decoded one by one:
+ *
+ *     0x00 - 0x7F  Literal character (never '\r' nor '\n')
+ *     0x80 - 0xBF  Static dictionary entry (index in the lower 6 bits)
+ *     0xC0 - 0xFF  Back-reference of (3 + lower 6 bits) characters, followed by a distance byte
+ *                  (0x80 | (distance - 1)), copied from the decoded characters history
+ *
+ * The history keeps the last LZ_WINDOW_SIZE decoded characters of previous and current compressed
+ * lines of the source (end of line characters excluded), so repeated text of previous lines can
+ * be referenced. All encoded bytes but literals have the most significant bit set, so a line end
+ * is never part of a token.
+ */
+
+#ifndef DUCKYLZ_H_
+#define DUCKYLZ_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Compressed line mark (first byte of the line)
+#define LZ_LINE_MARK 0x01
+
+// Tokens
+#define LZ_DICT_TOKEN 0x80
+#define LZ_REF_TOKEN 0xC0
+#define LZ_TOKEN_MASK 0xC0
+
+// Back-references length range
+#define LZ_REF_MIN_LENGTH 3
+#define LZ_REF_MAX_LENGTH (LZ_REF_MIN_LENGTH + 0x3F)
+
+// Decoded characters history size (must be a power of 2, maximum 128)
+#define LZ_WINDOW_SIZE 64
+
+// Maximum number of dictionary entries
+#define LZ_DICT_MAX_ENTRIES 64
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Decoder state
+typedef struct
+{
+    char history[LZ_WINDOW_SIZE];
+    uint8_t head;         // Free running history write index
+    uint8_t ref_length;   // Pending back-reference length waiting for its distance (0 if none)
+} t_lz_state;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Decode a compressed line byte, appending decoded characters to a line (truncated when full)
+// Returns the new line length
+uint16_t ducky_lz_decode(t_lz_state* lz, const uint8_t byte, char* line, uint16_t line_len,
+    const uint16_t line_size);
+
+// Get a dictionary entry into a buffer (at least LZ_REF_MAX_LENGTH bytes), returns its length
+uint8_t ducky_lz_dict_entry(const uint8_t index, char* entry);
+
+// Get the number of dictionary entries
+uint8_t ducky_lz_dict_entries(void);
+
+/**************************************************************************************************/
+
+#endif
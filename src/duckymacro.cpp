@@ -0,0 +1,355 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckymacro.cpp                                                                             */
+/* Description:                                                                                   */
+/*     On-device named macros (DEFINE name ... END) and bounded loops (LOOP n ... END), stored    */
+/*     pre-compiled in a fixed size RAM arena and replayed without being sent again.              */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "duckymacro.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Macro definition header size, without its name (name length and body length)
+#define MACRO_HEADER_SIZE 3
+
+// Position returned when a macro or a block end is not found
+#define MACRO_NOT_FOUND 0xFFFF
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions Prototypes */
+
+// Get the position of a macro definition (MACRO_NOT_FOUND if it is not defined)
+static uint16_t macro_find(const t_macros* macros, const char* name, const uint8_t name_len);
+
+// Get the size of the macro definition at a position (header, name and body)
+static uint16_t macro_size(const t_macros* macros, const uint16_t position);
+
+// Get the position of the END command that closes a loop body (MACRO_NOT_FOUND if missing)
+static uint16_t loop_body_end(const t_macros* macros, uint16_t position, const uint16_t end);
+
+// Start replaying a block, returns RC_BAD if too many blocks are nested
+static int8_t block_push(t_macros* macros, const uint16_t start, const uint16_t end,
+    const uint32_t loops);
+
+/**************************************************************************************************/
+
+/* Record Functions */
+
+// Start recording a macro definition from its DEFINE command (a previous one with the same name
+// is replaced)
+// The new body is recorded after the definitions, a previous one is kept until its END
+int8_t macro_define_start(t_macros* macros, const t_ducky_cmd* cmd)
+{
+    uint16_t position = 0;
+
+    // Definitions can't be nested
+    if(macros->recording || (cmd->text_len > MACRO_NAME_MAX_LENGTH))
+        return RC_BAD;
+
+    if(macros->length + MACRO_HEADER_SIZE + cmd->text_len > MACRO_ARENA_SIZE)
+        return RC_BAD;
+
+    // Header with the name, body length is written at the end
+    position = macros->length;
+    macros->code[position] = cmd->text_len;
+    memcpy(&(macros->code[position + 1]), cmd->text, cmd->text_len);
+
+    macros->record_start = position;
+    macros->record_position = position + MACRO_HEADER_SIZE + cmd->text_len;
+    macros->record_loops = 0;
+    macros->record_depth = 0;
+    macros->record_define = true;
+    macros->recording = true;
+
+    return RC_OK;
+}
+
+// Start recording a loop block from its LOOP command (or a nested one inside the block being
+// recorded)
+int8_t macro_loop_start(t_macros* macros, const t_ducky_cmd* cmd)
+{
+    // Nested loop, just recorded to be expanded on replay
+    if(macros->recording)
+    {
+        if(macro_record(macros, cmd) != RC_OK)
+            return RC_BAD;
+        macros->record_depth = macros->record_depth + 1;
+        return RC_OK;
+    }
+
+    // Top level loop body is recorded after the definitions
+    macros->record_start = macros->length;
+    macros->record_position = macros->length;
+    macros->record_loops = cmd->num;
+    macros->record_depth = 0;
+    macros->record_define = false;
+    macros->recording = true;
+
+    return RC_OK;
+}
+
+// Record a CALL command in the block being recorded, or start replaying the called macro
+// Calls inside a block are resolved on replay, so a macro can call another one defined later
+int8_t macro_call(t_macros* macros, const t_ducky_cmd* cmd)
+{
+    uint16_t position = 0;
+
+    if(macros->recording)
+        return macro_record(macros, cmd);
+
+    position = macro_find(macros, cmd->text, cmd->text_len);
+    if(position == MACRO_NOT_FOUND)
+        return RC_BAD;
+
+    return block_push(macros, position + MACRO_HEADER_SIZE + cmd->text_len,
+        position + macro_size(macros, position), 1);
+}
+
+// Append a compiled command to the block being recorded
+// Recording is aborted if the command doesn't fit in the arena
+int8_t macro_record(t_macros* macros, const t_ducky_cmd* cmd)
+{
+    uint16_t code_len = 0;
+
+    if(!macros->recording)
+        return RC_BAD;
+
+    code_len = ducky_bytecode_encode(cmd, &(macros->code[macros->record_position]),
+        MACRO_ARENA_SIZE - macros->record_position);
+    if(code_len == 0)
+    {
+        macros->recording = false;
+        return RC_BAD;
+    }
+    macros->record_position = macros->record_position + code_len;
+
+    return RC_OK;
+}
+
+// Abort recording the block being recorded (previous definitions are kept)
+// A definition is only added to the arena by its END, so there is nothing to undo
+void macro_record_abort(t_macros* macros)
+{
+    macros->recording = false;
+}
+
+// Close the innermost block being recorded (a top level loop starts to be replayed)
+int8_t macro_end(t_macros* macros)
+{
+    uint16_t body_len = 0;
+    uint16_t position = 0;
+    uint16_t size = 0;
+    uint8_t name_len = 0;
+
+    if(!macros->recording)
+        return RC_BAD;
+
+    // Nested loop end (END command has no operands, its bytecode is just the opcode)
+    if(macros->record_depth > 0)
+    {
+        if(macros->record_position >= MACRO_ARENA_SIZE)
+        {
+            macros->recording = false;
+            return RC_BAD;
+        }
+        macros->code[macros->record_position] = DUCKY_BYTECODE_OPCODE_MARK | CMD_END;
+        macros->record_position = macros->record_position + 1;
+        macros->record_depth = macros->record_depth - 1;
+        return RC_OK;
+    }
+    macros->recording = false;
+
+    // Top level loop, replay its body (the definitions are kept as they were)
+    if(!macros->record_define)
+    {
+        if((macros->record_loops == 0) || (macros->record_position == macros->record_start))
+            return RC_OK;
+        return block_push(macros, macros->record_start, macros->record_position,
+            macros->record_loops);
+    }
+
+    // Macro definition, write its body length to make it valid
+    name_len = macros->code[macros->record_start];
+    body_len = macros->record_position - macros->record_start - MACRO_HEADER_SIZE - name_len;
+    macros->code[macros->record_start + 1 + name_len] = body_len & 0xFF;
+    macros->code[macros->record_start + 2 + name_len] = body_len >> 8;
+
+    // Remove previous definition, moving following ones (the new one included) over it
+    position = macro_find(macros, (const char*)&(macros->code[macros->record_start + 1]),
+        name_len);
+    if(position != MACRO_NOT_FOUND)
+    {
+        size = macro_size(macros, position);
+        memmove(&(macros->code[position]), &(macros->code[position + size]),
+            macros->record_position - position - size);
+        macros->record_position = macros->record_position - size;
+    }
+    macros->length = macros->record_position;
+
+    return RC_OK;
+}
+
+/**************************************************************************************************/
+
+/* Replay Functions */
+
+// Check if macros are being replayed
+bool macro_running(const t_macros* macros)
+{
+    return (macros->depth > 0);
+}
+
+// Get next command to be executed of the macros being replayed
+// LOOP and CALL commands are expanded here, so just the commands to be executed are returned
+// Returns RC_BAD once they end and RC_INVALID_INPUT if replay is stopped by an error
+int8_t macro_run_next(t_macros* macros, t_ducky_cmd* cmd)
+{
+    t_macro_frame* frame = NULL;
+    int16_t code_size = 0;
+    uint16_t body_start = 0;
+    uint16_t body_end = 0;
+
+    while(macros->depth > 0)
+    {
+        frame = &(macros->stack[macros->depth - 1]);
+
+        // Block end, start next iteration or get back to the parent block
+        if(frame->position >= frame->end)
+        {
+            if(frame->loops_left > 1)
+            {
+                frame->loops_left = frame->loops_left - 1;
+                frame->position = frame->start;
+            }
+            else
+                macros->depth = macros->depth - 1;
+            continue;
+        }
+
+        code_size = ducky_bytecode_size(&(macros->code[frame->position]),
+            frame->end - frame->position);
+        if((code_size <= 0) ||
+           (ducky_bytecode_decode(&(macros->code[frame->position]), code_size, cmd) != RC_OK))
+            break;
+        frame->position = frame->position + code_size;
+
+        switch(cmd->cmd)
+        {
+            case CMD_LOOP:
+                body_start = frame->position;
+                body_end = loop_body_end(macros, body_start, frame->end);
+                if(body_end == MACRO_NOT_FOUND)
+                    break;
+                frame->position = body_end + 1;
+                if((cmd->num == 0) || (body_end == body_start))
+                    continue;
+                if(block_push(macros, body_start, body_end, cmd->num) != RC_OK)
+                    break;
+                continue;
+
+            case CMD_CALL:
+                if(macro_call(macros, cmd) != RC_OK)
+                    break;
+                continue;
+
+            case CMD_END:
+                continue;
+
+            default:
+                if(ducky_cmd_is_control(cmd->cmd))
+                    break;
+                return RC_OK;
+        }
+        break;
+    }
+
+    // Nothing left or invalid block, stop replay
+    if(macros->depth == 0)
+        return RC_BAD;
+    macros->depth = 0;
+
+    return RC_INVALID_INPUT;
+}
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Get the position of a macro definition (MACRO_NOT_FOUND if it is not defined)
+static uint16_t macro_find(const t_macros* macros, const char* name, const uint8_t name_len)
+{
+    uint16_t position = 0;
+
+    while(position < macros->length)
+    {
+        if((macros->code[position] == name_len) &&
+           (memcmp(&(macros->code[position + 1]), name, name_len) == 0))
+            return position;
+        position = position + macro_size(macros, position);
+    }
+
+    return MACRO_NOT_FOUND;
+}
+
+// Get the size of the macro definition at a position (header, name and body)
+static uint16_t macro_size(const t_macros* macros, const uint16_t position)
+{
+    uint8_t name_len = macros->code[position];
+    uint16_t body_len = macros->code[position + 1 + name_len] |
+        (((uint16_t)macros->code[position + 2 + name_len]) << 8);
+
+    return MACRO_HEADER_SIZE + name_len + body_len;
+}
+
+// Get the position of the END command that closes a loop body (MACRO_NOT_FOUND if missing)
+static uint16_t loop_body_end(const t_macros* macros, uint16_t position, const uint16_t end)
+{
+    uint8_t depth = 0;
+    uint8_t cmd_id = 0;
+    int16_t code_size = 0;
+
+    while(position < end)
+    {
+        code_size = ducky_bytecode_size(&(macros->code[position]), end - position);
+        if(code_size <= 0)
+            break;
+
+        cmd_id = macros->code[position] & ~DUCKY_BYTECODE_OPCODE_MARK;
+        if(cmd_id == CMD_LOOP)
+            depth = depth + 1;
+        else if(cmd_id == CMD_END)
+        {
+            if(depth == 0)
+                return position;
+            depth = depth - 1;
+        }
+        position = position + code_size;
+    }
+
+    return MACRO_NOT_FOUND;
+}
+
+// Start replaying a block, returns RC_BAD if too many blocks are nested
+static int8_t block_push(t_macros* macros, const uint16_t start, const uint16_t end,
+    const uint32_t loops)
+{
+    t_macro_frame* frame = NULL;
+
+    if(macros->depth >= MACRO_STACK_DEPTH)
+        return RC_BAD;
+
+    frame = &(macros->stack[macros->depth]);
+    frame->start = start;
+    frame->end = end;
+    frame->position = start;
+    frame->loops_left = loops;
+    macros->depth = macros->depth + 1;
+
+    return RC_OK;
+}
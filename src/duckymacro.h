@@ -0,0 +1,117 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckymacro.h                                                                               */
+/* Description:                                                                                   */
+/*     On-device named macros (DEFINE name ... END) and bounded loops (LOOP n ... END), stored    */
+/*     pre-compiled in a fixed size RAM arena and replayed without being sent again.              */
+/**************************************************************************************************/
+
+/* Arena Format:
+ *
+ * Macro definitions are stored one after the other from the start of the arena:
+ *
+ *     [name length] [name] [body length low] [body length high] [body bytecode commands]
+ *
+ * The body commands are in the bytecode format (see duckybytecode.h), including LOOP, END and
+ * CALL commands of nested blocks. The body of a top level LOOP being recorded or replayed is
+ * stored just after the last definition, without header, and its space is reused once it ends.
+ * A macro being defined is also recorded there, and a previous definition with the same name is
+ * removed just once the new one ends (so a redefinition that fails keeps the previous one).
+ *
+ * Example:
+ *
+ *     DEFINE tab3      ->  [04] "tab3" [04 00] [80 2B] [82 02]
+ *     TAB
+ *     REPEAT 2
+ *     END
+ */
+
+#ifndef DUCKYMACRO_H_
+#define DUCKYMACRO_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "returncodes.h"
+#include "duckyparser.h"
+#include "duckybytecode.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Macros arena size (definitions and top level loop body)
+#ifndef MACRO_ARENA_SIZE
+    #define MACRO_ARENA_SIZE 192
+#endif
+
+// Maximum macro name length
+#define MACRO_NAME_MAX_LENGTH 16
+
+// Maximum nested loops and macro calls being replayed
+#define MACRO_STACK_DEPTH 4
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Replay state of a block (macro body or loop body)
+typedef struct
+{
+    uint16_t start;       // Block first command
+    uint16_t end;         // Block end (first byte after its last command)
+    uint16_t position;    // Next command to replay
+    uint32_t loops_left;  // Pending iterations, current one included
+} t_macro_frame;
+
+// Macros arena and recording and replay state
+typedef struct
+{
+    uint8_t code[MACRO_ARENA_SIZE];
+    uint16_t length;                          // Bytes used by macro definitions
+    uint16_t record_start;                    // Recorded block start (header or loop body)
+    uint16_t record_position;                 // Next recorded command position
+    uint32_t record_loops;                    // Top level loop iterations
+    uint8_t record_depth;                     // Nested loops opened in the recorded block
+    bool record_define;                       // Recorded block is a macro definition
+    bool recording;
+    uint8_t depth;                            // Number of blocks being replayed
+    t_macro_frame stack[MACRO_STACK_DEPTH];
+} t_macros;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Start recording a macro definition from its DEFINE command (a previous one with the same name
+// is replaced)
+int8_t macro_define_start(t_macros* macros, const t_ducky_cmd* cmd);
+
+// Start recording a loop block from its LOOP command (or a nested one inside the block being
+// recorded)
+int8_t macro_loop_start(t_macros* macros, const t_ducky_cmd* cmd);
+
+// Record a CALL command in the block being recorded, or start replaying the called macro
+int8_t macro_call(t_macros* macros, const t_ducky_cmd* cmd);
+
+// Append a compiled command to the block being recorded
+int8_t macro_record(t_macros* macros, const t_ducky_cmd* cmd);
+
+// Abort recording the block being recorded (previous definitions are kept)
+void macro_record_abort(t_macros* macros);
+
+// Close the innermost block being recorded (a top level loop starts to be replayed)
+int8_t macro_end(t_macros* macros);
+
+// Check if macros are being replayed
+bool macro_running(const t_macros* macros);
+
+// Get next command to be executed of the macros being replayed
+// Returns RC_BAD once they end and RC_INVALID_INPUT if replay is stopped by an error
+int8_t macro_run_next(t_macros* macros, t_ducky_cmd* cmd);
+
+/**************************************************************************************************/
+
+#endif
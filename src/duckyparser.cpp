@@ -0,0 +1,450 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckyparser.cpp                                                                            */
+/* Description:                                                                                   */
+/*     Single pass Ducky Script line tokenizer and compiler into pre-parsed command records.      */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "duckyparser.h"
+#include "duckykeys.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Modifier bits of commands fixed modifiers
+#define BIT_CTRL MOD_BIT(MOD_CONTROL_LEFT)
+#define BIT_SHIFT MOD_BIT(MOD_SHIFT_LEFT)
+#define BIT_ALT MOD_BIT(MOD_ALT_LEFT)
+#define BIT_GUI MOD_BIT(MOD_GUI_LEFT)
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Command compilation information
+typedef struct
+{
+    uint8_t arg_type;
+    uint8_t modifiers;  // Fixed modifier keys bitmask of the command
+    uint8_t key;        // Fixed key of the command or 0 if unused
+} t_ducky_cmd_info;
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Commands compilation information, indexed by command ID (stored in flash)
+static const t_ducky_cmd_info DUCKY_CMDS[CMD_NUM] PROGMEM =
+{
+    { ARG_KEYWORD_KEY, 0, 0 },                                    // CMD_KEY
+    { ARG_NONE, 0, 0 },                                           // CMD_REM
+    { ARG_NUM, 0, 0 },                                            // CMD_REPEAT
+    { ARG_NUM, 0, 0 },                                            // CMD_DEFAULT_DELAY
+    { ARG_NUM, 0, 0 },                                            // CMD_DELAY
+    { ARG_TEXT, 0, 0 },                                           // CMD_STRING
+    { ARG_NUM_TEXT, 0, 0 },                                       // CMD_STRING_DELAY
+    { ARG_KEY, BIT_CTRL | BIT_ALT, 0 },                           // CMD_CTRL_ALT
+    { ARG_KEY, BIT_CTRL | BIT_SHIFT, 0 },                         // CMD_CTRL_SHIFT
+    { ARG_KEY, BIT_ALT | BIT_SHIFT, 0 },                          // CMD_ALT_SHIFT
+    { ARG_NONE, BIT_ALT, KEY_TAB },                               // CMD_ALT_TAB
+    { ARG_KEY, BIT_GUI | BIT_ALT, 0 },                            // CMD_COMMAND_OPTION
+    { ARG_KEY, BIT_GUI, 0 },                                      // CMD_GUI
+    { ARG_KEY, BIT_CTRL, 0 },                                     // CMD_CTRL
+    { ARG_KEY, BIT_ALT, 0 },                                      // CMD_ALT
+    { ARG_KEY, BIT_SHIFT, 0 },                                    // CMD_SHIFT
+    { ARG_NONE, 0, 0 },                                           // CMD_STORE
+    { ARG_NONE, 0, 0 },                                           // CMD_STORE_BOOT
+    { ARG_NONE, 0, 0 },                                           // CMD_END
+    { ARG_NONE, 0, 0 },                                           // CMD_RUN
+    { ARG_NONE, 0, 0 },                                           // CMD_MEMSTATS
+    { ARG_NONE, 0, 0 },                                           // CMD_STATS
+    { ARG_NONE, 0, 0 },                                           // CMD_RESETSTATS
+    { ARG_TEXT, 0, 0 },                                           // CMD_DEFINE
+    { ARG_NUM, 0, 0 },                                            // CMD_LOOP
+    { ARG_TEXT, 0, 0 },                                           // CMD_CALL
+    { ARG_TEXT, 0, 0 },                                           // CMD_LAYOUT
+    { ARG_CHORD, 0, 0 },                                          // CMD_CHORD
+    { ARG_NUM, 0, 0 },                                            // CMD_ADAPTIVE_DELAY
+    { ARG_TEXT, 0, 0 }                                            // CMD_STRING_PART
+};
+
+// Command keywords table (stored in flash)
+// Note: Entries must be kept sorted in strcmp() order, the table is binary searched
+static const t_ducky_name DUCKY_KEYWORDS[] PROGMEM =
+{
+    { "ADAPTIVE_DELAY", CMD_ADAPTIVE_DELAY },
+    { "ALT", CMD_ALT },
+    { "ALT-SHIFT", CMD_ALT_SHIFT },
+    { "ALT-TAB", CMD_ALT_TAB },
+    { "CALL", CMD_CALL },
+    { "COMMAND", CMD_GUI },
+    { "COMMAND-OPTION", CMD_COMMAND_OPTION },
+    { "CONTROL", CMD_CTRL },
+    { "CTRL", CMD_CTRL },
+    { "CTRL-ALT", CMD_CTRL_ALT },
+    { "CTRL-SHIFT", CMD_CTRL_SHIFT },
+    { "DEFAULTDELAY", CMD_DEFAULT_DELAY },
+    { "DEFAULT_DELAY", CMD_DEFAULT_DELAY },
+    { "DEFINE", CMD_DEFINE },
+    { "DELAY", CMD_DELAY },
+    { "END", CMD_END },
+    { "GUI", CMD_GUI },
+    { "LAYOUT", CMD_LAYOUT },
+    { "LOOP", CMD_LOOP },
+    { "MEMSTATS", CMD_MEMSTATS },
+    { "REM", CMD_REM },
+    { "REPEAT", CMD_REPEAT },
+    { "RESETSTATS", CMD_RESETSTATS },
+    { "RUN", CMD_RUN },
+    { "SHIFT", CMD_SHIFT },
+    { "STATS", CMD_STATS },
+    { "STORE", CMD_STORE },
+    { "STORE_BOOT", CMD_STORE_BOOT },
+    { "STRING", CMD_STRING },
+    { "STRING_DELAY", CMD_STRING_DELAY },
+    { "WINDOWS", CMD_GUI }
+};
+
+// Number of elements of command keywords table
+#define DUCKY_KEYWORDS_N (sizeof(DUCKY_KEYWORDS)/sizeof(DUCKY_KEYWORDS[0]))
+
+// Modifier names table of key combinations (stored in flash)
+// Note: Entries must be kept sorted in strcmp() order, the table is binary searched
+static const t_ducky_name DUCKY_MODIFIERS[] PROGMEM =
+{
+    { "ALT", BIT_ALT },
+    { "COMMAND", BIT_GUI },
+    { "CONTROL", BIT_CTRL },
+    { "CTRL", BIT_CTRL },
+    { "GUI", BIT_GUI },
+    { "OPTION", BIT_ALT },
+    { "SHIFT", BIT_SHIFT },
+    { "WINDOWS", BIT_GUI }
+};
+
+// Number of elements of modifier names table
+#define DUCKY_MODIFIERS_N (sizeof(DUCKY_MODIFIERS)/sizeof(DUCKY_MODIFIERS[0]))
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions Prototypes */
+
+// Check if a character is a words separator
+static inline bool is_separator(const char c);
+
+// Get the command ID that corresponds to a keyword
+static uint8_t keyword_to_cmd(const char* keyword, const uint16_t keyword_len);
+
+// Copy a text span into a command text payload
+static int8_t copy_text(const t_span* text, t_ducky_cmd* cmd);
+
+// Get the modifiers bitmask of a word of modifier names joined by '-' (0 if it is not one)
+static uint8_t word_to_modifiers(const char* word, const uint16_t word_len);
+
+// Compile the words of a key combination (modifiers and an optional last key) into a command
+static int8_t compile_chord(const char* text, const uint16_t text_len, t_ducky_cmd* cmd);
+
+/**************************************************************************************************/
+
+/* Parser Functions */
+
+// Tokenize a Ducky Script line into command ID and argument spans
+// The line is scanned just once, each word is stored as a span pointing into the line buffer
+int8_t ducky_parse_line(const char* line, const uint16_t line_length, t_ducky_line* parsed)
+{
+    uint16_t i = 0;
+    uint16_t word_start = 0;
+    uint8_t words = 0;
+    bool in_word = false;
+    bool end = false;
+
+    memset(parsed, 0, sizeof(t_ducky_line));
+
+    for(i = 0; ; i++)
+    {
+        // Check if end of line or end of string detected
+        end = ((i >= line_length) || (line[i] == '\0'));
+
+        // Word start
+        if(!end && !is_separator(line[i]))
+        {
+            if(!in_word)
+            {
+                in_word = true;
+                word_start = i;
+            }
+            continue;
+        }
+
+        // Word end
+        if(in_word)
+        {
+            in_word = false;
+            if(words == 0)
+            {
+                // First word, resolve the command and point arguments text after the separator
+                parsed->keyword.ptr = &(line[word_start]);
+                parsed->keyword.len = i - word_start;
+                parsed->cmd = keyword_to_cmd(parsed->keyword.ptr, parsed->keyword.len);
+                parsed->args.ptr = (end) ? &(line[i]) : &(line[i+1]);
+
+                // Comments arguments are not needed
+                if(parsed->cmd == CMD_REM)
+                    return RC_OK;
+            }
+            else if(words <= DUCKY_MAX_ARGS)
+            {
+                parsed->argv[words-1].ptr = &(line[word_start]);
+                parsed->argv[words-1].len = i - word_start;
+            }
+            words = words + 1;
+        }
+
+        if(end)
+            break;
+    }
+
+    // Check for empty line
+    if(words == 0)
+        return RC_BAD;
+
+    parsed->argc = words - 1;
+    if(parsed->args.ptr < &(line[i]))
+        parsed->args.len = &(line[i]) - parsed->args.ptr;
+
+    return RC_OK;
+}
+
+// Get the text of a span that goes from a given argument until the end of the line
+// Note: The text starts just after the separator that ends the previous argument word
+t_span ducky_args_from(const t_ducky_line* parsed, const uint8_t arg_index)
+{
+    t_span span = { NULL, 0 };
+    const char* end = parsed->args.ptr + parsed->args.len;
+
+    if(arg_index == 0)
+        return parsed->args;
+
+    if((arg_index > DUCKY_MAX_ARGS) || (arg_index >= parsed->argc))
+        return span;
+
+    span.ptr = parsed->argv[arg_index-1].ptr + parsed->argv[arg_index-1].len + 1;
+    if(span.ptr < end)
+        span.len = end - span.ptr;
+    else
+        span.ptr = end;
+
+    return span;
+}
+
+// Check if a command ID is a device control command (handled on reception, never queued)
+bool ducky_cmd_is_control(const uint8_t cmd_id)
+{
+    return ((cmd_id >= CMD_STORE) && (cmd_id <= CMD_CALL));
+}
+
+// Initialize a command record with its command ID fixed keys and get its arguments type
+uint8_t ducky_cmd_init(const uint8_t cmd_id, t_ducky_cmd* cmd)
+{
+    t_ducky_cmd_info info;
+
+    memcpy_P(&info, &(DUCKY_CMDS[cmd_id]), sizeof(t_ducky_cmd_info));
+    cmd->cmd = cmd_id;
+    cmd->modifiers = info.modifiers;
+    cmd->key = info.key;
+    cmd->num = 0;
+    cmd->text_len = 0;
+
+    return info.arg_type;
+}
+
+// Compile a tokenized Ducky Script line into a command record (HID codes and copied payload)
+// The record does not point to the line, so the line buffer can be reused once compiled
+// Key combinations with more modifiers than the command keyword ones (i.e. "CTRL ALT SHIFT t")
+// or starting with modifiers that are not a command keyword (i.e. "GUI-SHIFT s") are compiled
+// into a CHORD command
+int8_t ducky_compile(const t_ducky_line* parsed, t_ducky_cmd* cmd)
+{
+    t_span text;
+    uint8_t modifiers = 0;
+
+    switch(ducky_cmd_init(parsed->cmd, cmd))
+    {
+        case ARG_NUM:
+            if(parsed->argc == 0)
+                return RC_BAD;
+            return safe_atoi_u32(parsed->argv[0].ptr, parsed->argv[0].len, &(cmd->num), false);
+
+        case ARG_KEY:
+            modifiers = cmd->modifiers;
+            if(compile_chord(parsed->args.ptr, parsed->args.len, cmd) != RC_OK)
+                return RC_BAD;
+            if(cmd->modifiers != modifiers)
+                cmd->cmd = CMD_CHORD;
+            return RC_OK;
+
+        case ARG_TEXT:
+            if(parsed->argc == 0)
+                return RC_BAD;
+            return copy_text(&(parsed->args), cmd);
+
+        case ARG_NUM_TEXT:
+            if(parsed->argc < 2)
+                return RC_BAD;
+            if(safe_atoi_u32(parsed->argv[0].ptr, parsed->argv[0].len, &(cmd->num), false) != RC_OK)
+                return RC_BAD;
+            text = ducky_args_from(parsed, 1);
+            return copy_text(&text, cmd);
+
+        case ARG_KEYWORD_KEY:
+            cmd->key = ducky_key_to_hid_byte(parsed->keyword.ptr, parsed->keyword.len);
+            if(cmd->key != KEY_UNDEFINED_ERROR)
+                return RC_OK;
+            if(word_to_modifiers(parsed->keyword.ptr, parsed->keyword.len) == 0)
+                return RC_BAD;
+            cmd->cmd = CMD_CHORD;
+            cmd->key = 0;
+            return compile_chord(parsed->keyword.ptr,
+                parsed->args.ptr + parsed->args.len - parsed->keyword.ptr, cmd);
+
+        default:
+            return RC_OK;
+    }
+}
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Check if a character is a words separator
+static inline bool is_separator(const char c)
+{
+    return ((c == ' ') || (c == '\r') || (c == '\n'));
+}
+
+// Get the command ID that corresponds to a keyword
+static uint8_t keyword_to_cmd(const char* keyword, const uint16_t keyword_len)
+{
+    // Comment lines could be written without separator ("//comment")
+    if((keyword_len >= 2) && (keyword[0] == '/') && (keyword[1] == '/'))
+        return CMD_REM;
+
+    return ducky_name_lookup(DUCKY_KEYWORDS, DUCKY_KEYWORDS_N, keyword, keyword_len, CMD_KEY);
+}
+
+// Copy a text span into a command text payload
+static int8_t copy_text(const t_span* text, t_ducky_cmd* cmd)
+{
+    if((text->len == 0) || (text->len > DUCKY_TEXT_MAX_LENGTH))
+        return RC_INVALID_INPUT;
+
+    memcpy(cmd->text, text->ptr, text->len);
+    cmd->text_len = text->len;
+
+    return RC_OK;
+}
+
+// Get the modifiers bitmask of a word of modifier names joined by '-' (0 if it is not one)
+static uint8_t word_to_modifiers(const char* word, const uint16_t word_len)
+{
+    uint8_t modifiers = 0;
+    uint8_t modifier = 0;
+    uint16_t name_start = 0;
+
+    for(uint16_t i = 0; i <= word_len; i++)
+    {
+        if((i < word_len) && (word[i] != '-'))
+            continue;
+
+        modifier = ducky_name_lookup(DUCKY_MODIFIERS, DUCKY_MODIFIERS_N, &(word[name_start]),
+            i - name_start, 0);
+        if(modifier == 0)
+            return 0;
+        modifiers = modifiers | modifier;
+        name_start = i + 1;
+    }
+
+    return modifiers;
+}
+
+// Compile the words of a key combination (modifiers and an optional last key) into a command
+// Modifiers are added to the command ones, so all of them are sent in a single report
+static int8_t compile_chord(const char* text, const uint16_t text_len, t_ducky_cmd* cmd)
+{
+    uint16_t word_start = 0;
+    uint16_t word_len = 0;
+    uint8_t modifiers = 0;
+
+    for(uint16_t i = 0; i <= text_len; i++)
+    {
+        if((i < text_len) && !is_separator(text[i]))
+            continue;
+
+        word_len = i - word_start;
+        if(word_len > 0)
+        {
+            // Words following the key are ignored
+            if(cmd->key != 0)
+                return RC_OK;
+
+            modifiers = word_to_modifiers(&(text[word_start]), word_len);
+            if(modifiers != 0)
+                cmd->modifiers = cmd->modifiers | modifiers;
+            else
+            {
+                cmd->key = ducky_key_to_hid_byte(&(text[word_start]), word_len);
+                if(cmd->key == KEY_UNDEFINED_ERROR)
+                    return RC_BAD;
+            }
+        }
+        word_start = i + 1;
+    }
+
+    return RC_OK;
+}
+
+// Safe conversion a string number into uint32_t element
+int8_t safe_atoi_u32(const char* in_str, const size_t in_str_len, uint32_t* out_int, 
+    bool check_null_terminated)
+{
+	uint32_t converted_num;
+	uint8_t digit;
+
+	// Check if input str has less or more chars than expected uint32_t range (1 to 10 chars)
+	if((in_str_len < 1) || (in_str_len > 10))
+		return RC_INVALID_INPUT;
+
+	// Check if input str is not terminated
+    if(check_null_terminated)
+    {
+	    if(in_str[in_str_len] != '\0')
+		    return RC_INVALID_INPUT;
+    }
+
+	// Check if any of the character of the str is not a number
+	for(uint8_t i = 0; i < in_str_len; i++)
+	{
+		if(in_str[i] < '0' || in_str[i] > '9')
+			return RC_BAD;
+	}
+
+	// Create the int (using uint32_t arithmetic, size_t is just 16 bits wide on AVR)
+	converted_num = 0;
+	for(uint8_t i = 0; i < in_str_len; i++)
+	{
+		digit = in_str[i] - '0';
+
+		// Check if number is higher than max uint32_t val
+		if(converted_num > ((UINT32_MAX - digit) / 10))
+			return RC_BAD;
+
+		converted_num = (converted_num * 10) + digit;
+	}
+
+	// Get the converted number and return operation success
+	*out_int = converted_num;
+	return RC_OK;
+}
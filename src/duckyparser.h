@@ -0,0 +1,141 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckyparser.h                                                                              */
+/* Description:                                                                                   */
+/*     Single pass Ducky Script line tokenizer and compiler into pre-parsed command records.      */
+/**************************************************************************************************/
+
+#ifndef DUCKYPARSER_H_
+#define DUCKYPARSER_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "returncodes.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Maximum number of argument words that are tokenized (following words are kept in args span)
+#define DUCKY_MAX_ARGS 2
+
+// Maximum length of compiled commands text payload (STRING and STRING_DELAY)
+#define DUCKY_TEXT_MAX_LENGTH 64
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Ducky Script Commands IDs
+// IDs are also the bytecode opcodes (see duckybytecode.h) of host compiled streams, EEPROM stored
+// scripts and macros, so they are pinned and new commands are appended after the last one
+enum _ducky_commands
+{
+    CMD_KEY = 0,
+    CMD_REM = 1,
+    CMD_REPEAT = 2,
+    CMD_DEFAULT_DELAY = 3,
+    CMD_DELAY = 4,
+    CMD_STRING = 5,
+    CMD_STRING_DELAY = 6,
+    CMD_CTRL_ALT = 7,
+    CMD_CTRL_SHIFT = 8,
+    CMD_ALT_SHIFT = 9,
+    CMD_ALT_TAB = 10,
+    CMD_COMMAND_OPTION = 11,
+    CMD_GUI = 12,
+    CMD_CTRL = 13,
+    CMD_ALT = 14,
+    CMD_SHIFT = 15,
+
+    // Device control commands (handled on reception, never queued)
+    CMD_STORE = 16,
+    CMD_STORE_BOOT = 17,
+    CMD_END = 18,
+    CMD_RUN = 19,
+    CMD_MEMSTATS = 20,
+    CMD_STATS = 21,
+    CMD_RESETSTATS = 22,
+    CMD_DEFINE = 23,
+    CMD_LOOP = 24,
+    CMD_CALL = 25,
+
+    CMD_LAYOUT = 26,
+    CMD_CHORD = 27,
+    CMD_ADAPTIVE_DELAY = 28,
+    CMD_STRING_PART = 29,  // Streamed STRING line text part (no keyword, more parts follow)
+    CMD_NUM
+};
+
+// Number of device control commands (CMD_STORE to CMD_CALL)
+#define CMD_CONTROL_NUM (CMD_CALL - CMD_STORE + 1)
+
+// Commands arguments types
+enum _ducky_arg_types
+{
+    ARG_NONE = 0,       // Arguments ignored
+    ARG_NUM,            // Number
+    ARG_KEY,            // Optional key name
+    ARG_TEXT,           // Text until end of line
+    ARG_NUM_TEXT,       // Number followed by text until end of line
+    ARG_KEYWORD_KEY,    // The keyword itself is a key name
+    ARG_CHORD           // Any modifiers combination and an optional key
+};
+
+// Span of characters inside a line buffer (not null terminated)
+typedef struct
+{
+    const char* ptr;
+    uint16_t len;
+} t_span;
+
+// Tokenized Ducky Script line
+typedef struct
+{
+    uint8_t cmd;                  // Command ID
+    uint8_t argc;                 // Number of arguments words
+    t_span keyword;               // First word of the line (command keyword or key name)
+    t_span argv[DUCKY_MAX_ARGS];  // First arguments words
+    t_span args;                  // Raw text following the keyword separator space
+} t_ducky_line;
+
+// Compiled (pre-parsed) Ducky Script command
+typedef struct
+{
+    uint8_t cmd;                              // Command ID
+    uint8_t modifiers;                        // Modifier keys bitmask (MOD_BIT() of each one)
+    uint8_t key;                              // HID key code or 0 if unused
+    uint32_t num;                             // Numeric argument (delays and repeat count)
+    uint8_t text_len;                         // Text payload length
+    char text[DUCKY_TEXT_MAX_LENGTH];         // Text payload (STRING and STRING_DELAY)
+} t_ducky_cmd;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Tokenize a Ducky Script line into command ID and argument spans
+int8_t ducky_parse_line(const char* line, const uint16_t line_length, t_ducky_line* parsed);
+
+// Get the text of a span that goes from a given argument until the end of the line
+t_span ducky_args_from(const t_ducky_line* parsed, const uint8_t arg_index);
+
+// Check if a command ID is a device control command (handled on reception, never queued)
+bool ducky_cmd_is_control(const uint8_t cmd_id);
+
+// Initialize a command record with its command ID fixed keys and get its arguments type
+uint8_t ducky_cmd_init(const uint8_t cmd_id, t_ducky_cmd* cmd);
+
+// Compile a tokenized Ducky Script line into a command record (HID codes and copied payload)
+int8_t ducky_compile(const t_ducky_line* parsed, t_ducky_cmd* cmd);
+
+// Safe conversion a string number into uint32_t element
+int8_t safe_atoi_u32(const char* in_str, const size_t in_str_len, uint32_t* out_int, 
+    bool check_null_terminated=true);
+
+/**************************************************************************************************/
+
+#endif
@@ -15,6 +15,9 @@
 #define MOD_ALT_RIGHT        0xE6
 #define MOD_GUI_RIGHT        0xE7
 
+// Modifier bit in a modifiers bitmask (same bits as the report modifiers byte)
+#define MOD_BIT(mod)         (1 << ((mod) - MOD_CONTROL_LEFT))
+
 // Special Keys
 #define KEY_APP              0x65
 #define KEY_POWER            0x66
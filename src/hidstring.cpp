@@ -0,0 +1,345 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     hidstring.cpp                                                                              */
+/* Description:                                                                                   */
+/*     Text typing through raw boot keyboard reports, packing several characters per report.      */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <HID-Project.h>
+#include "hidkeys.h"
+#include "duckykeys.h"
+#include "hidstring.h"
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Run of distinct keys that share the same modifiers, to be sent in a single report
+typedef struct
+{
+    uint8_t keys[HID_REPORT_KEYS];
+    uint8_t keys_n;
+    uint8_t modifiers;
+    uint16_t reports;  // Number of sent reports
+} t_hid_run;
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Keyboard layouts names table (stored in flash)
+// Note: Entries must be kept sorted in strcmp() order, the table is binary searched
+static const t_ducky_name HID_LAYOUT_NAMES[] PROGMEM =
+{
+    { "DE", HID_LAYOUT_DE },
+    { "ES", HID_LAYOUT_ES },
+    { "FR", HID_LAYOUT_FR },
+    { "UK", HID_LAYOUT_UK },
+    { "US", HID_LAYOUT_US }
+};
+
+// Number of elements of keyboard layouts names table
+#define HID_LAYOUT_NAMES_N (sizeof(HID_LAYOUT_NAMES)/sizeof(HID_LAYOUT_NAMES[0]))
+
+// ASCII to keystroke maps of each keyboard layout, indexed by character (stored in flash)
+// Windows layouts, dead keys are flagged in the modifiers
+static const t_hid_keystroke HID_KEYMAPS[HID_LAYOUT_NUM][128] PROGMEM =
+{
+    // US
+    {
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 00 - 03
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 04 - 07
+        { 0x00, 0x2A }, { 0x00, 0x2B }, { 0x00, 0x28 }, { 0x00, 0x00 },  // 08 - 0B
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 0C - 0F
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 10 - 13
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 14 - 17
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x29 },  // 18 - 1B
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 1C - 1F
+        { 0x00, 0x2C }, { 0x02, 0x1E }, { 0x02, 0x34 }, { 0x02, 0x20 },  // ' ' '!' '"' '#'
+        { 0x02, 0x21 }, { 0x02, 0x22 }, { 0x02, 0x24 }, { 0x00, 0x34 },  // '$' '%' '&' '\''
+        { 0x02, 0x26 }, { 0x02, 0x27 }, { 0x02, 0x25 }, { 0x02, 0x2E },  // '(' ')' '*' '+'
+        { 0x00, 0x36 }, { 0x00, 0x2D }, { 0x00, 0x37 }, { 0x00, 0x38 },  // ',' '-' '.' '/'
+        { 0x00, 0x27 }, { 0x00, 0x1E }, { 0x00, 0x1F }, { 0x00, 0x20 },  // '0' '1' '2' '3'
+        { 0x00, 0x21 }, { 0x00, 0x22 }, { 0x00, 0x23 }, { 0x00, 0x24 },  // '4' '5' '6' '7'
+        { 0x00, 0x25 }, { 0x00, 0x26 }, { 0x02, 0x33 }, { 0x00, 0x33 },  // '8' '9' ':' ';'
+        { 0x02, 0x36 }, { 0x00, 0x2E }, { 0x02, 0x37 }, { 0x02, 0x38 },  // '<' '=' '>' '?'
+        { 0x02, 0x1F }, { 0x02, 0x04 }, { 0x02, 0x05 }, { 0x02, 0x06 },  // '@' 'A' 'B' 'C'
+        { 0x02, 0x07 }, { 0x02, 0x08 }, { 0x02, 0x09 }, { 0x02, 0x0A },  // 'D' 'E' 'F' 'G'
+        { 0x02, 0x0B }, { 0x02, 0x0C }, { 0x02, 0x0D }, { 0x02, 0x0E },  // 'H' 'I' 'J' 'K'
+        { 0x02, 0x0F }, { 0x02, 0x10 }, { 0x02, 0x11 }, { 0x02, 0x12 },  // 'L' 'M' 'N' 'O'
+        { 0x02, 0x13 }, { 0x02, 0x14 }, { 0x02, 0x15 }, { 0x02, 0x16 },  // 'P' 'Q' 'R' 'S'
+        { 0x02, 0x17 }, { 0x02, 0x18 }, { 0x02, 0x19 }, { 0x02, 0x1A },  // 'T' 'U' 'V' 'W'
+        { 0x02, 0x1B }, { 0x02, 0x1C }, { 0x02, 0x1D }, { 0x00, 0x2F },  // 'X' 'Y' 'Z' '['
+        { 0x00, 0x31 }, { 0x00, 0x30 }, { 0x02, 0x23 }, { 0x02, 0x2D },  // '\\' ']' '^' '_'
+        { 0x00, 0x35 }, { 0x00, 0x04 }, { 0x00, 0x05 }, { 0x00, 0x06 },  // '`' 'a' 'b' 'c'
+        { 0x00, 0x07 }, { 0x00, 0x08 }, { 0x00, 0x09 }, { 0x00, 0x0A },  // 'd' 'e' 'f' 'g'
+        { 0x00, 0x0B }, { 0x00, 0x0C }, { 0x00, 0x0D }, { 0x00, 0x0E },  // 'h' 'i' 'j' 'k'
+        { 0x00, 0x0F }, { 0x00, 0x10 }, { 0x00, 0x11 }, { 0x00, 0x12 },  // 'l' 'm' 'n' 'o'
+        { 0x00, 0x13 }, { 0x00, 0x14 }, { 0x00, 0x15 }, { 0x00, 0x16 },  // 'p' 'q' 'r' 's'
+        { 0x00, 0x17 }, { 0x00, 0x18 }, { 0x00, 0x19 }, { 0x00, 0x1A },  // 't' 'u' 'v' 'w'
+        { 0x00, 0x1B }, { 0x00, 0x1C }, { 0x00, 0x1D }, { 0x02, 0x2F },  // 'x' 'y' 'z' '{'
+        { 0x02, 0x31 }, { 0x02, 0x30 }, { 0x02, 0x35 }, { 0x00, 0x00 }  // '|' '}' '~' 7F
+    },
+    // UK
+    {
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 00 - 03
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 04 - 07
+        { 0x00, 0x2A }, { 0x00, 0x2B }, { 0x00, 0x28 }, { 0x00, 0x00 },  // 08 - 0B
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 0C - 0F
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 10 - 13
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 14 - 17
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x29 },  // 18 - 1B
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 1C - 1F
+        { 0x00, 0x2C }, { 0x02, 0x1E }, { 0x02, 0x1F }, { 0x00, 0x31 },  // ' ' '!' '"' '#'
+        { 0x02, 0x21 }, { 0x02, 0x22 }, { 0x02, 0x24 }, { 0x00, 0x34 },  // '$' '%' '&' '\''
+        { 0x02, 0x26 }, { 0x02, 0x27 }, { 0x02, 0x25 }, { 0x02, 0x2E },  // '(' ')' '*' '+'
+        { 0x00, 0x36 }, { 0x00, 0x2D }, { 0x00, 0x37 }, { 0x00, 0x38 },  // ',' '-' '.' '/'
+        { 0x00, 0x27 }, { 0x00, 0x1E }, { 0x00, 0x1F }, { 0x00, 0x20 },  // '0' '1' '2' '3'
+        { 0x00, 0x21 }, { 0x00, 0x22 }, { 0x00, 0x23 }, { 0x00, 0x24 },  // '4' '5' '6' '7'
+        { 0x00, 0x25 }, { 0x00, 0x26 }, { 0x02, 0x33 }, { 0x00, 0x33 },  // '8' '9' ':' ';'
+        { 0x02, 0x36 }, { 0x00, 0x2E }, { 0x02, 0x37 }, { 0x02, 0x38 },  // '<' '=' '>' '?'
+        { 0x02, 0x34 }, { 0x02, 0x04 }, { 0x02, 0x05 }, { 0x02, 0x06 },  // '@' 'A' 'B' 'C'
+        { 0x02, 0x07 }, { 0x02, 0x08 }, { 0x02, 0x09 }, { 0x02, 0x0A },  // 'D' 'E' 'F' 'G'
+        { 0x02, 0x0B }, { 0x02, 0x0C }, { 0x02, 0x0D }, { 0x02, 0x0E },  // 'H' 'I' 'J' 'K'
+        { 0x02, 0x0F }, { 0x02, 0x10 }, { 0x02, 0x11 }, { 0x02, 0x12 },  // 'L' 'M' 'N' 'O'
+        { 0x02, 0x13 }, { 0x02, 0x14 }, { 0x02, 0x15 }, { 0x02, 0x16 },  // 'P' 'Q' 'R' 'S'
+        { 0x02, 0x17 }, { 0x02, 0x18 }, { 0x02, 0x19 }, { 0x02, 0x1A },  // 'T' 'U' 'V' 'W'
+        { 0x02, 0x1B }, { 0x02, 0x1C }, { 0x02, 0x1D }, { 0x00, 0x2F },  // 'X' 'Y' 'Z' '['
+        { 0x00, 0x64 }, { 0x00, 0x30 }, { 0x02, 0x23 }, { 0x02, 0x2D },  // '\\' ']' '^' '_'
+        { 0x00, 0x35 }, { 0x00, 0x04 }, { 0x00, 0x05 }, { 0x00, 0x06 },  // '`' 'a' 'b' 'c'
+        { 0x00, 0x07 }, { 0x00, 0x08 }, { 0x00, 0x09 }, { 0x00, 0x0A },  // 'd' 'e' 'f' 'g'
+        { 0x00, 0x0B }, { 0x00, 0x0C }, { 0x00, 0x0D }, { 0x00, 0x0E },  // 'h' 'i' 'j' 'k'
+        { 0x00, 0x0F }, { 0x00, 0x10 }, { 0x00, 0x11 }, { 0x00, 0x12 },  // 'l' 'm' 'n' 'o'
+        { 0x00, 0x13 }, { 0x00, 0x14 }, { 0x00, 0x15 }, { 0x00, 0x16 },  // 'p' 'q' 'r' 's'
+        { 0x00, 0x17 }, { 0x00, 0x18 }, { 0x00, 0x19 }, { 0x00, 0x1A },  // 't' 'u' 'v' 'w'
+        { 0x00, 0x1B }, { 0x00, 0x1C }, { 0x00, 0x1D }, { 0x02, 0x2F },  // 'x' 'y' 'z' '{'
+        { 0x02, 0x64 }, { 0x02, 0x30 }, { 0x02, 0x31 }, { 0x00, 0x00 }  // '|' '}' '~' 7F
+    },
+    // DE
+    {
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 00 - 03
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 04 - 07
+        { 0x00, 0x2A }, { 0x00, 0x2B }, { 0x00, 0x28 }, { 0x00, 0x00 },  // 08 - 0B
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 0C - 0F
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 10 - 13
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 14 - 17
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x29 },  // 18 - 1B
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 1C - 1F
+        { 0x00, 0x2C }, { 0x02, 0x1E }, { 0x02, 0x1F }, { 0x00, 0x31 },  // ' ' '!' '"' '#'
+        { 0x02, 0x21 }, { 0x02, 0x22 }, { 0x02, 0x23 }, { 0x02, 0x31 },  // '$' '%' '&' '\''
+        { 0x02, 0x25 }, { 0x02, 0x26 }, { 0x02, 0x30 }, { 0x00, 0x30 },  // '(' ')' '*' '+'
+        { 0x00, 0x36 }, { 0x00, 0x38 }, { 0x00, 0x37 }, { 0x02, 0x24 },  // ',' '-' '.' '/'
+        { 0x00, 0x27 }, { 0x00, 0x1E }, { 0x00, 0x1F }, { 0x00, 0x20 },  // '0' '1' '2' '3'
+        { 0x00, 0x21 }, { 0x00, 0x22 }, { 0x00, 0x23 }, { 0x00, 0x24 },  // '4' '5' '6' '7'
+        { 0x00, 0x25 }, { 0x00, 0x26 }, { 0x02, 0x37 }, { 0x02, 0x36 },  // '8' '9' ':' ';'
+        { 0x00, 0x64 }, { 0x02, 0x27 }, { 0x02, 0x64 }, { 0x02, 0x2D },  // '<' '=' '>' '?'
+        { 0x40, 0x14 }, { 0x02, 0x04 }, { 0x02, 0x05 }, { 0x02, 0x06 },  // '@' 'A' 'B' 'C'
+        { 0x02, 0x07 }, { 0x02, 0x08 }, { 0x02, 0x09 }, { 0x02, 0x0A },  // 'D' 'E' 'F' 'G'
+        { 0x02, 0x0B }, { 0x02, 0x0C }, { 0x02, 0x0D }, { 0x02, 0x0E },  // 'H' 'I' 'J' 'K'
+        { 0x02, 0x0F }, { 0x02, 0x10 }, { 0x02, 0x11 }, { 0x02, 0x12 },  // 'L' 'M' 'N' 'O'
+        { 0x02, 0x13 }, { 0x02, 0x14 }, { 0x02, 0x15 }, { 0x02, 0x16 },  // 'P' 'Q' 'R' 'S'
+        { 0x02, 0x17 }, { 0x02, 0x18 }, { 0x02, 0x19 }, { 0x02, 0x1A },  // 'T' 'U' 'V' 'W'
+        { 0x02, 0x1B }, { 0x02, 0x1D }, { 0x02, 0x1C }, { 0x40, 0x25 },  // 'X' 'Y' 'Z' '['
+        { 0x40, 0x2D }, { 0x40, 0x26 }, { 0x80, 0x35 }, { 0x02, 0x38 },  // '\\' ']' '^' '_'
+        { 0x82, 0x2E }, { 0x00, 0x04 }, { 0x00, 0x05 }, { 0x00, 0x06 },  // '`' 'a' 'b' 'c'
+        { 0x00, 0x07 }, { 0x00, 0x08 }, { 0x00, 0x09 }, { 0x00, 0x0A },  // 'd' 'e' 'f' 'g'
+        { 0x00, 0x0B }, { 0x00, 0x0C }, { 0x00, 0x0D }, { 0x00, 0x0E },  // 'h' 'i' 'j' 'k'
+        { 0x00, 0x0F }, { 0x00, 0x10 }, { 0x00, 0x11 }, { 0x00, 0x12 },  // 'l' 'm' 'n' 'o'
+        { 0x00, 0x13 }, { 0x00, 0x14 }, { 0x00, 0x15 }, { 0x00, 0x16 },  // 'p' 'q' 'r' 's'
+        { 0x00, 0x17 }, { 0x00, 0x18 }, { 0x00, 0x19 }, { 0x00, 0x1A },  // 't' 'u' 'v' 'w'
+        { 0x00, 0x1B }, { 0x00, 0x1D }, { 0x00, 0x1C }, { 0x40, 0x24 },  // 'x' 'y' 'z' '{'
+        { 0x40, 0x64 }, { 0x40, 0x27 }, { 0x40, 0x30 }, { 0x00, 0x00 }  // '|' '}' '~' 7F
+    },
+    // FR
+    {
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 00 - 03
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 04 - 07
+        { 0x00, 0x2A }, { 0x00, 0x2B }, { 0x00, 0x28 }, { 0x00, 0x00 },  // 08 - 0B
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 0C - 0F
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 10 - 13
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 14 - 17
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x29 },  // 18 - 1B
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 1C - 1F
+        { 0x00, 0x2C }, { 0x00, 0x38 }, { 0x00, 0x20 }, { 0x40, 0x20 },  // ' ' '!' '"' '#'
+        { 0x00, 0x30 }, { 0x02, 0x34 }, { 0x00, 0x1E }, { 0x00, 0x21 },  // '$' '%' '&' '\''
+        { 0x00, 0x22 }, { 0x00, 0x2D }, { 0x00, 0x31 }, { 0x02, 0x2E },  // '(' ')' '*' '+'
+        { 0x00, 0x10 }, { 0x00, 0x23 }, { 0x02, 0x36 }, { 0x02, 0x37 },  // ',' '-' '.' '/'
+        { 0x02, 0x27 }, { 0x02, 0x1E }, { 0x02, 0x1F }, { 0x02, 0x20 },  // '0' '1' '2' '3'
+        { 0x02, 0x21 }, { 0x02, 0x22 }, { 0x02, 0x23 }, { 0x02, 0x24 },  // '4' '5' '6' '7'
+        { 0x02, 0x25 }, { 0x02, 0x26 }, { 0x00, 0x37 }, { 0x00, 0x36 },  // '8' '9' ':' ';'
+        { 0x00, 0x64 }, { 0x00, 0x2E }, { 0x02, 0x64 }, { 0x02, 0x10 },  // '<' '=' '>' '?'
+        { 0x40, 0x27 }, { 0x02, 0x14 }, { 0x02, 0x05 }, { 0x02, 0x06 },  // '@' 'A' 'B' 'C'
+        { 0x02, 0x07 }, { 0x02, 0x08 }, { 0x02, 0x09 }, { 0x02, 0x0A },  // 'D' 'E' 'F' 'G'
+        { 0x02, 0x0B }, { 0x02, 0x0C }, { 0x02, 0x0D }, { 0x02, 0x0E },  // 'H' 'I' 'J' 'K'
+        { 0x02, 0x0F }, { 0x02, 0x33 }, { 0x02, 0x11 }, { 0x02, 0x12 },  // 'L' 'M' 'N' 'O'
+        { 0x02, 0x13 }, { 0x02, 0x04 }, { 0x02, 0x15 }, { 0x02, 0x16 },  // 'P' 'Q' 'R' 'S'
+        { 0x02, 0x17 }, { 0x02, 0x18 }, { 0x02, 0x19 }, { 0x02, 0x1D },  // 'T' 'U' 'V' 'W'
+        { 0x02, 0x1B }, { 0x02, 0x1C }, { 0x02, 0x1A }, { 0x40, 0x22 },  // 'X' 'Y' 'Z' '['
+        { 0x40, 0x25 }, { 0x40, 0x2D }, { 0x40, 0x26 }, { 0x00, 0x25 },  // '\\' ']' '^' '_'
+        { 0xC0, 0x24 }, { 0x00, 0x14 }, { 0x00, 0x05 }, { 0x00, 0x06 },  // '`' 'a' 'b' 'c'
+        { 0x00, 0x07 }, { 0x00, 0x08 }, { 0x00, 0x09 }, { 0x00, 0x0A },  // 'd' 'e' 'f' 'g'
+        { 0x00, 0x0B }, { 0x00, 0x0C }, { 0x00, 0x0D }, { 0x00, 0x0E },  // 'h' 'i' 'j' 'k'
+        { 0x00, 0x0F }, { 0x00, 0x33 }, { 0x00, 0x11 }, { 0x00, 0x12 },  // 'l' 'm' 'n' 'o'
+        { 0x00, 0x13 }, { 0x00, 0x04 }, { 0x00, 0x15 }, { 0x00, 0x16 },  // 'p' 'q' 'r' 's'
+        { 0x00, 0x17 }, { 0x00, 0x18 }, { 0x00, 0x19 }, { 0x00, 0x1D },  // 't' 'u' 'v' 'w'
+        { 0x00, 0x1B }, { 0x00, 0x1C }, { 0x00, 0x1A }, { 0x40, 0x21 },  // 'x' 'y' 'z' '{'
+        { 0x40, 0x23 }, { 0x40, 0x2E }, { 0xC0, 0x1F }, { 0x00, 0x00 }  // '|' '}' '~' 7F
+    },
+    // ES
+    {
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 00 - 03
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 04 - 07
+        { 0x00, 0x2A }, { 0x00, 0x2B }, { 0x00, 0x28 }, { 0x00, 0x00 },  // 08 - 0B
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 0C - 0F
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 10 - 13
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 14 - 17
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x29 },  // 18 - 1B
+        { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },  // 1C - 1F
+        { 0x00, 0x2C }, { 0x02, 0x1E }, { 0x02, 0x1F }, { 0x40, 0x20 },  // ' ' '!' '"' '#'
+        { 0x02, 0x21 }, { 0x02, 0x22 }, { 0x02, 0x23 }, { 0x00, 0x2D },  // '$' '%' '&' '\''
+        { 0x02, 0x25 }, { 0x02, 0x26 }, { 0x02, 0x30 }, { 0x00, 0x30 },  // '(' ')' '*' '+'
+        { 0x00, 0x36 }, { 0x00, 0x38 }, { 0x00, 0x37 }, { 0x02, 0x24 },  // ',' '-' '.' '/'
+        { 0x00, 0x27 }, { 0x00, 0x1E }, { 0x00, 0x1F }, { 0x00, 0x20 },  // '0' '1' '2' '3'
+        { 0x00, 0x21 }, { 0x00, 0x22 }, { 0x00, 0x23 }, { 0x00, 0x24 },  // '4' '5' '6' '7'
+        { 0x00, 0x25 }, { 0x00, 0x26 }, { 0x02, 0x37 }, { 0x02, 0x36 },  // '8' '9' ':' ';'
+        { 0x00, 0x64 }, { 0x02, 0x27 }, { 0x02, 0x64 }, { 0x02, 0x2D },  // '<' '=' '>' '?'
+        { 0x40, 0x1F }, { 0x02, 0x04 }, { 0x02, 0x05 }, { 0x02, 0x06 },  // '@' 'A' 'B' 'C'
+        { 0x02, 0x07 }, { 0x02, 0x08 }, { 0x02, 0x09 }, { 0x02, 0x0A },  // 'D' 'E' 'F' 'G'
+        { 0x02, 0x0B }, { 0x02, 0x0C }, { 0x02, 0x0D }, { 0x02, 0x0E },  // 'H' 'I' 'J' 'K'
+        { 0x02, 0x0F }, { 0x02, 0x10 }, { 0x02, 0x11 }, { 0x02, 0x12 },  // 'L' 'M' 'N' 'O'
+        { 0x02, 0x13 }, { 0x02, 0x14 }, { 0x02, 0x15 }, { 0x02, 0x16 },  // 'P' 'Q' 'R' 'S'
+        { 0x02, 0x17 }, { 0x02, 0x18 }, { 0x02, 0x19 }, { 0x02, 0x1A },  // 'T' 'U' 'V' 'W'
+        { 0x02, 0x1B }, { 0x02, 0x1C }, { 0x02, 0x1D }, { 0x40, 0x2F },  // 'X' 'Y' 'Z' '['
+        { 0x40, 0x35 }, { 0x40, 0x30 }, { 0x82, 0x2F }, { 0x02, 0x38 },  // '\\' ']' '^' '_'
+        { 0x80, 0x2F }, { 0x00, 0x04 }, { 0x00, 0x05 }, { 0x00, 0x06 },  // '`' 'a' 'b' 'c'
+        { 0x00, 0x07 }, { 0x00, 0x08 }, { 0x00, 0x09 }, { 0x00, 0x0A },  // 'd' 'e' 'f' 'g'
+        { 0x00, 0x0B }, { 0x00, 0x0C }, { 0x00, 0x0D }, { 0x00, 0x0E },  // 'h' 'i' 'j' 'k'
+        { 0x00, 0x0F }, { 0x00, 0x10 }, { 0x00, 0x11 }, { 0x00, 0x12 },  // 'l' 'm' 'n' 'o'
+        { 0x00, 0x13 }, { 0x00, 0x14 }, { 0x00, 0x15 }, { 0x00, 0x16 },  // 'p' 'q' 'r' 's'
+        { 0x00, 0x17 }, { 0x00, 0x18 }, { 0x00, 0x19 }, { 0x00, 0x1A },  // 't' 'u' 'v' 'w'
+        { 0x00, 0x1B }, { 0x00, 0x1C }, { 0x00, 0x1D }, { 0x40, 0x34 },  // 'x' 'y' 'z' '{'
+        { 0x40, 0x1E }, { 0x40, 0x31 }, { 0x40, 0x21 }, { 0x00, 0x00 }  // '|' '}' '~' 7F
+    }
+};
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+// Current keyboard layout
+static uint8_t layout = HID_LAYOUT_US;
+
+/**************************************************************************************************/
+
+/* Private Functions Prototypes */
+
+// Add a key to a run, sending the run first if the key can't be packed in it
+static void run_add(t_hid_run* run, const uint8_t modifiers, const uint8_t key);
+
+// Send a report with the keys of a run and release them with another one
+static void run_send(t_hid_run* run);
+
+/**************************************************************************************************/
+
+/* Functions */
+
+// Select the keyboard layout of the host by its name (i.e. "US", "DE")
+int8_t hid_layout_select(const char* name, const uint8_t name_len)
+{
+    uint8_t selected = ducky_name_lookup(HID_LAYOUT_NAMES, HID_LAYOUT_NAMES_N, name, name_len,
+        HID_LAYOUT_NUM);
+
+    if(selected == HID_LAYOUT_NUM)
+        return RC_INVALID_INPUT;
+    layout = selected;
+
+    return RC_OK;
+}
+
+// Get the keystroke that types an ASCII character in current keyboard layout
+t_hid_keystroke hid_ascii_to_keystroke(const char c)
+{
+    t_hid_keystroke keystroke = { 0, 0 };
+
+    if((uint8_t)c < 128)
+        memcpy_P(&keystroke, &(HID_KEYMAPS[layout][(uint8_t)c]), sizeof(t_hid_keystroke));
+
+    return keystroke;
+}
+
+// Type a text, packing runs of distinct keys that share modifiers into a single report
+// Keys are added to the report slots in typed order, which is the order the host reads them as
+// newly pressed keys. A run ends when modifiers change, a key repeats or the slots are full.
+// Return the number of sent reports
+uint16_t hid_string_write(const char* text, const uint8_t text_len)
+{
+    t_hid_run run;
+    t_hid_keystroke keystroke;
+
+    run.keys_n = 0;
+    run.modifiers = 0;
+    run.reports = 0;
+
+    for(uint8_t i = 0; i < text_len; i++)
+    {
+        keystroke = hid_ascii_to_keystroke(text[i]);
+        if(keystroke.key == 0)
+            continue;
+        run_add(&run, keystroke.modifiers & ~HID_KEYMAP_DEAD, keystroke.key);
+
+        // Dead keys need a following space to type their own character
+        if(keystroke.modifiers & HID_KEYMAP_DEAD)
+        {
+            run_send(&run);
+            run_add(&run, 0, KEY_SPACE);
+        }
+    }
+    run_send(&run);
+
+    return run.reports;
+}
+
+/**************************************************************************************************/
+
+/* Private Functions */
+
+// Add a key to a run, sending the run first if the key can't be packed in it
+static void run_add(t_hid_run* run, const uint8_t modifiers, const uint8_t key)
+{
+    bool end_run = (run->keys_n == HID_REPORT_KEYS) ||
+        ((run->keys_n > 0) && (modifiers != run->modifiers));
+
+    for(uint8_t i = 0; (i < run->keys_n) && !end_run; i++)
+    {
+        if(run->keys[i] == key)
+            end_run = true;
+    }
+    if(end_run)
+        run_send(run);
+
+    run->modifiers = modifiers;
+    run->keys[run->keys_n] = key;
+    run->keys_n = run->keys_n + 1;
+}
+
+// Send a report with the keys of a run and release them with another one
+static void run_send(t_hid_run* run)
+{
+    if(run->keys_n == 0)
+        return;
+
+    for(uint8_t i = 0; i < 8; i++)
+    {
+        if(run->modifiers & (1 << i))
+            Keyboard.add(KeyboardKeycode(MOD_CONTROL_LEFT + i));
+    }
+    for(uint8_t i = 0; i < run->keys_n; i++)
+        Keyboard.add(KeyboardKeycode(run->keys[i]));
+    Keyboard.send();
+    Keyboard.releaseAll();
+
+    run->keys_n = 0;
+    run->reports = run->reports + 2;
+}
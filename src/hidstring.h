@@ -0,0 +1,70 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     hidstring.h                                                                                */
+/* Description:                                                                                   */
+/*     Text typing through raw boot keyboard reports, packing several characters per report.      */
+/**************************************************************************************************/
+
+#ifndef HIDSTRING_H_
+#define HIDSTRING_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "returncodes.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Number of key slots of a boot keyboard report
+#define HID_REPORT_KEYS 6
+
+// Keymap modifiers (report modifiers bitmask) used to type characters
+#define HID_KEYMAP_SHIFT 0x02  // Left Shift
+#define HID_KEYMAP_ALTGR 0x40  // Right Alt
+
+// Keymap flag of dead keys (the character is typed by the key followed by a space)
+#define HID_KEYMAP_DEAD 0x80
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Keyboard layouts
+enum _hid_layouts
+{
+    HID_LAYOUT_US = 0,
+    HID_LAYOUT_UK,
+    HID_LAYOUT_DE,
+    HID_LAYOUT_FR,
+    HID_LAYOUT_ES,
+    HID_LAYOUT_NUM
+};
+
+// Keystroke that types a character (key code is 0 if the character has no key)
+typedef struct
+{
+    uint8_t modifiers;
+    uint8_t key;
+} t_hid_keystroke;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Select the keyboard layout of the host by its name (i.e. "US", "DE")
+int8_t hid_layout_select(const char* name, const uint8_t name_len);
+
+// Get the keystroke that types an ASCII character in current keyboard layout
+t_hid_keystroke hid_ascii_to_keystroke(const char c);
+
+// Type a text, packing runs of distinct keys that share modifiers into a single report
+// Return the number of sent reports
+uint16_t hid_string_write(const char* text, const uint8_t text_len);
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,54 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     idlesleep.cpp                                                                              */
+/* Description:                                                                                   */
+/*     MCU idle sleep while there is nothing to do, woken up by any interrupt.                    */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "idlesleep.h"
+
+#if defined(__AVR__)
+    #include <avr/sleep.h>
+    #include <avr/power.h>
+#endif
+
+/**************************************************************************************************/
+
+/* Idle Sleep Functions */
+
+// Power down the peripherals that are not used (ADC, SPI, TWI and PWM timers)
+// Timer0 (millis), USB and USART1 (if used) have to keep running
+void idle_sleep_init(void)
+{
+    #if defined(__AVR__)
+        ADCSRA = ADCSRA & ~(1 << ADEN);
+        power_adc_disable();
+        power_spi_disable();
+        power_twi_disable();
+        power_timer1_disable();
+        power_timer3_disable();
+        set_sleep_mode(SLEEP_MODE_IDLE);
+    #endif
+}
+
+// Sleep until next interrupt, to be called with interrupts disabled (they are enabled again)
+// The instruction after sei() is always executed before any pending interrupt, so an interrupt
+// that arrives after the caller checks for pending work still wakes up the MCU
+uint32_t idle_sleep(void)
+{
+    uint32_t start_us = micros();
+
+    #if defined(__AVR__)
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    #else
+        native_idle_wait();
+        interrupts();
+    #endif
+
+    return micros() - start_us;
+}
@@ -0,0 +1,48 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     idlesleep.h                                                                                */
+/* Description:                                                                                   */
+/*     MCU idle sleep while there is nothing to do, woken up by any interrupt.                    */
+/**************************************************************************************************/
+
+/* Idle Sleep:
+ *
+ * The CPU clock is stopped in idle sleep mode but peripherals keep running, so any interrupt
+ * wakes it up: received bytes (USB, USART1 and SoftwareSerial pin change interrupts), USB host
+ * requests (keyboard LEDs) and Timer0 overflow, which ticks millis() each 1024 us. So timed
+ * deadlines are checked at every tick, as before, and wake up latency is just the interrupt
+ * handler time.
+ */
+
+#ifndef IDLESLEEP_H_
+#define IDLESLEEP_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Idle sleep while there is nothing to do (enabled by default)
+#ifndef IDLE_SLEEP
+    #define IDLE_SLEEP 1
+#endif
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Power down the peripherals that are not used (ADC, SPI, TWI and PWM timers)
+void idle_sleep_init(void);
+
+// Sleep until next interrupt, to be called with interrupts disabled (they are enabled again)
+// Returns the time asleep (us)
+uint32_t idle_sleep(void);
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,150 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     logger.cpp                                                                                 */
+/* Description:                                                                                   */
+/*     Compile time levels Serial log and optional binary trace events ring buffer.               */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "logger.h"
+#include "serialrx.h"
+
+#if LOG_EVENTS
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Size of an event frame (sync byte and fields, without escapes)
+#define LOG_EVENT_FRAME_SIZE 8
+
+// Maximum size of an event frame in the Serial link (every field byte escaped)
+#define LOG_EVENT_LINK_SIZE (1 + 2 * (LOG_EVENT_FRAME_SIZE - 1))
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Trace event record
+typedef struct
+{
+    uint8_t id;
+    uint16_t arg;
+    uint32_t timestamp;
+} t_log_event;
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions Prototypes */
+
+// Escape the field bytes of an event frame, returns the frame size in the link
+static uint8_t log_event_escape(const uint8_t* frame, uint8_t* link);
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+// Trace events ring buffer
+static t_log_event events[LOG_EVENTS_SIZE];
+static uint8_t events_head = 0;
+static uint8_t events_count = 0;
+static uint16_t events_lost = 0;
+
+/**************************************************************************************************/
+
+/* Trace Events Functions */
+
+// Store a trace event in the events ring buffer
+// If the ring buffer is full the event is lost (and counted), the link is never waited for
+void log_event(const uint8_t id, const uint16_t arg)
+{
+    t_log_event* event = NULL;
+
+    if(events_count >= LOG_EVENTS_SIZE)
+    {
+        events_lost = events_lost + 1;
+        return;
+    }
+
+    event = &(events[(events_head + events_count) % LOG_EVENTS_SIZE]);
+    event->id = id;
+    event->arg = arg;
+    event->timestamp = micros();
+    events_count = events_count + 1;
+}
+
+// Write stored trace events to Serial while it has room for them (never blocks)
+void log_events_drain(void)
+{
+    t_log_event* event = NULL;
+    uint8_t frame[LOG_EVENT_FRAME_SIZE];
+    uint8_t link[LOG_EVENT_LINK_SIZE];
+
+    // Report lost events once there is room to store it
+    if((events_lost > 0) && (events_count < LOG_EVENTS_SIZE))
+    {
+        uint16_t lost = events_lost;
+        events_lost = 0;
+        log_event(EV_EVENTS_LOST, lost);
+    }
+
+    while((events_count > 0) && (Serial.availableForWrite() >= LOG_EVENT_LINK_SIZE))
+    {
+        event = &(events[events_head]);
+        frame[0] = LOG_EVENT_SYNC;
+        frame[1] = event->id;
+        frame[2] = event->timestamp & 0xFF;
+        frame[3] = (event->timestamp >> 8) & 0xFF;
+        frame[4] = (event->timestamp >> 16) & 0xFF;
+        frame[5] = (event->timestamp >> 24) & 0xFF;
+        frame[6] = event->arg & 0xFF;
+        frame[7] = (event->arg >> 8) & 0xFF;
+        Serial.write(link, log_event_escape(frame, link));
+
+        events_head = (events_head + 1) % LOG_EVENTS_SIZE;
+        events_count = events_count - 1;
+    }
+}
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Escape the field bytes of an event frame, returns the frame size in the link
+// Field bytes that the host could take as frame replies, flow control characters or a frame sync
+// are sent as the escape byte followed by the byte XOR LOG_EVENT_ESCAPE_XOR
+static uint8_t log_event_escape(const uint8_t* frame, uint8_t* link)
+{
+    uint8_t size = 1;
+    uint8_t byte = 0;
+
+    link[0] = frame[0];
+    for(uint8_t i = 1; i < LOG_EVENT_FRAME_SIZE; i++)
+    {
+        byte = frame[i];
+        if((byte == RX_FRAME_ACK) || (byte == RX_FRAME_NAK) || (byte == RX_XON) ||
+           (byte == RX_XOFF) || (byte == LOG_EVENT_SYNC) || (byte == LOG_EVENT_ESCAPE))
+        {
+            link[size] = LOG_EVENT_ESCAPE;
+            byte = byte ^ LOG_EVENT_ESCAPE_XOR;
+            size = size + 1;
+        }
+        link[size] = byte;
+        size = size + 1;
+    }
+
+    return size;
+}
+
+#else
+
+/**************************************************************************************************/
+
+/* Trace Events Functions (disabled) */
+
+void log_event(const uint8_t id, const uint16_t arg) {}
+
+void log_events_drain(void) {}
+
+#endif
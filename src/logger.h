@@ -0,0 +1,130 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     logger.h                                                                                   */
+/* Description:                                                                                   */
+/*     Compile time levels Serial log and optional binary trace events ring buffer.               */
+/**************************************************************************************************/
+
+/* Log Levels:
+ *
+ * LOG_LEVEL build flag selects which messages are compiled (i.e. -DLOG_LEVEL=LOG_LEVEL_TRACE),
+ * messages of higher levels compile to nothing. Messages strings are kept in flash (F() macro).
+ *
+ * Trace Events:
+ *
+ * With LOG_EVENTS build flag enabled (-DLOG_EVENTS=1), LOG_EVENT() stores a compact event record
+ * in a RAM ring buffer (no Serial output in the hot path). log_events_drain() writes the stored
+ * records to Serial only when there is room in its transmission buffer, as binary frames:
+ *
+ *     [0xA5] [event ID] [timestamp us (uint32_t LE)] [argument (uint16_t LE)]
+ *
+ * Serial also carries the frame replies (ACK/NAK) and flow control characters (XON/XOFF) of the
+ * reception link, so those bytes, the sync byte and the escape byte (0x7D) are sent after the
+ * frame sync as the escape byte followed by the byte XOR 0x20 (i.e. 0x11 -> [0x7D] [0x31]).
+ */
+
+#ifndef LOGGER_H_
+#define LOGGER_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Log levels
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_TRACE 3
+
+// Default log level (production)
+#ifndef LOG_LEVEL
+    #define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Binary trace events (disabled by default)
+#ifndef LOG_EVENTS
+    #define LOG_EVENTS 0
+#endif
+
+// Number of trace events that can be stored until drained
+#ifndef LOG_EVENTS_SIZE
+    #define LOG_EVENTS_SIZE 16
+#endif
+
+// Trace event frame sync byte
+#define LOG_EVENT_SYNC 0xA5
+
+// Trace event frame escape byte and the value XORed to an escaped byte
+#define LOG_EVENT_ESCAPE 0x7D
+#define LOG_EVENT_ESCAPE_XOR 0x20
+
+// Log macros
+#define LOG_NOTHING() do {} while(0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+    #define LOG_ERROR(msg) Serial.println(F(msg))
+#else
+    #define LOG_ERROR(msg) LOG_NOTHING()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+    #define LOG_INFO(msg) Serial.println(F(msg))
+#else
+    #define LOG_INFO(msg) LOG_NOTHING()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_TRACE
+    #define LOG_TRACE(msg) Serial.println(F(msg))
+    #define LOG_TRACE_VALUE(msg, value) \
+        do { Serial.print(F(msg)); Serial.println(value); } while(0)
+    #define LOG_TRACE_HEX(msg, value) \
+        do { Serial.print(F(msg)); Serial.println(value, HEX); } while(0)
+    #define LOG_TRACE_SPAN(msg, ptr, len) \
+        do { Serial.print(F(msg)); Serial.write(ptr, len); Serial.println(); } while(0)
+#else
+    #define LOG_TRACE(msg) LOG_NOTHING()
+    #define LOG_TRACE_VALUE(msg, value) LOG_NOTHING()
+    #define LOG_TRACE_HEX(msg, value) LOG_NOTHING()
+    #define LOG_TRACE_SPAN(msg, ptr, len) LOG_NOTHING()
+#endif
+
+#if LOG_EVENTS
+    #define LOG_EVENT(id, arg) log_event(id, arg)
+#else
+    #define LOG_EVENT(id, arg) LOG_NOTHING()
+#endif
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Trace events IDs
+enum _log_events
+{
+    EV_LINE_RECEIVED = 0,  // Argument: line length
+    EV_CMD_QUEUED,         // Argument: command ID
+    EV_CMD_INVALID,        // Argument: line length
+    EV_CMD_START,          // Argument: command ID
+    EV_CMD_DONE,           // Argument: command return code
+    EV_EVENTS_LOST         // Argument: number of events lost since last drain
+};
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Store a trace event in the events ring buffer
+void log_event(const uint8_t id, const uint16_t arg);
+
+// Write stored trace events to Serial while it has room for them (never blocks)
+void log_events_drain(void);
+
+/**************************************************************************************************/
+
+#endif
@@ -11,9 +11,24 @@
 
 /* Libraries */
 
-#include <SoftwareSerial.h>
 #include <HID-Project.h>
 #include "hidkeys.h"
+#include "duckykeys.h"
+#include "duckyparser.h"
+#include "duckybytecode.h"
+#include "hidstring.h"
+#include "serialrx.h"
+#include "serialtransport.h"
+#include "cmdqueue.h"
+#include "scriptstore.h"
+#include "duckymacro.h"
+#include "scheduler.h"
+#include "memstats.h"
+#include "stats.h"
+#include "pacing.h"
+#include "idlesleep.h"
+#include "logger.h"
+#include "returncodes.h"
 
 /**************************************************************************************************/
 
@@ -22,145 +37,413 @@
 // Serial Ports communication speed bauds
 #define SERIAL_BAUDS 19200
 #define SWSERIAL_BAUDS 19200
+#define UART_BAUDS 115200
 
-// Software Serial GPIO Tx and Rx Pins
-#define P_SWSERIAL_RX 8
-#define P_SWSERIAL_TX 9
+// Time to confirm new negotiated Serial link bauds with a valid frame before restoring them
+#define LINK_BAUDS_CONFIRM_MS 2000
 
-// Serial Reception buffer size (Maximum length for each received line)
-#define RX_BUFFER_SIZE 512
+// RAM budget of the arena that holds the large buffers (atmega32u4 has 2.5KB of SRAM)
+// Building both auxiliar transports adds a third reception channel
+#if RX_TRANSPORT_SWSERIAL && RX_TRANSPORT_UART
+    #define RAM_ARENA_BUDGET 1792
+#else
+    #define RAM_ARENA_BUDGET 1536
+#endif
 
 /**************************************************************************************************/
 
 /* Functions Prototypes */
 
-// Check for incomming Serial data, store it in provided buffer and detect end of line
-int8_t serial_line_received(char* my_rx_buffer, uint16_t* rx_buffer_received_bytes, 
-    const size_t rx_buffer_max_size);
+// Move incomming Serial ports data into each source reception ring buffer
+void serial_rx_poll(void);
 
-// Interprete and execute a Ducky Script command
+// Handle Serial links bauds negotiation requests and confirmation
+void serial_bauds_update(const uint8_t source);
+
+// Check for a complete line received from any of the Serial ports
+int8_t serial_line_received(t_span* line, uint8_t* source);
+
+// Release a received line once it has been processed
+void serial_line_release(const uint8_t source);
+
+// Interprete a Ducky Script command line and queue it for execution
 // DuckyScript Documentation: https://github.com/hak5darren/USB-Rubber-Ducky/wiki/Duckyscript
-int8_t ducky_script_interpreter(char* command, const uint16_t command_length);
+int8_t ducky_script_interpreter(const char* command, const uint16_t command_length);
+
+// Decode a Ducky Script bytecode command and queue it for execution
+int8_t ducky_bytecode_interpreter(const uint8_t* code, const uint16_t code_length);
+
+// Queue a streamed STRING line text part for execution
+int8_t ducky_string_part_interpreter(const char* text, const uint16_t text_length,
+    const bool last);
+
+// Queue a compiled command for execution (or store it), handling device control commands
+int8_t ducky_command_process(t_ducky_cmd* cmd);
+
+// Abort the block being recorded and discard next received commands until its END
+void block_discard_start(const t_ducky_cmd* cmd, const uint8_t ends);
+
+// Discard a received command of an aborted block, until the END that closes it
+void block_discard(const t_ducky_cmd* cmd);
+
+// Queue next command of the stored script being replayed
+void store_run_feed(void);
+
+// Queue next command of the macros being replayed
+void macro_run_feed(void);
 
-// Convert Ducky Script key name into corresponding USB-HID Code byte
-uint8_t ducky_key_to_hid_byte(const char* key);
+// Write RAM usage statistics to Serial
+void memstats_report(void);
 
-// Count the number of words inside a string
-uint32_t cstr_count_words(const char* str_in, const size_t str_in_len);
+// Sleep until next interrupt if there is nothing to do
+void idle_sleep_run(void);
 
-// Safe conversion a string number into uint32_t element
-int8_t safe_atoi_u32(const char* in_str, const size_t in_str_len, uint32_t* out_int, 
-    bool check_null_terminated=true);
+// Check if there is nothing to do until next interrupt
+bool system_idle(void);
+
+// Execute queued commands as their scheduled time is reached
+void executor_run(void);
+
+// Check if the executor has nothing to do until a deadline or new commands
+bool executor_idle(void);
+
+// Update the executor state once a command has been executed
+void executor_command_done(const t_ducky_cmd* cmd, const int8_t rc);
 
 /**************************************************************************************************/
 
 /* Data Types */
 
-// Functions Return Codes
-enum _return_codes
+// Ducky Script command handler function
+typedef int8_t (*t_cmd_handler)(const t_ducky_cmd* cmd);
+
+// Commands executor state (all times are absolute millis() deadlines)
+typedef struct
+{
+    uint32_t next_cmd_ms;         // Time when next command can be executed
+    uint32_t repeat_left;         // Pending REPEAT executions of last command
+    const t_ducky_cmd* current;   // Command in progress (STRING_DELAY) or NULL
+    bool current_queued;          // Command being executed is the commands queue head
+    uint8_t text_index;           // STRING_DELAY next character to write
+    uint32_t next_char_ms;        // STRING_DELAY time when next character can be written
+    uint32_t start_us;            // Time when current command execution started (statistics)
+} t_executor;
+
+// Idle sleep state
+typedef struct
+{
+    uint32_t wake_us;             // Time of last wake up
+    uint32_t rx_wake_us;          // Time of last wake up followed by received bytes
+    bool woken;                   // Current loop pass follows a wake up
+    bool rx_wake;                 // Received bytes woke up the waiting executor (until next cmd)
+} t_idle;
+
+// Serial link bauds state
+typedef struct
+{
+    uint32_t bauds;               // Current bauds
+    uint32_t fallback_bauds;      // Previous bauds while current ones are not confirmed (or 0)
+    uint32_t confirm_deadline;    // Time when not confirmed bauds are restored
+} t_serial_link;
+
+// Statically sized arena with all large buffers (reception rings, lines and compressed lines
+// history of each source, queued commands, macros and statistics), so their RAM usage is checked
+// at compile time
+typedef struct
+{
+    t_rx_channel rx_channels[RX_SRC_NUM];
+    t_cmd_queue cmd_queue;
+    t_macros macros;
+    t_stats stats;
+} t_ram_arena;
+
+static_assert(sizeof(t_ram_arena) <= RAM_ARENA_BUDGET, "RAM arena exceeds its budget");
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Serial links bauds that can be negotiated, up to each port maximum (stored in flash)
+static const uint32_t LINK_BAUDS_SUPPORTED[] PROGMEM =
 {
-    RC_OK = 0,
-    RC_BAD = -1,
-    RC_INVALID_INPUT = -2,
-    RC_CUSTOM_DELAY = 100
+    9600, 19200, 38400, 57600, 115200, 250000
 };
 
 /**************************************************************************************************/
 
 /* Global Objects */
 
-// Software Serial
-SoftwareSerial SWSerial(P_SWSERIAL_RX, P_SWSERIAL_TX);
-
 // Default delay between DuckyScript commands
 uint32_t default_delay = 100;
 
+// Serial links of each reception source
+static t_serial_link serial_links[RX_SRC_NUM];
+
+// Large buffers arena
+static t_ram_arena ram_arena;
+
+// Reception channels of each Serial port
+static t_rx_channel* const rx_channels = ram_arena.rx_channels;
+
+// Compiled commands waiting to be executed
+static t_cmd_queue& cmd_queue = ram_arena.cmd_queue;
+
+// Macros and loops
+static t_macros& macros = ram_arena.macros;
+
+// Runtime statistics
+static t_stats& stats = ram_arena.stats;
+
+// EEPROM stored script
+static t_script_store script_store;
+
+// Commands executor
+static t_executor executor;
+
+// Adaptive keystrokes pacing
+static t_pacing pacing;
+
+// Idle sleep
+static t_idle idle;
+
+// END commands left to close a block that failed to be recorded (0 if none is being discarded)
+static uint8_t block_discard_ends = 0;
+
+// Last received command is the last part of a streamed STRING line
+static bool line_streamed = false;
+
 /**************************************************************************************************/
 
 /* Setup and Loop Functions */
 
 void setup(void)
 {
-    // Initialize the software serial port
-    Serial.begin(SERIAL_BAUDS);
-    SWSerial.begin(SWSERIAL_BAUDS);
+    // Initialize the serial ports
+    serial_links[RX_SRC_SERIAL].bauds = SERIAL_BAUDS;
+    #if RX_TRANSPORT_SWSERIAL
+        serial_links[RX_SRC_SWSERIAL].bauds = SWSERIAL_BAUDS;
+    #endif
+    #if RX_TRANSPORT_UART
+        serial_links[RX_SRC_UART].bauds = UART_BAUDS;
+    #endif
+    for(uint8_t i = 0; i < RX_SRC_NUM; i++)
+    {
+        serial_begin(i, serial_links[i].bauds);
+        rx_channel_init(&(rx_channels[i]));
+    }
 
     // Initialize Keyboard
-    Serial.println("Keyboard initializing...");
+    LOG_INFO("Keyboard initializing...");
     Keyboard.begin();
 
-    Serial.println("Setup done.\n");
+    // Power down unused peripherals
+    idle_sleep_init();
+
+    // Replay stored script at boot
+    if(store_flags() & STORE_FLAG_BOOT)
+    {
+        LOG_INFO("Running stored script...");
+        store_run_start(&script_store);
+    }
+
+    LOG_INFO("Setup done.\n");
 }
 
 void loop(void)
 {
-    // Serial Rx buffer and number of received bytes in the buffer
-    static char _rx_buffer[SERIAL_RX_BUFFER_SIZE] = { 0 };
-    static uint16_t _rx_buffer_received_bytes = 0;
+    t_span line;
+    uint8_t source = 0;
+    uint32_t start_us = 0;
+
+    stats.loops = stats.loops + 1;
 
-    // Check for incomming Serial data lines
-    if(serial_line_received(_rx_buffer, &_rx_buffer_received_bytes, SERIAL_RX_BUFFER_SIZE) == RC_OK)
+    // Keep Serial ports reception running while commands are waiting
+    serial_rx_poll();
+
+    // Write the recorded stored script commands into the EEPROM as it gets ready
+    store_write_poll(&script_store);
+
+    // Interprete received lines into the commands queue while there is room for them, so next
+    // commands are already parsed while current one is being executed
+    while(cmd_queue_reserve(&cmd_queue) != NULL)
     {
-        // Check, interprete and execute the received line as DuckyScript command
-        if(ducky_script_interpreter(_rx_buffer, _rx_buffer_received_bytes) != RC_CUSTOM_DELAY)
-            delay(default_delay);
-        _rx_buffer_received_bytes = 0;
+        // Stored script or macros being replayed go first, received lines wait for them to end
+        if(script_store.running)
+        {
+            store_run_feed();
+            continue;
+        }
+        if(macro_running(&macros))
+        {
+            macro_run_feed();
+            continue;
+        }
+
+        // Received lines wait until previous recorded command is written into the EEPROM, so
+        // reception keeps running (and pauses the sender) meanwhile
+        if(store_writing(&script_store))
+            break;
+
+        start_us = micros();
+        if(serial_line_received(&line, &source) != RC_OK)
+            break;
+        stats_record(&stats, STATS_HIST_RX, micros() - start_us);
+        stats.lines = stats.lines + 1;
+        LOG_EVENT(EV_LINE_RECEIVED, line.len);
+
+        start_us = micros();
+        if(rx_channels[source].line_stream != RX_STREAM_NONE)
+        {
+            ducky_string_part_interpreter(line.ptr, line.len,
+                (rx_channels[source].line_stream == RX_STREAM_END));
+        }
+        else
+            ducky_script_interpreter(line.ptr, line.len);
+        stats_record(&stats, STATS_HIST_PARSE, micros() - start_us);
+        serial_line_release(source);
     }
+
+    // Execute queued commands
+    executor_run();
+
+    // Send stored trace events if Serial link has room for them
+    log_events_drain();
+
+    // Sleep until next interrupt while there is nothing to do
+    #if IDLE_SLEEP
+        idle_sleep_run();
+    #endif
 }
 
 /**************************************************************************************************/
 
-/* Serial Line Received Detector Function */
+/* Serial Line Received Detector Functions */
 
-// Check for incomming Serial data, store it in provided buffer and detect end of line
-int8_t serial_line_received(char* my_rx_buffer, uint16_t* rx_buffer_received_bytes, 
-    const size_t rx_buffer_max_size)
+// Move incomming Serial ports data into each source reception ring buffer
+// Bytes are just taken from the ports while there is room for them, so nothing gets lost here
+void serial_rx_poll(void)
 {
-    uint16_t i = *rx_buffer_received_bytes;
-
-    if(i > rx_buffer_max_size-1)
-        return RC_INVALID_INPUT;
+    t_rx_ring* ring = NULL;
+    uint8_t reply = 0;
+    uint8_t seq = 0;
 
-    // While there is any data incoming from the hardware serial port
-    while(Serial.available())
+    for(uint8_t src = 0; src < RX_SRC_NUM; src++)
     {
-        my_rx_buffer[i] = (char)Serial.read();
+        ring = &(rx_channels[src].ring);
+        while(serial_available(src) && rx_ring_free(ring))
+        {
+            rx_ring_push(ring, serial_read(src));
+            stats.bytes = stats.bytes + 1;
+            if(idle.woken && (cmd_queue_peek(&cmd_queue) == NULL) &&
+               sched_deadline_reached(executor.next_cmd_ms))
+            {
+                idle.rx_wake = true;
+                idle.rx_wake_us = idle.wake_us;
+            }
+        }
+        // Bytes lost by the Serial port and by the reception ring
+        stats.dropped = stats.dropped + serial_overflow(src) + ring->dropped;
+        ring->dropped = 0;
 
-        i = i + 1;
-        *rx_buffer_received_bytes = i;
+        // Reception rings fill level
+        if(RX_RING_SIZE - rx_ring_free(ring) > stats.rx_max)
+            stats.rx_max = RX_RING_SIZE - rx_ring_free(ring);
 
-        if(i >= rx_buffer_max_size-1)
+        // Reply received frames
+        reply = rx_frame_reply(&(rx_channels[src]), &seq);
+        if(reply)
         {
-            my_rx_buffer[rx_buffer_max_size-1] = '\0';
-            return RC_OK;
+            serial_write(src, reply);
+            serial_write(src, seq);
         }
 
-        if((my_rx_buffer[i-1] == '\n') || (my_rx_buffer[i-1] == '\r'))
+        // Pause or resume senders depending on rings free space
+        #if RX_FLOW_CONTROL
+            reply = rx_flow_control(&(rx_channels[src]));
+            if(reply)
+                serial_write(src, reply);
+        #endif
+
+        serial_bauds_update(src);
+    }
+}
+
+// Handle Serial links bauds negotiation requests and confirmation
+// A request is acknowledged with current bauds and applied, then new bauds need to be confirmed
+// by a valid frame before LINK_BAUDS_CONFIRM_MS or previous ones are restored
+void serial_bauds_update(const uint8_t source)
+{
+    t_rx_channel* channel = &(rx_channels[source]);
+    t_serial_link* link = &(serial_links[source]);
+    uint32_t bauds = 0;
+    bool supported = false;
+
+    // Check new bauds confirmation
+    if(link->fallback_bauds != 0)
+    {
+        if(channel->frame_received)
         {
-            my_rx_buffer[i-1] = '\0';
-            *rx_buffer_received_bytes = *rx_buffer_received_bytes - 1;
-            return RC_OK;
+            link->fallback_bauds = 0;
+            LOG_INFO("Serial link bauds confirmed.");
+        }
+        else if(sched_deadline_reached(link->confirm_deadline))
+        {
+            link->bauds = link->fallback_bauds;
+            link->fallback_bauds = 0;
+            serial_end(source);
+            serial_begin(source, link->bauds);
+            LOG_ERROR("Serial link bauds not confirmed, previous ones restored.");
         }
     }
 
-    // While there is any data incoming from the software serial port
-    while(SWSerial.available())
+    if(channel->bauds_request == 0)
+        return;
+    bauds = channel->bauds_request;
+    channel->bauds_request = 0;
+
+    // Bauds can't be negotiated on USB Serial or above the port maximum
+    for(uint8_t i = 0; i < sizeof(LINK_BAUDS_SUPPORTED)/sizeof(uint32_t); i++)
     {
-        my_rx_buffer[i] = (char)SWSerial.read();
+        if(pgm_read_dword(&(LINK_BAUDS_SUPPORTED[i])) == bauds)
+            supported = (bauds <= serial_bauds_max(source));
+    }
+    if(!supported)
+    {
+        serial_write(source, RX_FRAME_NAK);
+        serial_write(source, channel->reply_seq);
+        return;
+    }
 
-        i = i + 1;
-        *rx_buffer_received_bytes = i;
+    serial_write(source, RX_FRAME_ACK);
+    serial_write(source, channel->reply_seq);
+    serial_end(source);
+    serial_begin(source, bauds);
+
+    // Keep previous bauds until new ones get confirmed
+    if(link->fallback_bauds == 0)
+        link->fallback_bauds = link->bauds;
+    link->bauds = bauds;
+    link->confirm_deadline = millis() + LINK_BAUDS_CONFIRM_MS;
+    channel->frame_received = false;
+    LOG_TRACE_VALUE("Serial link bauds changed: ", bauds);
+}
 
-        if(i >= rx_buffer_max_size-1)
-        {
-            my_rx_buffer[rx_buffer_max_size-1] = '\0';
-            return RC_OK;
-        }
+// Check for a complete line received from any of the Serial ports
+// Each source assembles its own lines, sources are checked in round-robin order
+int8_t serial_line_received(t_span* line, uint8_t* source)
+{
+    static uint8_t next_source = 0;
+    uint8_t src = 0;
 
-        if((my_rx_buffer[i-1] == '\n') || (my_rx_buffer[i-1] == '\r'))
+    serial_rx_poll();
+
+    for(uint8_t i = 0; i < RX_SRC_NUM; i++)
+    {
+        src = (next_source + i) % RX_SRC_NUM;
+        if(rx_line_assemble(&(rx_channels[src]), line) == RC_OK)
         {
-            my_rx_buffer[i-1] = '\0';
-            *rx_buffer_received_bytes = *rx_buffer_received_bytes - 1;
+            next_source = (src + 1) % RX_SRC_NUM;
+            *source = src;
             return RC_OK;
         }
     }
@@ -168,744 +451,686 @@ int8_t serial_line_received(char* my_rx_buffer, uint16_t* rx_buffer_received_byt
     return RC_BAD;
 }
 
+// Release a received line once it has been processed
+void serial_line_release(const uint8_t source)
+{
+    rx_line_release(&(rx_channels[source]));
+}
+
 /**************************************************************************************************/
 
 /* Ducky Script Functions */
 
-// Interprete and execute a Ducky Script command
+// Interprete a Ducky Script command line and queue it for execution
 // Ducky Script Documentation at: https://github.com/hak5darren/USB-Rubber-Ducky/wiki/Duckyscript
-int8_t ducky_script_interpreter(char* command, const uint16_t command_length)
+int8_t ducky_script_interpreter(const char* command, const uint16_t command_length)
 {
-    static char last_command[SERIAL_RX_BUFFER_SIZE] = { 0 };
-    char* ptr_cmd = NULL;
-    char* ptr_argv = NULL;
-    uint32_t argc = 0;
-    uint8_t key = 0;
-
-    // Check number of command arguments
-    argc = cstr_count_words(command, command_length);
-    if(argc == 0)
-        return RC_BAD;
-    argc = argc - 1;
+    t_ducky_line line;
+    t_ducky_cmd* cmd = NULL;
 
-    // Point to provided command line
-    ptr_cmd = &(command[0]);
+    // Bytecode commands are received through the same lines
+    if((command_length > 0) && ducky_bytecode_is_opcode((uint8_t)command[0]))
+        return ducky_bytecode_interpreter((const uint8_t*)command, command_length);
 
-    Serial.print("\nCommand received: "); Serial.println(ptr_cmd);
-    Serial.print("Number of command arguments: "); Serial.println(argc);
+    // Get a free commands queue slot
+    cmd = cmd_queue_reserve(&cmd_queue);
+    if(cmd == NULL)
+        return RC_BAD;
 
-    /**********************************/
+    // Tokenize the command line
+    if(ducky_parse_line(command, command_length, &line) != RC_OK)
+        return RC_BAD;
 
-    /* Interpretation and Execution */
+    LOG_TRACE_SPAN("\nCommand received: ", command, command_length);
+    LOG_TRACE_VALUE("Number of command arguments: ", line.argc);
 
     // REM: Comment line, just to be ignored
-    // REM [text]
-    if((strncmp(ptr_cmd, "REM", strlen("REM")) == 0) || 
-        (strncmp(ptr_cmd, "//", strlen("//")) == 0))
+    if(line.cmd == CMD_REM)
     {
-        Serial.println("Comment command detected, ignoring it.");
+        LOG_TRACE("Comment command detected, ignoring it.");
         return RC_OK;
     }
 
-    // REPEAT: Repeats the last command n times
-    if(strncmp(ptr_cmd, "REPEAT", strlen("REPEAT")) == 0)
+    // Compile the command into the queue slot
+    if(ducky_compile(&line, cmd) != RC_OK)
     {
-        Serial.println("Repeat command detected.");
+        LOG_ERROR("Invalid, unknown or unsupported command received.");
+        LOG_EVENT(EV_CMD_INVALID, command_length);
+        return RC_BAD;
+    }
 
-        // Check if there is a second argument
-        if(argc == 0)
-        {
-            Serial.println("No arguments detected.");
-            return RC_BAD;
-        }
+    return ducky_command_process(cmd);
+}
 
-        // Ignore if no previous command available to be repeated
-        if(last_command[0] == '\0')
-        {
-            Serial.println("No previous commands stored.");
-            return RC_BAD;
-        }
+// Decode a Ducky Script bytecode command and queue it for execution
+// The decoded command record is the same as the compiled one of the equivalent text line, so both
+// are executed by the same handlers and produce the same HID reports
+int8_t ducky_bytecode_interpreter(const uint8_t* code, const uint16_t code_length)
+{
+    t_ducky_cmd* cmd = NULL;
 
-        // Point to second command argument
-        ptr_argv = strstr(ptr_cmd, " ");
-        if(ptr_argv == NULL)
-            return RC_BAD;
-        if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-            return RC_BAD;
-        ptr_argv = ptr_argv + 1;
-        Serial.print("Argument received: "); Serial.println(ptr_argv);
-
-        // Convert argument into integer type
-        uint32_t n = 0;
-        if(safe_atoi_u32(ptr_argv, strlen(ptr_argv), &n) != RC_OK)
-        {
-            Serial.println("Can't parse to uint32_t the second argument.");
-            return RC_BAD;
-        }
+    // Get a free commands queue slot
+    cmd = cmd_queue_reserve(&cmd_queue);
+    if(cmd == NULL)
+        return RC_BAD;
 
-        // Execute previous command n times through recursive call
-        for(uint8_t i = 0; i < n; i++)
-            ducky_script_interpreter(last_command, strlen(last_command));
+    LOG_TRACE_HEX("\nBytecode command received, opcode: ", code[0]);
 
-        return RC_OK;
+    // Decode the command into the queue slot
+    if(ducky_bytecode_decode(code, code_length, cmd) != RC_OK)
+    {
+        LOG_ERROR("Invalid bytecode command received.");
+        LOG_EVENT(EV_CMD_INVALID, code_length);
+        return RC_BAD;
     }
 
-    // Store this command for following command (to be used by REPEAT command)
-    snprintf(last_command, SERIAL_RX_BUFFER_SIZE, "%s", command);
+    return ducky_command_process(cmd);
+}
 
-    // DEFAULTDELAY: Define how long (milliseconds) to wait between each subsequent command
-    // DEFAULTDELAY [n]
-    if((strncmp(ptr_cmd, "DEFAULT_DELAY", strlen("DEFAULT_DELAY")) == 0) || 
-        (strncmp(ptr_cmd, "DEFAULTDELAY", strlen("DEFAULTDELAY")) == 0))
-    {
-        Serial.println("Change default delay command detected.");
+// Queue a streamed STRING line text part for execution
+// Parts are typed back to back and the last one is a STRING command, so the line is followed by
+// the default delay as a whole. Just the last part would be kept for a REPEAT, so a REPEAT that
+// follows a streamed line is rejected
+int8_t ducky_string_part_interpreter(const char* text, const uint16_t text_length,
+    const bool last)
+{
+    t_ducky_cmd* cmd = NULL;
+    int8_t rc = RC_OK;
 
-        // Check if there is a second argument
-        if(argc == 0)
-        {
-            Serial.println("No arguments detected.");
-            return RC_BAD;
-        }
+    // Get a free commands queue slot
+    cmd = cmd_queue_reserve(&cmd_queue);
+    if(cmd == NULL)
+        return RC_BAD;
 
-        // Point to second command argument
-        ptr_argv = strstr(ptr_cmd, " ");
-        if(ptr_argv == NULL)
-            return RC_BAD;
-        if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-            return RC_BAD;
-        ptr_argv = ptr_argv + 1;
-        Serial.print("Argument received: "); Serial.println(ptr_argv);
-
-        // Update default delay between commands values to received one
-        if(safe_atoi_u32(ptr_argv, strlen(ptr_argv), &default_delay) != RC_OK)
-        {
-            Serial.println("Can't parse to uint32_t the second argument.");
-            return RC_BAD;
-        }
+    memset(cmd, 0, sizeof(t_ducky_cmd));
+    cmd->cmd = (last) ? CMD_STRING : CMD_STRING_PART;
+    cmd->text_len = (text_length < DUCKY_TEXT_MAX_LENGTH) ? text_length : DUCKY_TEXT_MAX_LENGTH;
+    memcpy(cmd->text, text, cmd->text_len);
+
+    rc = ducky_command_process(cmd);
+    line_streamed = true;
+
+    return rc;
+}
+
+// Queue a compiled command for execution (or store it), handling device control commands
+// STORE and STORE_BOOT start recording next commands into EEPROM instead of executing them,
+// until END is received. RUN replays the stored script
+// DEFINE and LOOP start recording next commands into the macros arena, until their END is
+// received (a LOOP inside a block is closed by the first END). CALL replays a defined macro.
+// Macros can't be used inside a stored script. A block that fails to be recorded is discarded,
+// without executing any of its commands, until its END. An END outside of any block is the End
+// key, as in plain Ducky Script
+int8_t ducky_command_process(t_ducky_cmd* cmd)
+{
+    uint8_t macro_blocks = (macros.recording) ? macros.record_depth + 1 : 0;
 
+    // Commands of a block that failed to be recorded are never executed
+    if(block_discard_ends > 0)
+    {
+        block_discard(cmd);
         return RC_OK;
     }
 
-    // DELAY: Creates a momentary pause (ms) in the ducky script
-    // DELAY [n]
-    if(strncmp(ptr_cmd, "DELAY", strlen("DELAY")) == 0)
+    // A streamed STRING line can't be repeated as a whole
+    if((cmd->cmd == CMD_REPEAT) && line_streamed)
     {
-        Serial.println("Delay command detected.");
-
-        // Check if there is a second argument
-        if(argc == 0)
-            return RC_BAD;
-
-        // Point to second command argument
-        ptr_argv = strstr(ptr_cmd, " ");
-        if(ptr_argv == NULL)
-            return RC_BAD;
-        if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-            return RC_BAD;
-        ptr_argv = ptr_argv + 1;
-        Serial.print("Argument received: "); Serial.println(ptr_argv);
-
-        // Convert argument into integer type
-        uint32_t n = 0;
-        if(safe_atoi_u32(ptr_argv, strlen(ptr_argv), &n) != RC_OK)
-        {
-            Serial.println("Can't parse to uint32_t the second argument.");
-            return RC_BAD;
-        }
-
-        // Wait for the received time
-        delay(n);
-
-        return RC_CUSTOM_DELAY;
+        LOG_ERROR("A STRING line longer than the line buffer can't be repeated.");
+        LOG_EVENT(EV_CMD_INVALID, cmd->cmd);
+        return RC_BAD;
     }
+    line_streamed = false;
 
-    // STRING_DELAY: Write the text waiting n milliseconds between each character
-    // STRING_DELAY n text
-    if(strncmp(ptr_cmd, "STRING_DELAY", strlen("STRING_DELAY")) == 0)
+    switch(cmd->cmd)
     {
-        uint32_t delay_value = 1;
-
-        Serial.println("String delay command detected.");
-
-        // Check if there is a second and third arguments
-        if(argc < 2)
-            return RC_BAD;
-
-        // Point to second command argument
-        ptr_argv = strstr(ptr_cmd, " ");
-        if(ptr_argv == NULL)
-            return RC_BAD;
-        if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-            return RC_BAD;
-        ptr_argv = ptr_argv + 1;
-        Serial.print("Argument received: "); Serial.println(ptr_argv);
-
-        // Check index of next argument
-        uint8_t delay_char_end_i = 0;
-        for(uint8_t i = 0; i < strlen(ptr_argv); i++)
-        {
-            if(ptr_argv[i] == ' ')
+        case CMD_STORE:
+        case CMD_STORE_BOOT:
+            if(script_store.recording || macros.recording)
                 break;
-            delay_char_end_i = delay_char_end_i + 1;
-        }
+            LOG_INFO("Storing script...");
+            store_record_start(&script_store, (cmd->cmd == CMD_STORE_BOOT) ? STORE_FLAG_BOOT : 0);
+            return RC_OK;
 
-        // Get delay value from second argument
-        if(safe_atoi_u32(ptr_argv, delay_char_end_i, &delay_value, false) != RC_OK)
-        {
-            Serial.println("Can't parse to uint32_t the second argument.");
-            return RC_BAD;
-        }
+        case CMD_END:
+            if(macros.recording)
+            {
+                if(macro_end(&macros) != RC_OK)
+                    break;
+                LOG_TRACE_VALUE("Macros arena bytes: ", macros.length);
+                return RC_OK;
+            }
+            if(script_store.recording)
+            {
+                if(store_record_end(&script_store) != RC_OK)
+                    break;
+                LOG_INFO("Script stored.");
+                LOG_TRACE_VALUE("Stored script bytes: ", script_store.length);
+                return RC_OK;
+            }
+            cmd->cmd = CMD_KEY;
+            cmd->key = KEY_END;
+            cmd_queue_commit(&cmd_queue);
+            LOG_EVENT(EV_CMD_QUEUED, cmd->cmd);
+            return RC_OK;
 
-        // Point to third command argument
-        ptr_argv = strstr(ptr_argv, " ");
-        if(ptr_argv == NULL)
-            return RC_BAD;
-        if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-            return RC_BAD;
-        ptr_argv = ptr_argv + 1;
-        Serial.print("Argument received: "); Serial.println(ptr_argv);
-
-        // Print each character and wait between them
-        for(uint32_t i = 0; i < strlen(ptr_argv); i++)
-        {
-            Keyboard.print(ptr_argv[i]);
-            delay(delay_value);
-        }
+        case CMD_DEFINE:
+        case CMD_LOOP:
+        case CMD_CALL:
+            if(script_store.recording)
+                break;
+            if(cmd->cmd == CMD_DEFINE)
+            {
+                if(macro_define_start(&macros, cmd) != RC_OK)
+                    break;
+            }
+            else if(cmd->cmd == CMD_LOOP)
+            {
+                if(macro_loop_start(&macros, cmd) != RC_OK)
+                    break;
+            }
+            else if(macro_call(&macros, cmd) != RC_OK)
+                break;
+            return RC_OK;
 
-        return RC_OK;
-    }
+        case CMD_RUN:
+            if(store_run_start(&script_store) != RC_OK)
+                break;
+            LOG_INFO("Running stored script...");
+            return RC_OK;
 
-    // STRING: Processes the text following taking special care to auto-shift
-    // STRING text
-    if(strncmp(ptr_cmd, "STRING", strlen("STRING")) == 0)
-    {
-        Serial.println("String command detected.");
+        case CMD_MEMSTATS:
+            memstats_report();
+            return RC_OK;
 
-        // Check if there is a second argument
-        if(argc == 0)
-            return RC_BAD;
+        case CMD_STATS:
+            stats_report(&stats, Serial);
+            return RC_OK;
 
-        // Point to second command argument
-        ptr_argv = strstr(ptr_cmd, " ");
-        if(ptr_argv == NULL)
-            return RC_BAD;
-        if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-            return RC_BAD;
-        ptr_argv = ptr_argv + 1;
-        Serial.print("Argument received: "); Serial.println(ptr_argv);
+        case CMD_RESETSTATS:
+            stats_reset(&stats);
+            return RC_OK;
 
-        Keyboard.print(ptr_argv);
+        default:
+            // Record the command while a macro or loop block is being recorded
+            if(macros.recording)
+            {
+                if(macro_record(&macros, cmd) != RC_OK)
+                    break;
+                return RC_OK;
+            }
+
+            // Store the command while a script is being recorded
+            if(script_store.recording)
+            {
+                if(store_record(&script_store, cmd) == RC_OK)
+                    return RC_OK;
+                LOG_ERROR("Script doesn't fit in the store, discarded until its END.");
+                block_discard_start(cmd, 1);
+                return RC_BAD;
+            }
 
-        return RC_OK;
+            cmd_queue_commit(&cmd_queue);
+            LOG_EVENT(EV_CMD_QUEUED, cmd->cmd);
+            return RC_OK;
     }
 
-    // CTRL-ALT: Press the combination Ctrl+Alt+key
-    if(strncmp(ptr_cmd, "CTRL-ALT", strlen("CTRL-ALT")) == 0)
+    LOG_EVENT(EV_CMD_INVALID, cmd->cmd);
+
+    // A stored script can't hold device control commands
+    if(script_store.recording)
     {
-        Serial.println("CTRL_ALT command detected.");
+        LOG_ERROR("Unexpected command in stored script, discarded until its END.");
+        block_discard_start(cmd, 1);
+        return RC_BAD;
+    }
 
-        // If argument provided
-        if(argc > 0)
-        {
-            // Point to second command argument
-            ptr_argv = strstr(ptr_cmd, " ");
-            if(ptr_argv == NULL)
-                return RC_BAD;
-            if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-                return RC_BAD;
-            ptr_argv = ptr_argv + 1;
-            Serial.print("Argument received: "); Serial.println(ptr_argv);
+    // A macro or loop block that doesn't fit in the arena, or a definition that is nested or has
+    // a too long name
+    if((macro_blocks > 0) || (cmd->cmd == CMD_DEFINE))
+    {
+        LOG_ERROR("Macro or loop can't be recorded, discarded until its END.");
+        block_discard_start(cmd, macro_blocks);
+        return RC_BAD;
+    }
 
-            // Get corresponding key
-            key = ducky_key_to_hid_byte(ptr_argv);
-        }
+    LOG_ERROR("Unexpected script store or macro command.");
+    return RC_BAD;
+}
 
-        // Make the Key press combination
-        Keyboard.press(MOD_CONTROL_LEFT);
-        Keyboard.press(MOD_ALT_LEFT);
-        if(key != 0)
-            Keyboard.press(key);
-        Keyboard.releaseAll();
+// Abort the block being recorded and discard next received commands until its END
+// ends is the number of blocks open before the command that aborts them, that is also discarded
+// (a block it opens needs its own END and a nested block END closes one of them)
+void block_discard_start(const t_ducky_cmd* cmd, const uint8_t ends)
+{
+    store_record_abort(&script_store);
+    macro_record_abort(&macros);
 
-        return RC_OK;
-    }
+    block_discard_ends = ends;
+    block_discard(cmd);
+}
 
-    // CTRL-SHIFT: Press the combination Ctrl+Shift+key
-    if(strncmp(ptr_cmd, "CTRL-SHIFT", strlen("CTRL-SHIFT")) == 0)
+// Discard a received command of an aborted block, until the END that closes it
+// Nested blocks are tracked, so the END of a nested block doesn't close the aborted one
+void block_discard(const t_ducky_cmd* cmd)
+{
+    switch(cmd->cmd)
     {
-        Serial.println("CTRL-SHIFT command detected.");
-
-        // If argument provided
-        if(argc > 0)
-        {
-            // Point to second command argument
-            ptr_argv = strstr(ptr_cmd, " ");
-            if(ptr_argv == NULL)
-                return RC_BAD;
-            if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-                return RC_BAD;
-            ptr_argv = ptr_argv + 1;
-            Serial.print("Argument received: "); Serial.println(ptr_argv);
-
-            // Get corresponding key
-            key = ducky_key_to_hid_byte(ptr_argv);
-        }
+        case CMD_STORE:
+        case CMD_STORE_BOOT:
+        case CMD_DEFINE:
+        case CMD_LOOP:
+            block_discard_ends = block_discard_ends + 1;
+            break;
 
-        // Make the Key press combination
-        Keyboard.press(MOD_CONTROL_LEFT);
-        Keyboard.press(MOD_SHIFT_LEFT);
-        if(key != 0)
-            Keyboard.press(key);
-        Keyboard.releaseAll();
+        case CMD_END:
+            block_discard_ends = block_discard_ends - 1;
+            break;
 
-        return RC_OK;
+        default:
+            break;
     }
+}
+
+// Queue next command of the stored script being replayed
+void store_run_feed(void)
+{
+    t_ducky_cmd* cmd = cmd_queue_reserve(&cmd_queue);
 
-    // ALT-SHIFT: Press the combination Alt-Shift keys
-    if(strncmp(ptr_cmd, "ALT-SHIFT", strlen("ALT-SHIFT")) == 0)
+    if(store_run_next(&script_store, cmd) != RC_OK)
     {
-        Serial.println("ALT-SHIFT command detected.");
+        LOG_ERROR("Invalid stored script command, replay stopped.");
+        return;
+    }
+    cmd_queue_commit(&cmd_queue);
+    LOG_EVENT(EV_CMD_QUEUED, cmd->cmd);
+}
 
-        // If argument provided
-        if(argc > 0)
-        {
-            // Point to second command argument
-            ptr_argv = strstr(ptr_cmd, " ");
-            if(ptr_argv == NULL)
-                return RC_BAD;
-            if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-                return RC_BAD;
-            ptr_argv = ptr_argv + 1;
-            Serial.print("Argument received: "); Serial.println(ptr_argv);
+// Queue next command of the macros being replayed
+void macro_run_feed(void)
+{
+    t_ducky_cmd* cmd = cmd_queue_reserve(&cmd_queue);
+    int8_t rc = macro_run_next(&macros, cmd);
 
-            // Get corresponding key
-            key = ducky_key_to_hid_byte(ptr_argv);
-        }
+    if(rc == RC_INVALID_INPUT)
+    {
+        LOG_ERROR("Invalid macro command, unknown macro or too many nested blocks.");
+        return;
+    }
+    if(rc != RC_OK)
+        return;
+    cmd_queue_commit(&cmd_queue);
+    LOG_EVENT(EV_CMD_QUEUED, cmd->cmd);
+}
 
-        // Make the Key press combination
-        Keyboard.press(MOD_ALT_LEFT);
-        Keyboard.press(MOD_SHIFT_LEFT);
-        if(key != 0)
-            Keyboard.press(key);
-        Keyboard.releaseAll();
+// Write RAM usage statistics to Serial
+// MEMSTATS: Free RAM now and never used by the stack since startup (stack high-water mark)
+void memstats_report(void)
+{
+    Serial.print(F("RAM arena bytes: "));
+    Serial.print((uint16_t)sizeof(t_ram_arena));
+    Serial.print(F(" / "));
+    Serial.println(RAM_ARENA_BUDGET);
+    Serial.print(F("RAM free bytes: "));
+    Serial.println(mem_free());
+    Serial.print(F("RAM never used bytes: "));
+    Serial.println(mem_free_min());
+}
 
-        return RC_OK;
-    }
+/**************************************************************************************************/
 
-    // ALT-TAB: Press the combination Alt+TAB
-    if(strncmp(ptr_cmd, "ALT-TAB", strlen("ALT-TAB")) == 0)
-    {
-        Serial.println("ALT_TAB command detected.");
+/* Idle Sleep Functions */
 
-        // Make the Key press combination
-        Keyboard.press(MOD_ALT_LEFT);
-        Keyboard.press(KEY_TAB);
-        Keyboard.releaseAll();
+// Sleep until next interrupt if there is nothing to do
+// Reception ports are checked again with interrupts disabled, so a byte received after the
+// previous checks doesn't wait for another interrupt to be handled. Bytes waiting in a port
+// because its reception ring is full can't be taken anyway, so they don't prevent the sleep
+void idle_sleep_run(void)
+{
+    uint32_t asleep_us = 0;
 
-        return RC_OK;
-    }
+    idle.woken = false;
+    if(!system_idle())
+        return;
 
-    // Windows-Alt-Key
-    if((strncmp(ptr_cmd, "COMMAND-OPTION", strlen("COMMAND-OPTION")) == 0))
+    noInterrupts();
+    for(uint8_t src = 0; src < RX_SRC_NUM; src++)
     {
-        Serial.println("GUI+ALT command detected.");
-
-        // If argument provided
-        if(argc > 0)
+        if(serial_available(src) && rx_ring_free(&(rx_channels[src].ring)))
         {
-            // Point to second command argument
-            ptr_argv = strstr(ptr_cmd, " ");
-            if(ptr_argv == NULL)
-                return RC_BAD;
-            if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-                return RC_BAD;
-            ptr_argv = ptr_argv + 1;
-            Serial.print("Argument received: "); Serial.println(ptr_argv);
-
-            // Get corresponding key
-            key = ducky_key_to_hid_byte(ptr_argv);
+            interrupts();
+            return;
         }
-
-        // Make the Key press combination
-        Keyboard.press(MOD_GUI_LEFT);
-        Keyboard.press(MOD_ALT_LEFT);
-        if(key != 0)
-            Keyboard.press(key);
-        Keyboard.releaseAll();
-
-        return RC_OK;
     }
+    asleep_us = idle_sleep();
 
-    // GUI: Emulates the Windows-Key, sometimes referred to as the Command or Super-key
-    if((strncmp(ptr_cmd, "GUI", strlen("GUI")) == 0) || 
-        (strncmp(ptr_cmd, "WINDOWS", strlen("WINDOWS")) == 0) ||
-        (strncmp(ptr_cmd, "COMMAND", strlen("COMMAND")) == 0))
-    {
-        Serial.println("GUI command detected.");
+    stats_sleep(&stats, asleep_us);
+    idle.wake_us = micros();
+    idle.woken = true;
+}
 
-        // If argument provided
-        if(argc > 0)
+// Check if there is nothing to do until next interrupt (received bytes, host requests or timer
+// tick). Received lines and replays wait while the commands queue is full. EEPROM writes end
+// without an interrupt, so there is no sleep while they are waiting
+bool system_idle(void)
+{
+    if(store_writing(&script_store))
+        return false;
+    if(cmd_queue_reserve(&cmd_queue) != NULL)
+    {
+        if(script_store.running || macro_running(&macros))
+            return false;
+        for(uint8_t src = 0; src < RX_SRC_NUM; src++)
         {
-            // Point to second command argument
-            ptr_argv = strstr(ptr_cmd, " ");
-            if(ptr_argv == NULL)
-                return RC_BAD;
-            if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-                return RC_BAD;
-            ptr_argv = ptr_argv + 1;
-            Serial.print("Argument received: "); Serial.println(ptr_argv);
-
-            // Get corresponding key
-            key = ducky_key_to_hid_byte(ptr_argv);
+            if((rx_ring_free(&(rx_channels[src].ring)) < RX_RING_SIZE) ||
+               rx_channels[src].line_ready)
+                return false;
         }
+    }
 
-        // Make the Key press combination
-        Keyboard.press(MOD_GUI_LEFT);
-        if(key != 0)
-            Keyboard.press(key);
-        Keyboard.releaseAll();
+    return executor_idle();
+}
 
-        return RC_OK;
-    }
+/**************************************************************************************************/
 
-    // CTRL: Press the Ctrl key or make a combination with it pressed
-    // Arguments: BREAK, PAUSE, F1...F12, ESCAPE, ESC, Single Char
-    if((strncmp(ptr_cmd, "CONTROL", strlen("CONTROL")) == 0) || 
-        (strncmp(ptr_cmd, "CTRL", strlen("CTRL")) == 0))
-    {
-        Serial.println("CTRL command detected.");
+/* Commands Executor Functions */
 
-        // If argument provided
-        if(argc > 0)
-        {
-            // Point to second command argument
-            ptr_argv = strstr(ptr_cmd, " ");
-            if(ptr_argv == NULL)
-                return RC_BAD;
-            if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-                return RC_BAD;
-            ptr_argv = ptr_argv + 1;
-            Serial.print("Argument received: "); Serial.println(ptr_argv);
+// Ducky Script command handlers
+static int8_t cmd_repeat(const t_ducky_cmd* cmd);
+static int8_t cmd_default_delay(const t_ducky_cmd* cmd);
+static int8_t cmd_delay(const t_ducky_cmd* cmd);
+static int8_t cmd_string(const t_ducky_cmd* cmd);
+static int8_t cmd_string_delay(const t_ducky_cmd* cmd);
+static int8_t cmd_key_combination(const t_ducky_cmd* cmd);
+static int8_t cmd_single_key(const t_ducky_cmd* cmd);
+static int8_t cmd_layout(const t_ducky_cmd* cmd);
+static int8_t cmd_adaptive_delay(const t_ducky_cmd* cmd);
 
-            // Get corresponding key
-            key = ducky_key_to_hid_byte(ptr_argv);
-        }
+// Commands in progress handlers
+static int8_t cmd_string_delay_run(const t_ducky_cmd* cmd);
 
-        // Make the Key press combination
-        Keyboard.press(MOD_CONTROL_LEFT);
-        if(key != 0)
-            Keyboard.press(key);
-        Keyboard.releaseAll();
+// Commands handlers table, indexed by command ID (stored in flash)
+static const t_cmd_handler CMD_HANDLERS[CMD_NUM] PROGMEM =
+{
+    cmd_single_key,       // CMD_KEY
+    NULL,                 // CMD_REM (never queued)
+    cmd_repeat,           // CMD_REPEAT
+    cmd_default_delay,    // CMD_DEFAULT_DELAY
+    cmd_delay,            // CMD_DELAY
+    cmd_string,           // CMD_STRING
+    cmd_string_delay,     // CMD_STRING_DELAY
+    cmd_key_combination,  // CMD_CTRL_ALT
+    cmd_key_combination,  // CMD_CTRL_SHIFT
+    cmd_key_combination,  // CMD_ALT_SHIFT
+    cmd_key_combination,  // CMD_ALT_TAB
+    cmd_key_combination,  // CMD_COMMAND_OPTION
+    cmd_key_combination,  // CMD_GUI
+    cmd_key_combination,  // CMD_CTRL
+    cmd_key_combination,  // CMD_ALT
+    cmd_key_combination,  // CMD_SHIFT
+    NULL,                 // CMD_STORE (never queued)
+    NULL,                 // CMD_STORE_BOOT (never queued)
+    NULL,                 // CMD_END (never queued)
+    NULL,                 // CMD_RUN (never queued)
+    NULL,                 // CMD_MEMSTATS (never queued)
+    NULL,                 // CMD_STATS (never queued)
+    NULL,                 // CMD_RESETSTATS (never queued)
+    NULL,                 // CMD_DEFINE (never queued)
+    NULL,                 // CMD_LOOP (never queued)
+    NULL,                 // CMD_CALL (never queued)
+    cmd_layout,           // CMD_LAYOUT
+    cmd_key_combination,  // CMD_CHORD
+    cmd_adaptive_delay,   // CMD_ADAPTIVE_DELAY
+    cmd_string            // CMD_STRING_PART
+};
 
-        return RC_OK;
-    }
+// Execute queued commands as their scheduled time is reached
+void executor_run(void)
+{
+    t_ducky_cmd* cmd = NULL;
+    t_cmd_handler handler = NULL;
+    int8_t rc = RC_OK;
 
-    // ALT: Press the Alt key or make a combination with it pressed
-    // Arguments: END, ESC, ESCAPE, F1...F12, Single Char, SPACE, TAB
-    if(strncmp(ptr_cmd, "ALT", strlen("ALT")) == 0)
+    // Command in progress
+    if(executor.current != NULL)
     {
-        Serial.println("ALT command detected.");
+        rc = cmd_string_delay_run(executor.current);
+        if(rc != RC_IN_PROGRESS)
+            executor_command_done(executor.current, rc);
+        return;
+    }
 
-        // If argument provided
-        if(argc > 0)
-        {
-            // Point to second command argument
-            ptr_argv = strstr(ptr_cmd, " ");
-            if(ptr_argv == NULL)
-                return RC_BAD;
-            if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-                return RC_BAD;
-            ptr_argv = ptr_argv + 1;
-            Serial.print("Argument received: "); Serial.println(ptr_argv);
+    // Wait until next command time and until the host has processed previous one
+    if(!sched_deadline_reached(executor.next_cmd_ms))
+        return;
+    if(!pacing_probe_done(&pacing))
+        return;
 
-            // Get corresponding key
-            key = ducky_key_to_hid_byte(ptr_argv);
+    // Pending REPEAT executions of last command or next queued command
+    if(executor.repeat_left > 0)
+    {
+        executor.repeat_left = executor.repeat_left - 1;
+        executor.current_queued = false;
+        cmd = cmd_queue_last(&cmd_queue);
+    }
+    else
+    {
+        cmd = cmd_queue_peek(&cmd_queue);
+        if(cmd == NULL)
+        {
+            // Idle, keep next command time anchored to current time
+            executor.next_cmd_ms = millis();
+            pacing_idle(&pacing);
+            return;
         }
-
-        // Make the Key press combination
-        Keyboard.press(MOD_ALT_LEFT);
-        if(key != 0)
-            Keyboard.press(key);
-        Keyboard.releaseAll();
-
-        return RC_OK;
+        executor.current_queued = true;
     }
 
-    // SHIFT: Press the Shift key or make a combination with it pressed
-    // Arguments: DELETE, HOME, INSERT, PAGEUP, PAGEDOWN, WINDOWS, GUI, UPARROW, DOWNARROW, 
-    // LEFTARROW, RIGHTARROW, TAB
-    if(strncmp(ptr_cmd, "SHIFT", strlen("SHIFT")) == 0)
+    // Execute the command
+    LOG_EVENT(EV_CMD_START, cmd->cmd);
+    executor.start_us = micros();
+    if(idle.rx_wake)
+    {
+        stats_record(&stats, STATS_HIST_WAKE, executor.start_us - idle.rx_wake_us);
+        idle.rx_wake = false;
+    }
+    memcpy_P(&handler, &(CMD_HANDLERS[cmd->cmd]), sizeof(t_cmd_handler));
+    rc = handler(cmd);
+    if(rc == RC_IN_PROGRESS)
     {
-        Serial.println("Shift command detected.");
+        executor.current = cmd;
+        return;
+    }
+    executor_command_done(cmd, rc);
+}
 
-        // If argument provided
-        if(argc > 0)
-        {
-            // Point to second command argument
-            ptr_argv = strstr(ptr_cmd, " ");
-            if(ptr_argv == NULL)
-                return RC_BAD;
-            if((uint16_t)(ptr_argv - ptr_cmd) >= command_length-1)
-                return RC_BAD;
-            ptr_argv = ptr_argv + 1;
-            Serial.print("Argument received: "); Serial.println(ptr_argv);
+// Check if the executor has nothing to do until a deadline or new commands
+// Waiting for the host to process previous command ends with a keyboard LEDs report (USB
+// interrupt) or with its maximum wait deadline
+bool executor_idle(void)
+{
+    if(executor.current != NULL)
+        return !sched_deadline_reached(executor.next_char_ms);
+    if(!sched_deadline_reached(executor.next_cmd_ms) || !pacing_probe_done(&pacing))
+        return true;
 
-            // Get corresponding key
-            key = ducky_key_to_hid_byte(ptr_argv);
-        }
+    return ((executor.repeat_left == 0) && (cmd_queue_peek(&cmd_queue) == NULL) &&
+        !pacing.probed);
+}
 
-        // Make the Key press combination
-        Keyboard.press(MOD_SHIFT_LEFT);
-        if(key != 0)
-            Keyboard.press(key);
-        Keyboard.releaseAll();
+// Update the executor state once a command has been executed
+// Custom delay commands have already moved next command time from its previous deadline, so
+// consecutive delays don't drift. Other commands wait default delay from the end of their HID
+// output (or until the host processes it with adaptive pacing), except repeated executions and
+// streamed STRING line parts that are run back to back
+void executor_command_done(const t_ducky_cmd* cmd, const int8_t rc)
+{
+    LOG_EVENT(EV_CMD_DONE, rc);
+    stats_record(&stats, stats_cmd_hist(cmd->cmd), micros() - executor.start_us);
 
-        return RC_OK;
+    // Release queued command, keeping it in the queue for REPEAT command
+    if(executor.current_queued)
+    {
+        cmd_queue_pop(&cmd_queue, (cmd->cmd != CMD_REPEAT));
+        executor.current_queued = false;
     }
+    executor.current = NULL;
+
+    if(rc == RC_CUSTOM_DELAY)
+        return;
+
+    executor.next_cmd_ms = millis();
+    if((executor.repeat_left > 0) || (cmd->cmd == CMD_STRING_PART))
+        return;
+    if(pacing.max_ms != 0)
+        pacing_probe(&pacing);
+    else
+        executor.next_cmd_ms = executor.next_cmd_ms + default_delay;
+}
+
+// REPEAT: Repeats the last command n times
+// REPEAT [n]
+static int8_t cmd_repeat(const t_ducky_cmd* cmd)
+{
+    LOG_TRACE("Repeat command detected.");
 
-    // Single key commands
-    key = ducky_key_to_hid_byte(ptr_cmd);
-    if(key == KEY_UNDEFINED_ERROR)
+    // Ignore if no previous command available to be repeated
+    if(cmd_queue_last(&cmd_queue) == NULL)
     {
-        Serial.println("Unknown or unsupported command received.");
+        LOG_ERROR("No previous commands stored.");
         return RC_BAD;
     }
 
-    Serial.println("Single key command.");
-    Keyboard.write(KeyboardKeycode(key));
+    // Let the executor run previous command n times
+    executor.repeat_left = cmd->num;
+
     return RC_OK;
 }
 
-// Convert Ducky Script key name into corresponding USB-HID Code byte
-uint8_t ducky_key_to_hid_byte(const char* key)
-{
-    if(strcmp(key, "POWER") == 0)
-        return KEY_POWER;
-    if(strcmp(key, "HOME") == 0)
-        return KEY_HOME;
-    if(strcmp(key, "INSERT") == 0)
-        return KEY_INSERT;
-    if(strcmp(key, "PAGEUP") == 0)
-        return KEY_PAGEUP;
-    if(strcmp(key, "PAGEDOWN") == 0)
-        return KEY_PAGEDOWN;
-    if(strcmp(key, "PRINTSCREEN") == 0)
-        return KEY_PRINTSCREEN;
-    if(strcmp(key, "ENTER") == 0)
-        return KEY_ENTER;
-    if(strcmp(key, "SPACE") == 0)
-        return KEY_SPACE;
-    if(strcmp(key, "TAB") == 0)
-        return KEY_TAB;
-    if(strcmp(key, "END") == 0)
-        return KEY_END;
-    if(strcmp(key, "BREAK") == 0)
-        return KEY_PAUSE;
-    if((strcmp(key, "LEFTARROW") == 0) || (strcmp(key, "LEFT") == 0))
-        return KEY_LEFT;
-    if((strcmp(key, "RIGHTARROW") == 0) || (strcmp(key, "RIGHT") == 0))
-        return KEY_RIGHT;
-    if((strcmp(key, "DOWNARROW") == 0) || (strcmp(key, "DOWN") == 0))
-        return KEY_DOWN;
-    if((strcmp(key, "UPARROW") == 0) || (strcmp(key, "UP") == 0))
-        return KEY_UP;
-    if((strcmp(key, "ESCAPE") == 0) || (strcmp(key, "ESC") == 0))
-        return KEY_ESC;
-    if((strcmp(key, "DELETE") == 0) || (strcmp(key, "DEL") == 0))
-        return KEY_DELETE;
-    if((strcmp(key, "MENU") == 0) || (strcmp(key, "APP") == 0))
-        return KEY_MENU;
-    if((strcmp(key, "NUMLOCK") == 0) || (strcmp(key, "NUM_LOCK") == 0))
-        return KEY_NUM_LOCK;
-    if((strcmp(key, "CAPSLOCK") == 0) || (strcmp(key, "CAPS_LOCK") == 0))
-        return KEY_CAPS_LOCK;
-    if((strcmp(key, "SCROLLLOCK") == 0) || (strcmp(key, "SCROLL_LOCK") == 0))
-        return KEY_SCROLL_LOCK;
-    if((strcmp(key, "MEDIA_PLAY_PAUSE") == 0) || 
-        (strcmp(key, "PLAY") == 0) || (strcmp(key, "PAUSE") == 0))
-    {
-        return KEY_MEDIA_PLAY_PAUSE;
-    }
-    if((strcmp(key, "MEDIA_STOP") == 0) || (strcmp(key, "STOP") == 0))
-        return KEY_MEDIA_STOP;
-    if((strcmp(key, "MEDIA_MUTE") == 0) || (strcmp(key, "MUTE") == 0))
-        return KEY_MEDIA_MUTE;
-    if((strcmp(key, "MEDIA_VOLUME_INC") == 0) || (strcmp(key, "VOLUMEUP") == 0))
-        return KEY_MEDIA_VOLUME_INC;
-    if((strcmp(key, "MEDIA_VOLUME_DEC") == 0) || (strcmp(key, "VOLUMEDOWN") == 0))
-        return KEY_MEDIA_VOLUME_DEC;
-    if((strcmp(key, "a") == 0) || (strcmp(key, "A") == 0))
-        return KEY_A;
-    if((strcmp(key, "b") == 0) || (strcmp(key, "B") == 0))
-        return KEY_B;
-    if((strcmp(key, "c") == 0) || (strcmp(key, "C") == 0))
-        return KEY_C;
-    if((strcmp(key, "d") == 0) || (strcmp(key, "D") == 0))
-        return KEY_D;
-    if((strcmp(key, "e") == 0) || (strcmp(key, "E") == 0))
-        return KEY_E;
-    if((strcmp(key, "f") == 0) || (strcmp(key, "F") == 0))
-        return KEY_F;
-    if((strcmp(key, "g") == 0) || (strcmp(key, "G") == 0))
-        return KEY_G;
-    if((strcmp(key, "h") == 0) || (strcmp(key, "H") == 0))
-        return KEY_H;
-    if((strcmp(key, "i") == 0) || (strcmp(key, "I") == 0))
-        return KEY_I;
-    if((strcmp(key, "j") == 0) || (strcmp(key, "J") == 0))
-        return KEY_J;
-    if((strcmp(key, "k") == 0) || (strcmp(key, "K") == 0))
-        return KEY_K;
-    if((strcmp(key, "l") == 0) || (strcmp(key, "L") == 0))
-        return KEY_L;
-    if((strcmp(key, "m") == 0) || (strcmp(key, "M") == 0))
-        return KEY_M;
-    if((strcmp(key, "n") == 0) || (strcmp(key, "N") == 0))
-        return KEY_N;
-    if((strcmp(key, "o") == 0) || (strcmp(key, "O") == 0))
-        return KEY_O;
-    if((strcmp(key, "p") == 0) || (strcmp(key, "P") == 0))
-        return KEY_P;
-    if((strcmp(key, "q") == 0) || (strcmp(key, "Q") == 0))
-        return KEY_Q;
-    if((strcmp(key, "r") == 0) || (strcmp(key, "R") == 0))
-        return KEY_R;
-    if((strcmp(key, "s") == 0) || (strcmp(key, "S") == 0))
-        return KEY_S;
-    if((strcmp(key, "t") == 0) || (strcmp(key, "T") == 0))
-        return KEY_T;
-    if((strcmp(key, "u") == 0) || (strcmp(key, "U") == 0))
-        return KEY_U;
-    if((strcmp(key, "v") == 0) || (strcmp(key, "V") == 0))
-        return KEY_V;
-    if((strcmp(key, "w") == 0) || (strcmp(key, "W") == 0))
-        return KEY_W;
-    if((strcmp(key, "x") == 0) || (strcmp(key, "X") == 0))
-        return KEY_X;
-    if((strcmp(key, "y") == 0) || (strcmp(key, "Y") == 0))
-        return KEY_Y;
-    if((strcmp(key, "z") == 0) || (strcmp(key, "Z") == 0))
-        return KEY_Z;
-    if(strcmp(key, "0") == 0)
-        return KEY_0;
-    if(strcmp(key, "1") == 0)
-        return KEY_1;
-    if(strcmp(key, "2") == 0)
-        return KEY_2;
-    if(strcmp(key, "3") == 0)
-        return KEY_3;
-    if(strcmp(key, "4") == 0)
-        return KEY_4;
-    if(strcmp(key, "5") == 0)
-        return KEY_5;
-    if(strcmp(key, "6") == 0)
-        return KEY_6;
-    if(strcmp(key, "7") == 0)
-        return KEY_7;
-    if(strcmp(key, "8") == 0)
-        return KEY_8;
-    if(strcmp(key, "9") == 0)
-        return KEY_9;
-    if(strcmp(key, "F1") == 0)
-        return KEY_F1;
-    if(strcmp(key, "F2") == 0)
-        return KEY_F2;
-    if(strcmp(key, "F3") == 0)
-        return KEY_F3;
-    if(strcmp(key, "F4") == 0)
-        return KEY_F4;
-    if(strcmp(key, "F5") == 0)
-        return KEY_F5;
-    if(strcmp(key, "F6") == 0)
-        return KEY_F6;
-    if(strcmp(key, "F7") == 0)
-        return KEY_F7;
-    if(strcmp(key, "F8") == 0)
-        return KEY_F8;
-    if(strcmp(key, "F9") == 0)
-        return KEY_F9;
-
-    return KEY_UNDEFINED_ERROR;
+// DEFAULTDELAY: Define how long (milliseconds) to wait between each subsequent command
+// DEFAULTDELAY [n]
+static int8_t cmd_default_delay(const t_ducky_cmd* cmd)
+{
+    LOG_TRACE("Change default delay command detected.");
+
+    // Update default delay between commands values to received one
+    default_delay = cmd->num;
+
+    return RC_OK;
 }
 
-/**************************************************************************************************/
+// DELAY: Creates a momentary pause (ms) in the ducky script
+// DELAY [n]
+static int8_t cmd_delay(const t_ducky_cmd* cmd)
+{
+    LOG_TRACE("Delay command detected.");
 
-/* Auxiliar Functions */
+    // Move next command time from this command scheduled time
+    executor.next_cmd_ms = executor.next_cmd_ms + cmd->num;
+
+    return RC_CUSTOM_DELAY;
+}
 
-// Count the number of words inside a string
-uint32_t cstr_count_words(const char* str_in, const size_t str_in_len)
+// STRING_DELAY: Write the text waiting n milliseconds between each character
+// STRING_DELAY n text
+static int8_t cmd_string_delay(const t_ducky_cmd* cmd)
 {
-    uint32_t n = 1;
+    LOG_TRACE("String delay command detected.");
 
-    // Check if string is empty
-    if(str_in[0] == '\0')
-        return 0;
+    // Text and delay are read by the command in progress handler
+    (void)cmd;
 
-    // Check for character occurrences
-    for(size_t i = 1; i < str_in_len; i++)
-    {
-        // Check if end of string detected
-        if(str_in[i] == '\0')
-            break;
+    // Let the executor print each character and wait between them
+    executor.text_index = 0;
+    executor.next_char_ms = millis();
 
-        // Check if pattern "X Y", "X\rY" or "X\nY" does not meet
-        if((str_in[i] != ' ') && (str_in[i] != '\r') && (str_in[i] != '\n'))
-            continue;
-        if((str_in[i-1] == ' ') || (str_in[i-1] == '\r') || (str_in[i-1] == '\n'))
-            continue;
-        if((str_in[i+1] == ' ') || (str_in[i+1] == '\r') || (str_in[i+1] == '\n'))
-            continue;
-        if(str_in[i+1] == '\0')
-            continue;
+    return RC_IN_PROGRESS;
+}
 
-        // Pattern detected, increase word count
-        n = n + 1;
+// STRING_DELAY in progress: Write next character once its time is reached
+static int8_t cmd_string_delay_run(const t_ducky_cmd* cmd)
+{
+    if(!sched_deadline_reached(executor.next_char_ms))
+        return RC_IN_PROGRESS;
+
+    // All characters written and last interval elapsed
+    if(executor.text_index >= cmd->text_len)
+        return RC_OK;
+
+    hid_string_write(&(cmd->text[executor.text_index]), 1);
+    executor.text_index = executor.text_index + 1;
+    executor.next_char_ms = executor.next_char_ms + pacing_char_delay(&pacing, cmd->num);
+
+    return RC_IN_PROGRESS;
+}
+
+// STRING: Processes the text following taking special care to auto-shift
+// STRING text
+static int8_t cmd_string(const t_ducky_cmd* cmd)
+{
+    LOG_TRACE("String command detected.");
+
+    hid_string_write(cmd->text, cmd->text_len);
+
+    return RC_OK;
+}
+
+// Key combinations: Press modifiers keys (CTRL, ALT, SHIFT, GUI...) and an optional key
+// [CTRL | CONTROL | ALT | SHIFT | GUI | WINDOWS | COMMAND | CTRL-ALT | CTRL-SHIFT | ALT-SHIFT |
+//  COMMAND-OPTION] [more modifiers] [key name]
+// ALT-TAB
+// Any combination of modifiers joined by spaces or '-' (i.e. "GUI-SHIFT s") is a CHORD command
+static int8_t cmd_key_combination(const t_ducky_cmd* cmd)
+{
+    LOG_TRACE("Key combination command detected.");
+
+    // Press all the keys in a single report and release them in another one
+    for(uint8_t i = 0; i < 8; i++)
+    {
+        if(cmd->modifiers & (1 << i))
+            Keyboard.add(KeyboardKeycode(MOD_CONTROL_LEFT + i));
     }
+    if(cmd->key != 0)
+        Keyboard.add(KeyboardKeycode(cmd->key));
+    Keyboard.send();
+    Keyboard.releaseAll();
 
-    return n;
+    return RC_OK;
 }
 
-// Safe conversion a string number into uint32_t element
-int8_t safe_atoi_u32(const char* in_str, const size_t in_str_len, uint32_t* out_int, 
-    bool check_null_terminated)
+// Single key commands
+// [key name]
+static int8_t cmd_single_key(const t_ducky_cmd* cmd)
 {
-	size_t converted_num;
-	size_t multiplicator;
+    LOG_TRACE("Single key command.");
+
+    Keyboard.write(KeyboardKeycode(cmd->key));
+
+    return RC_OK;
+}
 
-	// Check if input str has less or more chars than expected int32_t range (1 to 3 chars)
-	if((in_str_len < 1) || (in_str_len > 10))
-		return RC_INVALID_INPUT;
+// LAYOUT: Select the keyboard layout of the host used to type text
+// LAYOUT [US|UK|DE|FR|ES]
+static int8_t cmd_layout(const t_ducky_cmd* cmd)
+{
+    LOG_TRACE("Layout command detected.");
 
-	// Check if input str is not terminated
-    if(check_null_terminated)
+    if(hid_layout_select(cmd->text, cmd->text_len) != RC_OK)
     {
-	    if(in_str[in_str_len] != '\0')
-		    return RC_INVALID_INPUT;
+        LOG_ERROR("Unknown keyboard layout.");
+        return RC_BAD;
     }
 
-	// Check if any of the character of the str is not a number
-	for(uint8_t i = 0; i < in_str_len; i++)
-	{
-		if(in_str[i] < '0' || in_str[i] > '9')
-			return RC_BAD;
-	}
-
-	// Create the int
-	converted_num = 0;
-	for(uint8_t i = 0; i < in_str_len; i++)
-	{
-		multiplicator = 1;
-		for(uint8_t ii = in_str_len-1-i; ii > 0; ii--)
-			multiplicator = multiplicator * 10;
-
-		converted_num = converted_num + (multiplicator * (in_str[i] - '0'));
-	}
-
-	// Check if number is higher than max uint32_t val
-	if(converted_num > UINT32_MAX)
-		return RC_BAD;
-
-	// Get the converted number and return operation success
-	*out_int = (uint32_t)converted_num;
-	return RC_OK;
+    return RC_OK;
+}
+
+// ADAPTIVE_DELAY: Wait until the host processes each command (up to n ms) instead of the
+// default delay, 0 disables it
+// ADAPTIVE_DELAY [n]
+static int8_t cmd_adaptive_delay(const t_ducky_cmd* cmd)
+{
+    LOG_TRACE("Adaptive delay command detected.");
+
+    pacing_enable(&pacing, cmd->num);
+
+    return RC_OK;
 }
@@ -0,0 +1,79 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     memstats.cpp                                                                               */
+/* Description:                                                                                   */
+/*     SRAM usage statistics (free memory between heap and stack, and stack high-water mark).     */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "memstats.h"
+
+/**************************************************************************************************/
+
+/* AVR Memory Layout */
+
+#if defined(__AVR__)
+
+// Start of the heap (end of static data) and current heap end (0 if malloc() was never used)
+extern uint8_t __heap_start;
+extern void* __brkval;
+
+// Paint the memory between static data and the stack with the canary value
+// It runs before any C/C++ initialization code (.init3 section), so it can't use the stack
+void mem_paint(void) __attribute__((naked, used, section(".init3")));
+void mem_paint(void)
+{
+    uint8_t* p = &__heap_start;
+
+    while(p < (uint8_t*)SP)
+    {
+        *p = MEM_CANARY;
+        p = p + 1;
+    }
+}
+
+// Get current heap end
+static uint8_t* heap_end(void)
+{
+    if(__brkval == 0)
+        return &__heap_start;
+    return (uint8_t*)__brkval;
+}
+
+#endif
+
+/**************************************************************************************************/
+
+/* Statistics Functions */
+
+// Get current free memory between heap end and stack (0 if it is not available)
+uint16_t mem_free(void)
+{
+    #if defined(__AVR__)
+        uint8_t top = 0;
+        return (uint16_t)(&top - heap_end());
+    #else
+        return 0;
+    #endif
+}
+
+// Get free memory that has never been used by the stack since startup (0 if it is not available)
+// Counts the canary values that are still in place from the heap end up
+uint16_t mem_free_min(void)
+{
+    #if defined(__AVR__)
+        uint8_t* p = heap_end();
+        uint16_t free_min = 0;
+
+        while((p < (uint8_t*)SP) && (*p == MEM_CANARY))
+        {
+            free_min = free_min + 1;
+            p = p + 1;
+        }
+
+        return free_min;
+    #else
+        return 0;
+    #endif
+}
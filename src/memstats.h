@@ -0,0 +1,36 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     memstats.h                                                                                 */
+/* Description:                                                                                   */
+/*     SRAM usage statistics (free memory between heap and stack, and stack high-water mark).     */
+/**************************************************************************************************/
+
+#ifndef MEMSTATS_H_
+#define MEMSTATS_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Value painted on free memory at startup to detect the stack high-water mark
+#define MEM_CANARY 0xC5
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Get current free memory between heap end and stack (0 if it is not available)
+uint16_t mem_free(void);
+
+// Get free memory that has never been used by the stack since startup (0 if it is not available)
+uint16_t mem_free_min(void);
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,102 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     pacing.cpp                                                                                 */
+/* Description:                                                                                   */
+/*     Closed loop keystrokes pacing: the host keyboard LEDs output reports are used to know when */
+/*     the host has processed the sent keystrokes.                                                */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <HID-Project.h>
+#include "pacing.h"
+
+/**************************************************************************************************/
+
+/* Pacing Functions */
+
+// Enable adaptive pacing with a maximum wait for the host (ms), disable it if 0
+// The round trip estimate is kept, a host doesn't get faster by changing the bound
+void pacing_enable(t_pacing* pacing, const uint32_t max_ms)
+{
+    pacing->max_ms = max_ms;
+    pacing->probing = false;
+}
+
+// Send a probe to the host
+void pacing_probe(t_pacing* pacing)
+{
+    pacing->leds = Keyboard.getLeds();
+    if(!pacing->probed)
+    {
+        pacing->leds_original = pacing->leds;
+        pacing->probed = true;
+    }
+
+    Keyboard.write(KeyboardKeycode(PACING_PROBE_KEY));
+    pacing->probe_us = micros();
+    pacing->probing = true;
+}
+
+// Check if the host has processed the last probe (or its maximum wait has elapsed)
+// Round trip time is smoothed with an exponential moving average (1/4 weight of new samples),
+// timed out probes count as the maximum wait
+bool pacing_probe_done(t_pacing* pacing)
+{
+    uint32_t elapsed_us = 0;
+    uint32_t max_ms = pacing->max_ms;
+
+    if(!pacing->probing)
+        return true;
+    if(max_ms == 0)
+        max_ms = PACING_RESTORE_MAX_MS;
+
+    elapsed_us = micros() - pacing->probe_us;
+    if((Keyboard.getLeds() ^ pacing->leds) & PACING_PROBE_LED)
+    {
+        if(elapsed_us < PACING_MIN_MS * 1000UL)
+            return false;
+    }
+    else if(elapsed_us < max_ms * 1000UL)
+        return false;
+
+    if(pacing->rtt_us == 0)
+        pacing->rtt_us = elapsed_us;
+    else
+        pacing->rtt_us = pacing->rtt_us - (pacing->rtt_us / 4) + (elapsed_us / 4);
+    pacing->probing = false;
+
+    return true;
+}
+
+// Get the delay between characters of a text, bounded by a maximum delay (ms)
+// Characters follow the host round trip time instead of the maximum delay once it is known
+uint32_t pacing_char_delay(const t_pacing* pacing, const uint32_t max_ms)
+{
+    uint32_t delay_ms = 0;
+
+    if((pacing->max_ms == 0) || (pacing->rtt_us == 0))
+        return max_ms;
+
+    delay_ms = (pacing->rtt_us + 999) / 1000;
+    if(delay_ms < PACING_MIN_MS)
+        delay_ms = PACING_MIN_MS;
+    if(delay_ms > max_ms)
+        delay_ms = max_ms;
+
+    return delay_ms;
+}
+
+// Restore the probe LED original state when there are no more commands
+void pacing_idle(t_pacing* pacing)
+{
+    if(!pacing->probed || !pacing_probe_done(pacing))
+        return;
+
+    if((Keyboard.getLeds() ^ pacing->leds_original) & PACING_PROBE_LED)
+    {
+        pacing_probe(pacing);
+        return;
+    }
+    pacing->probed = false;
+}
@@ -0,0 +1,104 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     pacing.h                                                                                   */
+/* Description:                                                                                   */
+/*     Closed loop keystrokes pacing: the host keyboard LEDs output reports are used to know when */
+/*     the host has processed the sent keystrokes.                                                */
+/**************************************************************************************************/
+
+/* Adaptive Pacing:
+ *
+ * The host keeps the lock keys LEDs state and sends it to every keyboard in an output report
+ * after it processes a lock key press. So after each command a probe (a lock key press and
+ * release) is sent and next command waits until the probe LED toggles: every keystroke sent
+ * before the probe has then been processed by the host. The wait is bounded by a maximum time,
+ * so a host that doesn't echo the LEDs (or a lost probe) only falls back to that delay.
+ *
+ * The probe key is toggled twice the number of commands, the LED original state is restored
+ * once the executor is idle. Scroll Lock is used by default as it doesn't change typed text (Caps
+ * Lock would do it) and it is processed by Windows and Linux hosts, but it can be changed in the
+ * build (i.e. -DPACING_PROBE_KEY=KEY_CAPS_LOCK). The LED of a lock key is derived from it, any
+ * other probe key needs its LED too (-DPACING_PROBE_LED).
+ */
+
+#ifndef PACING_H_
+#define PACING_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "hidkeys.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Keyboard LEDs output report bits
+#define PACING_LED_NUM_LOCK 0x01
+#define PACING_LED_CAPS_LOCK 0x02
+#define PACING_LED_SCROLL_LOCK 0x04
+
+// Lock key used as probe and its LED
+#ifndef PACING_PROBE_KEY
+    #define PACING_PROBE_KEY KEY_SCROLL_LOCK
+#endif
+#ifndef PACING_PROBE_LED
+    #if PACING_PROBE_KEY == KEY_NUM_LOCK
+        #define PACING_PROBE_LED PACING_LED_NUM_LOCK
+    #elif PACING_PROBE_KEY == KEY_CAPS_LOCK
+        #define PACING_PROBE_LED PACING_LED_CAPS_LOCK
+    #elif PACING_PROBE_KEY == KEY_SCROLL_LOCK
+        #define PACING_PROBE_LED PACING_LED_SCROLL_LOCK
+    #else
+        #error "PACING_PROBE_LED must be defined for a PACING_PROBE_KEY that is not a lock key"
+    #endif
+#endif
+
+// Minimum delay between commands and characters (ms)
+#ifndef PACING_MIN_MS
+    #define PACING_MIN_MS 1
+#endif
+
+// Maximum wait for the LED restore probe echo if adaptive pacing has been disabled (ms)
+#define PACING_RESTORE_MAX_MS 1000
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Adaptive pacing state
+typedef struct
+{
+    uint32_t max_ms;        // Maximum wait for the host (0 if adaptive pacing is disabled)
+    uint32_t probe_us;      // Time when the waited probe was sent
+    uint32_t rtt_us;        // Smoothed probe round trip time (0 if there is no sample yet)
+    uint8_t leds;           // Host LEDs when the waited probe was sent
+    uint8_t leds_original;  // Host LEDs before the first probe
+    bool probing;           // Waiting for a probe echo
+    bool probed;            // Probes have been sent since the LEDs were restored
+} t_pacing;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Enable adaptive pacing with a maximum wait for the host (ms), disable it if 0
+void pacing_enable(t_pacing* pacing, const uint32_t max_ms);
+
+// Send a probe to the host
+void pacing_probe(t_pacing* pacing);
+
+// Check if the host has processed the last probe (or its maximum wait has elapsed)
+bool pacing_probe_done(t_pacing* pacing);
+
+// Get the delay between characters of a text, bounded by a maximum delay (ms)
+uint32_t pacing_char_delay(const t_pacing* pacing, const uint32_t max_ms);
+
+// Restore the probe LED original state when there are no more commands
+void pacing_idle(t_pacing* pacing);
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,27 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     returncodes.h                                                                              */
+/* Description:                                                                                   */
+/*     Functions return codes shared by all the firmware modules.                                 */
+/**************************************************************************************************/
+
+#ifndef RETURNCODES_H_
+#define RETURNCODES_H_
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Functions Return Codes
+enum _return_codes
+{
+    RC_OK = 0,
+    RC_BAD = -1,
+    RC_INVALID_INPUT = -2,
+    RC_CUSTOM_DELAY = 100,
+    RC_IN_PROGRESS = 101
+};
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,30 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     scheduler.cpp                                                                              */
+/* Description:                                                                                   */
+/*     Absolute deadlines time helpers for the cooperative (non-blocking) commands executor.      */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "scheduler.h"
+
+/**************************************************************************************************/
+
+/* Scheduler Functions */
+
+// Check if an absolute deadline (ms) has been reached (safe against millis() overflow)
+bool sched_deadline_reached(const uint32_t deadline)
+{
+    return ((int32_t)(millis() - deadline) >= 0);
+}
+
+// Get the remaining time (ms) until an absolute deadline (0 if already reached)
+uint32_t sched_time_to(const uint32_t deadline)
+{
+    int32_t remaining = (int32_t)(deadline - millis());
+
+    if(remaining <= 0)
+        return 0;
+    return (uint32_t)remaining;
+}
@@ -0,0 +1,29 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     scheduler.h                                                                                */
+/* Description:                                                                                   */
+/*     Absolute deadlines time helpers for the cooperative (non-blocking) commands executor.      */
+/**************************************************************************************************/
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Check if an absolute deadline (ms) has been reached (safe against millis() overflow)
+bool sched_deadline_reached(const uint32_t deadline);
+
+// Get the remaining time (ms) until an absolute deadline (0 if already reached)
+uint32_t sched_time_to(const uint32_t deadline);
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,214 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     scriptstore.cpp                                                                            */
+/* Description:                                                                                   */
+/*     Storage of a compiled script in EEPROM to be replayed on demand or at boot.                */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <EEPROM.h>
+#include "scriptstore.h"
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions Prototypes */
+
+// Get the stored script length from the image header (0 if there is no valid script)
+static uint16_t stored_length(void);
+
+// Queue bytes to be written to the EEPROM (previous waiting ones are written first)
+static void write_start(t_script_store* store, const uint16_t address, const uint8_t* data,
+    const uint8_t len);
+
+// Write all the waiting bytes to the EEPROM, waiting for each byte write
+static void write_flush(t_script_store* store);
+
+/**************************************************************************************************/
+
+/* Record Functions */
+
+// Start recording a new script (current one is invalidated)
+void store_record_start(t_script_store* store, const uint8_t flags)
+{
+    const uint8_t erased = 0xFF;
+
+    write_start(store, 0, &erased, 1);
+    store->length = 0;
+    store->flags = flags;
+    store->recording = true;
+    store->running = false;
+}
+
+// Append a compiled command to the script being recorded
+// Recording is aborted if the command doesn't fit in the EEPROM. Its bytes are written by
+// store_write_poll(), next commands should wait until they are written
+int8_t store_record(t_script_store* store, const t_ducky_cmd* cmd)
+{
+    uint8_t code[DUCKY_BYTECODE_MAX_SIZE];
+    uint16_t code_len = 0;
+
+    if(!store->recording)
+        return RC_BAD;
+
+    code_len = ducky_bytecode_encode(cmd, code, sizeof(code));
+    if((code_len == 0) || (store->length + code_len > STORE_CAPACITY))
+    {
+        store->recording = false;
+        return RC_BAD;
+    }
+
+    write_start(store, STORE_HEADER_SIZE + store->length, code, code_len);
+    store->length = store->length + code_len;
+
+    return RC_OK;
+}
+
+// Abort recording the script (nothing is stored)
+// The image magic was cleared when recording started, so there is no valid script left
+void store_record_abort(t_script_store* store)
+{
+    store->recording = false;
+}
+
+// Finish recording the script, making it valid to be replayed
+// The header is written from its last byte, so the magic is the last written byte
+int8_t store_record_end(t_script_store* store)
+{
+    uint8_t header[STORE_HEADER_SIZE] =
+        { STORE_MAGIC_0, STORE_MAGIC_1, store->flags, (uint8_t)(store->length & 0xFF),
+          (uint8_t)(store->length >> 8) };
+
+    if(!store->recording)
+        return RC_BAD;
+    store->recording = false;
+
+    write_start(store, 0, header, sizeof(header));
+
+    return RC_OK;
+}
+
+/**************************************************************************************************/
+
+/* Replay Functions */
+
+// Start replaying the stored script
+int8_t store_run_start(t_script_store* store)
+{
+    if(store->recording)
+        return RC_BAD;
+    write_flush(store);
+
+    store->length = stored_length();
+    if(store->length == 0)
+        return RC_BAD;
+    store->position = 0;
+    store->running = true;
+
+    return RC_OK;
+}
+
+// Get next command of the script being replayed (RC_BAD once it ends)
+// Replay is stopped if an invalid command is found
+int8_t store_run_next(t_script_store* store, t_ducky_cmd* cmd)
+{
+    uint8_t code[DUCKY_BYTECODE_MAX_SIZE];
+    uint16_t code_len = 0;
+    int16_t code_size = 0;
+
+    if(!store->running)
+        return RC_BAD;
+
+    // Read command bytes until its size is known and all of them are read
+    while((code_len < sizeof(code)) && (store->position + code_len < store->length))
+    {
+        code[code_len] = EEPROM.read(STORE_HEADER_SIZE + store->position + code_len);
+        code_len = code_len + 1;
+        code_size = ducky_bytecode_size(code, code_len);
+        if((code_size < 0) || ((code_size > 0) && (code_len >= code_size)))
+            break;
+    }
+
+    if((code_size <= 0) || (code_len < code_size) ||
+       (ducky_bytecode_decode(code, code_len, cmd) != RC_OK) || ducky_cmd_is_control(cmd->cmd))
+    {
+        store->running = false;
+        return RC_BAD;
+    }
+
+    store->position = store->position + code_len;
+    if(store->position >= store->length)
+        store->running = false;
+
+    return RC_OK;
+}
+
+// Get the flags of the stored script (0 if there is no valid script)
+uint8_t store_flags(void)
+{
+    if(stored_length() == 0)
+        return 0;
+    return EEPROM.read(2);
+}
+
+/**************************************************************************************************/
+
+/* EEPROM Write Functions */
+
+// Write the waiting bytes to the EEPROM while it is ready, without waiting for a byte write
+// Unchanged bytes are not written, so several of them can be checked in a single call
+void store_write_poll(t_script_store* store)
+{
+    while((store->write_len > 0) && eeprom_is_ready())
+    {
+        store->write_len = store->write_len - 1;
+        EEPROM.update(store->write_address + store->write_len,
+            store->write_data[store->write_len]);
+    }
+}
+
+// Check if there are bytes waiting to be written to the EEPROM
+bool store_writing(const t_script_store* store)
+{
+    return (store->write_len > 0);
+}
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Get the stored script length from the image header (0 if there is no valid script)
+static uint16_t stored_length(void)
+{
+    uint16_t length = 0;
+
+    if((EEPROM.read(0) != STORE_MAGIC_0) || (EEPROM.read(1) != STORE_MAGIC_1))
+        return 0;
+
+    length = EEPROM.read(3) | (((uint16_t)EEPROM.read(4)) << 8);
+    if(length > STORE_CAPACITY)
+        return 0;
+
+    return length;
+}
+
+// Queue bytes to be written to the EEPROM (previous waiting ones are written first)
+static void write_start(t_script_store* store, const uint16_t address, const uint8_t* data,
+    const uint8_t len)
+{
+    write_flush(store);
+    memcpy(store->write_data, data, len);
+    store->write_address = address;
+    store->write_len = len;
+}
+
+// Write all the waiting bytes to the EEPROM, waiting for each byte write
+static void write_flush(t_script_store* store)
+{
+    while(store->write_len > 0)
+    {
+        store->write_len = store->write_len - 1;
+        EEPROM.update(store->write_address + store->write_len,
+            store->write_data[store->write_len]);
+    }
+}
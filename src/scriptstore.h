@@ -0,0 +1,105 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     scriptstore.h                                                                              */
+/* Description:                                                                                   */
+/*     Storage of a compiled script in EEPROM to be replayed on demand or at boot.                */
+/**************************************************************************************************/
+
+/* EEPROM Image Format:
+ *
+ *     [magic 'D'] [magic 'S'] [flags] [length low] [length high] [bytecode commands]
+ *
+ * Commands are stored in the bytecode format (see duckybytecode.h). The magic is written once the
+ * whole script has been stored, so a partially stored script is never replayed.
+ *
+ * An EEPROM byte write takes 3.3 ms, so the bytes of a recorded command wait in a buffer and are
+ * written one at a time while the EEPROM is ready (store_write_poll()), instead of blocking the
+ * reception until all of them are written.
+ */
+
+#ifndef SCRIPTSTORE_H_
+#define SCRIPTSTORE_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "returncodes.h"
+#include "duckyparser.h"
+#include "duckybytecode.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// EEPROM size used for the image (atmega32u4 has 1KB)
+#ifndef STORE_EEPROM_SIZE
+    #define STORE_EEPROM_SIZE 1024
+#endif
+
+// Image header
+#define STORE_MAGIC_0 'D'
+#define STORE_MAGIC_1 'S'
+#define STORE_HEADER_SIZE 5
+
+// Maximum size of stored commands
+#define STORE_CAPACITY (STORE_EEPROM_SIZE - STORE_HEADER_SIZE)
+
+// Bytes waiting to be written to the EEPROM (a command or the image header)
+#define STORE_WRITE_SIZE DUCKY_BYTECODE_MAX_SIZE
+
+// Image flags
+#define STORE_FLAG_BOOT 0x01  // Replay the script at boot
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Script store state
+typedef struct
+{
+    uint16_t length;    // Stored commands bytes (written ones while recording)
+    uint16_t position;  // Next command to replay
+    uint8_t flags;      // Flags of the image being recorded
+    bool recording;
+    bool running;
+    uint8_t write_data[STORE_WRITE_SIZE];   // Bytes waiting to be written to the EEPROM
+    uint16_t write_address;                 // EEPROM address of the first waiting byte
+    uint8_t write_len;                      // Waiting bytes (written from the last one)
+} t_script_store;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Start recording a new script (current one is invalidated)
+void store_record_start(t_script_store* store, const uint8_t flags);
+
+// Append a compiled command to the script being recorded
+int8_t store_record(t_script_store* store, const t_ducky_cmd* cmd);
+
+// Abort recording the script (nothing is stored)
+void store_record_abort(t_script_store* store);
+
+// Finish recording the script, making it valid to be replayed
+int8_t store_record_end(t_script_store* store);
+
+// Start replaying the stored script
+int8_t store_run_start(t_script_store* store);
+
+// Get next command of the script being replayed (RC_BAD once it ends)
+int8_t store_run_next(t_script_store* store, t_ducky_cmd* cmd);
+
+// Get the flags of the stored script (0 if there is no valid script)
+uint8_t store_flags(void);
+
+// Write the waiting bytes to the EEPROM while it is ready, without waiting for a byte write
+void store_write_poll(t_script_store* store);
+
+// Check if there are bytes waiting to be written to the EEPROM
+bool store_writing(const t_script_store* store);
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,459 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     serialrx.cpp                                                                               */
+/* Description:                                                                                   */
+/*     Per source lock-free reception ring buffers and line assemblers.                           */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <string.h>
+#include "serialrx.h"
+
+/**************************************************************************************************/
+
+/* Ring Buffer Functions */
+
+// Push a received byte into a ring buffer (to be called from the producer side)
+bool rx_ring_push(t_rx_ring* ring, const uint8_t byte)
+{
+    uint8_t head = ring->head;
+
+    // Check if the ring buffer is full
+    if((uint8_t)(head - ring->tail) >= RX_RING_SIZE)
+    {
+        ring->dropped = ring->dropped + 1;
+        return false;
+    }
+
+    // Data must be written before publishing it by moving the head
+    ring->data[head & (RX_RING_SIZE-1)] = byte;
+    ring->head = head + 1;
+
+    return true;
+}
+
+// Pop a byte from a ring buffer (to be called from the consumer side)
+bool rx_ring_pop(t_rx_ring* ring, uint8_t* byte)
+{
+    uint8_t tail = ring->tail;
+
+    // Check if the ring buffer is empty
+    if(ring->head == tail)
+        return false;
+
+    *byte = ring->data[tail & (RX_RING_SIZE-1)];
+    ring->tail = tail + 1;
+
+    return true;
+}
+
+// Get next byte of a ring buffer without removing it (to be called from the consumer side)
+bool rx_ring_peek(const t_rx_ring* ring, uint8_t* byte)
+{
+    uint8_t tail = ring->tail;
+
+    if(ring->head == tail)
+        return false;
+
+    *byte = ring->data[tail & (RX_RING_SIZE-1)];
+
+    return true;
+}
+
+// Get the number of free bytes of a ring buffer
+uint8_t rx_ring_free(const t_rx_ring* ring)
+{
+    return RX_RING_SIZE - (uint8_t)(ring->head - ring->tail);
+}
+
+/**************************************************************************************************/
+
+/* Private Functions Prototypes */
+
+// Process a received byte of a frame, return true when frame payload is a line to be executed
+static bool frame_assemble(t_rx_channel* channel, const uint8_t byte);
+
+// Process a completed frame, return true when its payload is a line to be executed
+static bool frame_complete(t_rx_channel* channel);
+
+// Check if a channel text line is a STRING line to be streamed once it fills the line buffer
+static bool stream_line(const t_rx_channel* channel);
+
+/**************************************************************************************************/
+
+/* Line Assembler Functions */
+
+// Initialize a reception channel
+void rx_channel_init(t_rx_channel* channel)
+{
+    memset(channel, 0, sizeof(t_rx_channel));
+    channel->frame_last_seq = -1;
+}
+
+// Move ring buffer bytes into channel line assembler and detect end of line
+// A text line is completed by '\r' or '\n' (empty lines are ignored) or when line buffer gets
+// full. A line starting with a bytecode opcode is completed once all its operands are received.
+// A compressed text line is completed by '\r' or '\n' (decoded text beyond the line buffer is
+// truncated). A STRING line that doesn't fit in the line buffer is streamed: its text is split in
+// parts of a full line buffer (so each part is typed with the same reports packing of a whole
+// line), and last part is completed by the end of line
+int8_t rx_line_assemble(t_rx_channel* channel, t_span* line)
+{
+    uint8_t byte = 0;
+    int16_t code_size = 0;
+    bool line_start = false;
+
+    // Previous line has not been released yet
+    if(channel->line_ready)
+        return RC_BAD;
+
+    // Each frame reply has to be sent before assembling the next one
+    while(channel->reply == 0)
+    {
+        // Full STRING line, it is streamed unless its end of line is next byte
+        #if RX_STREAM_STRING
+            if((channel->line_length >= RX_LINE_SIZE-1) && stream_line(channel))
+            {
+                if(!rx_ring_peek(&(channel->ring), &byte))
+                    break;
+                if((byte != '\n') && (byte != '\r'))
+                {
+                    if(channel->line_stream == RX_STREAM_NONE)
+                    {
+                        channel->line_length = channel->line_length - RX_STREAM_PREFIX_LEN;
+                        memmove(channel->line, &(channel->line[RX_STREAM_PREFIX_LEN]),
+                            channel->line_length);
+                        channel->line_stream = RX_STREAM_PART;
+                    }
+                    channel->line_ready = true;
+                    break;
+                }
+            }
+        #endif
+
+        if(!rx_ring_pop(&(channel->ring), &byte))
+            break;
+
+        line_start = (channel->line_length == 0) && (channel->line_stream == RX_STREAM_NONE);
+
+        // Framed line, bytes out of a frame are discarded after a corrupted one (and always in
+        // framed only mode)
+        if((line_start && (channel->frame_state == RX_FRAME_ST_NONE)) ||
+           (channel->frame_state == RX_FRAME_ST_HUNT))
+        {
+            if(byte == RX_FRAME_SYNC)
+            {
+                channel->frame_state = RX_FRAME_ST_TYPE;
+                channel->frame_crc = RX_FRAME_CRC_INIT;
+                continue;
+            }
+            if(channel->frame_state == RX_FRAME_ST_HUNT)
+                continue;
+            if(RX_FRAMED_ONLY)
+            {
+                if((byte == '\n') || (byte == '\r'))
+                    channel->frame_last_seq = -1;
+                continue;
+            }
+        }
+        if(channel->frame_state != RX_FRAME_ST_NONE)
+        {
+            if(frame_assemble(channel, byte))
+            {
+                channel->line_ready = true;
+                break;
+            }
+            continue;
+        }
+
+        // Compressed text line, decoded as it is received
+        if(line_start && !channel->line_lz && (byte == LZ_LINE_MARK))
+        {
+            channel->line_lz = true;
+            continue;
+        }
+        if(channel->line_lz)
+        {
+            if((byte == '\n') || (byte == '\r'))
+            {
+                if(channel->line_length == 0)
+                {
+                    channel->line_lz = false;
+                    continue;
+                }
+                channel->line_ready = true;
+                break;
+            }
+            channel->line_length = ducky_lz_decode(&(channel->lz), byte, channel->line,
+                channel->line_length, RX_LINE_SIZE-1);
+            continue;
+        }
+
+        // Bytecode command
+        if(line_start && ducky_bytecode_is_opcode(byte))
+            channel->line_binary = true;
+        if(channel->line_binary)
+        {
+            channel->line[channel->line_length] = (char)byte;
+            channel->line_length = channel->line_length + 1;
+            code_size = ducky_bytecode_size((const uint8_t*)channel->line, channel->line_length);
+            if((code_size < 0) || ((code_size > 0) && (channel->line_length >= code_size)) ||
+               (channel->line_length >= RX_LINE_SIZE))
+            {
+                channel->line_ready = true;
+                break;
+            }
+            continue;
+        }
+
+        // A SYNC can't be part of a text line, the partial line is discarded (i.e. a frame with a
+        // corrupted SYNC byte) and a frame is started
+        if((byte == RX_FRAME_SYNC) && (channel->line_stream == RX_STREAM_NONE))
+        {
+            channel->line_length = 0;
+            channel->frame_state = RX_FRAME_ST_TYPE;
+            channel->frame_crc = RX_FRAME_CRC_INIT;
+            continue;
+        }
+
+        // End of line (it ends the frames sequence, next frame is accepted with any sequence)
+        if((byte == '\n') || (byte == '\r'))
+        {
+            channel->frame_last_seq = -1;
+            if(channel->line_stream != RX_STREAM_NONE)
+                channel->line_stream = RX_STREAM_END;
+            else if(channel->line_length == 0)
+                continue;
+            channel->line_ready = true;
+            break;
+        }
+
+        channel->line[channel->line_length] = (char)byte;
+        channel->line_length = channel->line_length + 1;
+
+        // Line buffer full (a STRING line waits for next byte)
+        if((channel->line_length >= RX_LINE_SIZE-1) && !stream_line(channel))
+        {
+            channel->line_ready = true;
+            break;
+        }
+    }
+
+    if(!channel->line_ready)
+        return RC_BAD;
+
+    if(!channel->line_binary)
+        channel->line[channel->line_length] = '\0';
+    line->ptr = channel->line;
+    line->len = channel->line_length;
+
+    return RC_OK;
+}
+
+// Process a received byte of a frame, return true when frame payload is a line to be executed
+static bool frame_assemble(t_rx_channel* channel, const uint8_t byte)
+{
+    if(channel->frame_state < RX_FRAME_ST_CRC_HIGH)
+        channel->frame_crc = rx_crc16_update(channel->frame_crc, byte);
+
+    switch(channel->frame_state)
+    {
+        case RX_FRAME_ST_TYPE:
+            channel->frame_type = byte;
+            channel->frame_state = RX_FRAME_ST_SEQ;
+            break;
+
+        case RX_FRAME_ST_SEQ:
+            channel->frame_seq = byte;
+            channel->frame_state = RX_FRAME_ST_LENGTH;
+            break;
+
+        case RX_FRAME_ST_LENGTH:
+            // Invalid frame, reply it and look for next one
+            if((channel->frame_type >= RX_FRAME_TYPES_NUM) || (byte > RX_LINE_SIZE-1))
+            {
+                channel->reply = RX_FRAME_NAK;
+                channel->reply_seq = RX_FRAME_REPLY_SEQ(channel->frame_seq);
+                channel->frame_state = RX_FRAME_ST_HUNT;
+                break;
+            }
+            channel->frame_length = byte;
+            if(byte == 0)
+                channel->frame_state = RX_FRAME_ST_CRC_HIGH;
+            else
+                channel->frame_state = RX_FRAME_ST_PAYLOAD;
+            break;
+
+        case RX_FRAME_ST_PAYLOAD:
+            channel->line[channel->line_length] = (char)byte;
+            channel->line_length = channel->line_length + 1;
+            if(channel->line_length >= channel->frame_length)
+                channel->frame_state = RX_FRAME_ST_CRC_HIGH;
+            break;
+
+        case RX_FRAME_ST_CRC_HIGH:
+            channel->frame_crc_rx = ((uint16_t)byte) << 8;
+            channel->frame_state = RX_FRAME_ST_CRC_LOW;
+            break;
+
+        case RX_FRAME_ST_CRC_LOW:
+            channel->frame_crc_rx = channel->frame_crc_rx | byte;
+            channel->frame_state = RX_FRAME_ST_NONE;
+            return frame_complete(channel);
+
+        default:
+            channel->frame_state = RX_FRAME_ST_HUNT;
+            break;
+    }
+
+    // Frame discarded
+    if(channel->frame_state == RX_FRAME_ST_HUNT)
+        channel->line_length = 0;
+
+    return false;
+}
+
+// Process a completed frame, return true when its payload is a line to be executed
+// Data frames are accepted in sequence order (go-back-N): a frame with the next sequence is
+// executed, a resent frame (up to last accepted one) is just acknowledged, and a frame ahead of
+// the next sequence follows a lost one, so it is rejected until the host goes back to the lost one
+static bool frame_complete(t_rx_channel* channel)
+{
+    bool first = (channel->frame_last_seq < 0);
+    bool repeated = (channel->frame_last_seq == channel->frame_seq);
+    uint8_t ahead = channel->frame_seq - (uint8_t)channel->frame_last_seq;
+
+    channel->reply_seq = RX_FRAME_REPLY_SEQ(channel->frame_seq);
+
+    // Corrupted frame, its length may be wrong so next bytes can still be part of it
+    if(channel->frame_crc != channel->frame_crc_rx)
+    {
+        channel->reply = RX_FRAME_NAK;
+        channel->frame_state = RX_FRAME_ST_HUNT;
+        channel->line_length = 0;
+        return false;
+    }
+    channel->frame_received = true;
+
+    // Bauds request is replied by the link owner once it is checked
+    if(channel->frame_type == RX_FRAME_BAUDS)
+    {
+        channel->frame_last_seq = channel->frame_seq;
+        if(!repeated && (channel->line_length == sizeof(uint32_t)))
+        {
+            channel->bauds_request = 0;
+            for(uint8_t i = sizeof(uint32_t); i > 0; i--)
+            {
+                channel->bauds_request = (channel->bauds_request << 8) |
+                    (uint8_t)channel->line[i-1];
+            }
+        }
+        else
+            channel->reply = RX_FRAME_NAK;
+        channel->line_length = 0;
+        return false;
+    }
+
+    // Data frame that follows a lost one
+    if(!first && (ahead > 1) && (ahead <= RX_FRAME_SEQ_AHEAD))
+    {
+        channel->reply = RX_FRAME_NAK;
+        channel->line_length = 0;
+        return false;
+    }
+
+    // Resent and empty data frames are just acknowledged
+    channel->reply = RX_FRAME_ACK;
+    if(first || (ahead == 1))
+        channel->frame_last_seq = channel->frame_seq;
+    if((!first && (ahead != 1)) || (channel->line_length == 0))
+    {
+        channel->line_length = 0;
+        return false;
+    }
+
+    channel->line_binary = ducky_bytecode_is_opcode((uint8_t)channel->line[0]);
+    return true;
+}
+
+// Check if a channel text line is a STRING line to be streamed once it fills the line buffer
+static bool stream_line(const t_rx_channel* channel)
+{
+    #if RX_STREAM_STRING
+        if(channel->line_stream != RX_STREAM_NONE)
+            return true;
+        if(channel->line_lz || (channel->frame_state != RX_FRAME_ST_NONE))
+            return false;
+        return ((channel->line_length >= RX_STREAM_PREFIX_LEN) &&
+            (memcmp(channel->line, RX_STREAM_PREFIX, RX_STREAM_PREFIX_LEN) == 0));
+    #else
+        return false;
+    #endif
+}
+
+// Release a channel assembled line, so a new one can be assembled
+void rx_line_release(t_rx_channel* channel)
+{
+    channel->line_length = 0;
+    channel->line_ready = false;
+    channel->line_binary = false;
+    channel->line_lz = false;
+    if(channel->line_stream == RX_STREAM_END)
+        channel->line_stream = RX_STREAM_NONE;
+}
+
+/**************************************************************************************************/
+
+/* Flow Control Functions */
+
+// Get the flow control character to send to a channel sender (0 if none has to be sent)
+// Sender is paused when ring free space drops below RX_FLOW_XOFF_FREE (ring stops being drained
+// while the commands queue is full) and resumed when free space gets back to RX_FLOW_XON_FREE
+uint8_t rx_flow_control(t_rx_channel* channel)
+{
+    uint8_t free_bytes = rx_ring_free(&(channel->ring));
+
+    if(!channel->paused && (free_bytes < RX_FLOW_XOFF_FREE))
+    {
+        channel->paused = true;
+        return RX_XOFF;
+    }
+    if(channel->paused && (free_bytes >= RX_FLOW_XON_FREE))
+    {
+        channel->paused = false;
+        return RX_XON;
+    }
+
+    return 0;
+}
+
+/**************************************************************************************************/
+
+/* Frames Functions */
+
+// Get the frame reply to send to a channel sender (0 if none has to be sent) and its sequence
+uint8_t rx_frame_reply(t_rx_channel* channel, uint8_t* seq)
+{
+    uint8_t reply = channel->reply;
+
+    channel->reply = 0;
+    *seq = channel->reply_seq;
+
+    return reply;
+}
+
+// Update a CRC-16/CCITT-FALSE (polynomial 0x1021) with a new byte
+uint16_t rx_crc16_update(uint16_t crc, const uint8_t byte)
+{
+    crc = crc ^ (((uint16_t)byte) << 8);
+    for(uint8_t i = 0; i < 8; i++)
+    {
+        if(crc & 0x8000)
+            crc = (crc << 1) ^ 0x1021;
+        else
+            crc = crc << 1;
+    }
+
+    return crc;
+}
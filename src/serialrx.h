@@ -0,0 +1,213 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     serialrx.h                                                                                 */
+/* Description:                                                                                   */
+/*     Per source lock-free reception ring buffers and line assemblers.                           */
+/**************************************************************************************************/
+
+#ifndef SERIALRX_H_
+#define SERIALRX_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "returncodes.h"
+#include "duckyparser.h"
+#include "duckybytecode.h"
+#include "duckylz.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Auxiliar Serial transports built besides USB Serial (one or both of them)
+// SoftwareSerial on pins 8 (RX) and 9 (TX), and hardware USART Serial1 on pins 0 (RX) and 1 (TX)
+#ifndef RX_TRANSPORT_SWSERIAL
+    #define RX_TRANSPORT_SWSERIAL 1
+#endif
+#ifndef RX_TRANSPORT_UART
+    #define RX_TRANSPORT_UART 0
+#endif
+
+// Reception ring buffer size of each source (must be a power of 2, maximum 128)
+#define RX_RING_SIZE 64
+
+// Maximum length for each received line (including null terminator)
+#define RX_LINE_SIZE SERIAL_RX_BUFFER_SIZE
+
+// Software flow control (XON/XOFF) of each source sender (enabled by default)
+#ifndef RX_FLOW_CONTROL
+    #define RX_FLOW_CONTROL 1
+#endif
+
+// Streamed STRING lines (enabled by default)
+// Text lines starting with RX_STREAM_PREFIX that don't fit in the line buffer are assembled as
+// parts of their text (without the keyword) each time the buffer gets full, so their length is
+// not limited by the line buffer and they are typed before the end of line is received
+#ifndef RX_STREAM_STRING
+    #define RX_STREAM_STRING 1
+#endif
+#define RX_STREAM_PREFIX "STRING "
+#define RX_STREAM_PREFIX_LEN 7
+
+// Flow control characters
+#define RX_XON 0x11
+#define RX_XOFF 0x13
+
+// Ring buffer free bytes to pause (XOFF) and resume (XON) the sender
+// Bytes in flight after a XOFF are kept by the free ring space and the Serial port buffer. Flow
+// control also applies to framed lines, frame replies never hold XON/XOFF (see reply sequence)
+#define RX_FLOW_XOFF_FREE 24
+#define RX_FLOW_XON_FREE 48
+
+// Framed lines: [SYNC][type][sequence][length][payload][CRC-16 high][CRC-16 low]
+// CRC-16/CCITT-FALSE is calculated from type to last payload byte. Each valid frame is replied
+// with [ACK][reply sequence] and each corrupted one with [NAK][reply sequence]. Data frames are
+// executed in sequence order: a resent frame is acknowledged but not executed again, and a frame
+// that follows a lost one is rejected with a NAK. An end of line out of a frame ends the sequence
+// (next frame is accepted with any sequence). A frame can start wherever a line can, and a SYNC in
+// the middle of a text line discards it. After a corrupted frame, received bytes are discarded
+// until next SYNC (the frame length can't be trusted)
+#define RX_FRAME_SYNC 0x02
+#define RX_FRAME_ACK 0x06
+#define RX_FRAME_NAK 0x15
+#define RX_FRAME_CRC_INIT 0xFFFF
+
+// Reply sequence: the 7 low bits of the frame sequence with the high bit set, so a reply never
+// holds a flow control character and the sender can keep XON/XOFF enabled while using frames (it
+// matches replies by those 7 bits, so it can't have more than 127 frames waiting for their reply)
+#define RX_FRAME_REPLY_MARK 0x80
+#define RX_FRAME_REPLY_SEQ(seq) ((uint8_t)((seq) | RX_FRAME_REPLY_MARK))
+
+// Data frames sequences ahead of the next expected one that are rejected (half of the sequence
+// numbers, the ones behind it are resent frames)
+#define RX_FRAME_SEQ_AHEAD 128
+
+// Framed lines only (disabled by default)
+// Any received byte out of a frame is discarded, so a corrupted SYNC byte can't turn a frame
+// into a text line
+#ifndef RX_FRAMED_ONLY
+    #define RX_FRAMED_ONLY 0
+#endif
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Frame types
+enum _rx_frame_types
+{
+    RX_FRAME_DATA = 0,  // Payload is a text or bytecode line (an empty one is just acknowledged)
+    RX_FRAME_BAUDS,     // Payload is a new link bauds rate request (uint32_t little endian)
+    RX_FRAME_TYPES_NUM
+};
+
+// Frame reception states
+enum _rx_frame_states
+{
+    RX_FRAME_ST_NONE = 0,
+    RX_FRAME_ST_HUNT,           // Discarding bytes until next SYNC after a corrupted frame
+    RX_FRAME_ST_TYPE,
+    RX_FRAME_ST_SEQ,
+    RX_FRAME_ST_LENGTH,
+    RX_FRAME_ST_PAYLOAD,
+    RX_FRAME_ST_CRC_HIGH,
+    RX_FRAME_ST_CRC_LOW
+};
+
+// Streamed line states
+enum _rx_stream_states
+{
+    RX_STREAM_NONE = 0,  // Line is not streamed
+    RX_STREAM_PART,      // Line is a part of a streamed line text, more parts follow
+    RX_STREAM_END        // Line is the last part of a streamed line text
+};
+
+// Reception sources
+enum _rx_sources
+{
+    RX_SRC_SERIAL = 0,
+    #if RX_TRANSPORT_SWSERIAL
+        RX_SRC_SWSERIAL,
+    #endif
+    #if RX_TRANSPORT_UART
+        RX_SRC_UART,
+    #endif
+    RX_SRC_NUM
+};
+
+// Single-Producer Single-Consumer lock-free ring buffer
+// Producer (i.e. an ISR) just writes head, consumer just writes tail. Indexes are free running
+// 8 bits counters, so the number of stored bytes is always (head - tail)
+typedef struct
+{
+    volatile uint8_t data[RX_RING_SIZE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint16_t dropped;
+} t_rx_ring;
+
+// Reception channel (ring buffer plus its own line assembler)
+typedef struct
+{
+    t_rx_ring ring;
+    char line[RX_LINE_SIZE];
+    uint16_t line_length;
+    bool line_ready;
+    bool line_binary;  // Line is a bytecode command (not delimited by end of line characters)
+    bool line_lz;      // Line is a compressed text line
+    bool paused;       // Sender has been paused by flow control
+    uint8_t line_stream;        // Streamed line state (RX_STREAM_NONE if not streamed)
+    t_lz_state lz;              // Compressed lines decoder
+    uint8_t frame_state;        // Frame reception state (RX_FRAME_ST_NONE out of a frame)
+    uint8_t frame_type;
+    uint8_t frame_seq;
+    uint8_t frame_length;
+    uint16_t frame_crc;         // CRC calculated from received frame bytes
+    uint16_t frame_crc_rx;      // CRC received in the frame
+    int16_t frame_last_seq;     // Sequence of last accepted frame (-1 if none)
+    bool frame_received;        // A valid frame has been received (cleared by the user)
+    uint8_t reply;              // Reply to send to sender (RX_FRAME_ACK, RX_FRAME_NAK or 0)
+    uint8_t reply_seq;
+    uint32_t bauds_request;     // Requested link bauds rate (0 if none)
+} t_rx_channel;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Push a received byte into a ring buffer (to be called from the producer side)
+bool rx_ring_push(t_rx_ring* ring, const uint8_t byte);
+
+// Pop a byte from a ring buffer (to be called from the consumer side)
+bool rx_ring_pop(t_rx_ring* ring, uint8_t* byte);
+
+// Get next byte of a ring buffer without removing it (to be called from the consumer side)
+bool rx_ring_peek(const t_rx_ring* ring, uint8_t* byte);
+
+// Get the number of free bytes of a ring buffer
+uint8_t rx_ring_free(const t_rx_ring* ring);
+
+// Move ring buffer bytes into channel line assembler and detect end of line
+int8_t rx_line_assemble(t_rx_channel* channel, t_span* line);
+
+// Release a channel assembled line, so a new one can be assembled
+void rx_line_release(t_rx_channel* channel);
+
+// Initialize a reception channel
+void rx_channel_init(t_rx_channel* channel);
+
+// Get the flow control character to send to a channel sender (0 if none has to be sent)
+uint8_t rx_flow_control(t_rx_channel* channel);
+
+// Get the frame reply to send to a channel sender (0 if none has to be sent) and its sequence
+uint8_t rx_frame_reply(t_rx_channel* channel, uint8_t* seq);
+
+// Update a CRC-16/CCITT-FALSE with a new byte
+uint16_t rx_crc16_update(uint16_t crc, const uint8_t byte);
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,192 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     serialtransport.cpp                                                                        */
+/* Description:                                                                                   */
+/*     Serial ports of each reception source (USB Serial, SoftwareSerial and hardware USART      */
+/*     Serial1) behind a common interface.                                                        */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "serialtransport.h"
+
+#if RX_TRANSPORT_SWSERIAL
+    #include <SoftwareSerial.h>
+#endif
+
+#if RX_TRANSPORT_UART
+    #include "uartserial.h"
+#endif
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+#if RX_TRANSPORT_SWSERIAL
+    // Software Serial
+    SoftwareSerial SWSerial(P_SWSERIAL_RX, P_SWSERIAL_TX);
+#endif
+
+/**************************************************************************************************/
+
+/* Transport Functions */
+
+// Start the Serial port of a reception source
+void serial_begin(const uint8_t source, const uint32_t bauds)
+{
+    switch(source)
+    {
+        #if RX_TRANSPORT_SWSERIAL
+            case RX_SRC_SWSERIAL:
+                SWSerial.begin(bauds);
+                return;
+        #endif
+
+        #if RX_TRANSPORT_UART
+            case RX_SRC_UART:
+                uart_begin(bauds);
+                return;
+        #endif
+
+        default:
+            Serial.begin(bauds);
+            return;
+    }
+}
+
+// Stop the Serial port of a reception source
+void serial_end(const uint8_t source)
+{
+    switch(source)
+    {
+        #if RX_TRANSPORT_SWSERIAL
+            case RX_SRC_SWSERIAL:
+                SWSerial.end();
+                return;
+        #endif
+
+        #if RX_TRANSPORT_UART
+            case RX_SRC_UART:
+                uart_end();
+                return;
+        #endif
+
+        default:
+            Serial.end();
+            return;
+    }
+}
+
+// Get the number of received bytes waiting to be read from the Serial port of a source
+int serial_available(const uint8_t source)
+{
+    switch(source)
+    {
+        #if RX_TRANSPORT_SWSERIAL
+            case RX_SRC_SWSERIAL:
+                return SWSerial.available();
+        #endif
+
+        #if RX_TRANSPORT_UART
+            case RX_SRC_UART:
+                return uart_available();
+        #endif
+
+        default:
+            return Serial.available();
+    }
+}
+
+// Read a received byte from the Serial port of a source
+uint8_t serial_read(const uint8_t source)
+{
+    switch(source)
+    {
+        #if RX_TRANSPORT_SWSERIAL
+            case RX_SRC_SWSERIAL:
+                return (uint8_t)SWSerial.read();
+        #endif
+
+        #if RX_TRANSPORT_UART
+            case RX_SRC_UART:
+                return (uint8_t)uart_read();
+        #endif
+
+        default:
+            return (uint8_t)Serial.read();
+    }
+}
+
+// Write a byte to the Serial port of a reception source
+void serial_write(const uint8_t source, const uint8_t byte)
+{
+    switch(source)
+    {
+        #if RX_TRANSPORT_SWSERIAL
+            case RX_SRC_SWSERIAL:
+                SWSerial.write(byte);
+                return;
+        #endif
+
+        #if RX_TRANSPORT_UART
+            case RX_SRC_UART:
+                uart_write(byte);
+                return;
+        #endif
+
+        default:
+            Serial.write(byte);
+            return;
+    }
+}
+
+// Get the number of received bytes of a source lost by its Serial port since last call
+// USB Serial never loses bytes (USB flow control stops the host while its buffer is full), the
+// native one can model a link without it. SoftwareSerial just flags an overflow, it is counted as
+// a single lost byte
+uint16_t serial_overflow(const uint8_t source)
+{
+    switch(source)
+    {
+        #if RX_TRANSPORT_SWSERIAL
+            case RX_SRC_SWSERIAL:
+                return SWSerial.overflow() ? 1 : 0;
+        #endif
+
+        #if RX_TRANSPORT_UART
+            case RX_SRC_UART:
+                return uart_overflow();
+        #endif
+
+        default:
+            #if defined(__AVR__)
+                return 0;
+            #else
+                return Serial.overflow();
+            #endif
+    }
+}
+
+// Get the maximum bauds of a source Serial port (0 if its bauds can't be changed)
+uint32_t serial_bauds_max(const uint8_t source)
+{
+    switch(source)
+    {
+        #if RX_TRANSPORT_SWSERIAL
+            case RX_SRC_SWSERIAL:
+                return SWSERIAL_BAUDS_MAX;
+        #endif
+
+        #if RX_TRANSPORT_UART
+            case RX_SRC_UART:
+                return UART_BAUDS_MAX;
+        #endif
+
+        default:
+            #if defined(__AVR__)
+                return 0;
+            #else
+                return Serial.bauds_max();
+            #endif
+    }
+}
@@ -0,0 +1,60 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     serialtransport.h                                                                          */
+/* Description:                                                                                   */
+/*     Serial ports of each reception source (USB Serial, SoftwareSerial and hardware USART      */
+/*     Serial1) behind a common interface.                                                        */
+/**************************************************************************************************/
+
+#ifndef SERIALTRANSPORT_H_
+#define SERIALTRANSPORT_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "serialrx.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Software Serial GPIO Tx and Rx Pins
+#define P_SWSERIAL_RX 8
+#define P_SWSERIAL_TX 9
+
+// Maximum bauds of each transport
+// SoftwareSerial keeps interrupts disabled while each byte is received, so it is limited to
+// keep keystrokes timing, hardware USART is limited by its bauds error with a 16MHz clock
+#define SWSERIAL_BAUDS_MAX 57600
+#define UART_BAUDS_MAX 250000
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Start the Serial port of a reception source
+void serial_begin(const uint8_t source, const uint32_t bauds);
+
+// Stop the Serial port of a reception source
+void serial_end(const uint8_t source);
+
+// Get the number of received bytes waiting to be read from the Serial port of a source
+int serial_available(const uint8_t source);
+
+// Read a received byte from the Serial port of a source
+uint8_t serial_read(const uint8_t source);
+
+// Write a byte to the Serial port of a reception source
+void serial_write(const uint8_t source, const uint8_t byte);
+
+// Get the number of received bytes of a source lost by its Serial port since last call
+uint16_t serial_overflow(const uint8_t source);
+
+// Get the maximum bauds of a source Serial port (0 if its bauds can't be changed)
+uint32_t serial_bauds_max(const uint8_t source);
+
+/**************************************************************************************************/
+
+#endif
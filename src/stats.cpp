@@ -0,0 +1,119 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     stats.cpp                                                                                  */
+/* Description:                                                                                   */
+/*     Runtime statistics: fixed buckets latency histograms and throughput counters.              */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "stats.h"
+
+/**************************************************************************************************/
+
+/* Statistics Functions */
+
+// Clear all statistics
+void stats_reset(t_stats* stats)
+{
+    memset(stats, 0, sizeof(t_stats));
+    stats->since_ms = millis();
+}
+
+// Get the histogram of a command type (STATS_HIST_NUM for device control commands)
+// Device control commands are never executed, so they don't have a histogram
+uint8_t stats_cmd_hist(const uint8_t cmd_id)
+{
+    if(cmd_id < CMD_STORE)
+        return STATS_HIST_CMD + cmd_id;
+    if(ducky_cmd_is_control(cmd_id) || (cmd_id >= CMD_NUM))
+        return STATS_HIST_NUM;
+    return STATS_HIST_CMD + cmd_id - CMD_CONTROL_NUM;
+}
+
+// Add a duration sample to a histogram
+void stats_record(t_stats* stats, const uint8_t hist, const uint32_t duration_us)
+{
+    uint32_t limit = duration_us >> STATS_FIRST_BUCKET_SHIFT;
+    uint8_t bucket = 0;
+
+    if(hist >= STATS_HIST_NUM)
+        return;
+
+    while((limit != 0) && (bucket < STATS_BUCKETS-1))
+    {
+        limit = limit >> STATS_BUCKET_SHIFT;
+        bucket = bucket + 1;
+    }
+
+    if(stats->hist[hist].buckets[bucket] < UINT16_MAX)
+        stats->hist[hist].buckets[bucket] = stats->hist[hist].buckets[bucket] + 1;
+}
+
+// Add an idle sleep
+void stats_sleep(t_stats* stats, const uint32_t duration_us)
+{
+    uint32_t us = stats->asleep_us + duration_us;
+
+    stats->sleeps = stats->sleeps + 1;
+    stats->asleep_ms = stats->asleep_ms + (us / 1000);
+    stats->asleep_us = us % 1000;
+}
+
+// Write statistics report
+void stats_report(const t_stats* stats, Print& out)
+{
+    bool empty = true;
+
+    out.print(F("STATS "));
+    out.print(stats->loops);
+    out.print(' ');
+    out.print(stats->lines);
+    out.print(' ');
+    out.print(stats->bytes);
+    out.print(' ');
+    out.print(stats->dropped);
+    out.print(' ');
+    out.println(stats->rx_max);
+
+    out.print(F("SLEEP "));
+    out.print(stats->sleeps);
+    out.print(' ');
+    out.print(stats->asleep_ms);
+    out.print(' ');
+    out.println(millis() - stats->since_ms);
+
+    for(uint8_t i = 0; i < STATS_HIST_NUM; i++)
+    {
+        empty = true;
+        for(uint8_t j = 0; j < STATS_BUCKETS; j++)
+        {
+            if(stats->hist[i].buckets[j] != 0)
+                empty = false;
+        }
+        if(empty)
+            continue;
+
+        out.print(F("HIST "));
+        if(i == STATS_HIST_RX)
+            out.print(F("rx"));
+        else if(i == STATS_HIST_PARSE)
+            out.print(F("parse"));
+        else if(i == STATS_HIST_WAKE)
+            out.print(F("wake"));
+        else
+        {
+            out.print(F("cmd"));
+            if(i - STATS_HIST_CMD < CMD_STORE)
+                out.print(i - STATS_HIST_CMD);
+            else
+                out.print(i - STATS_HIST_CMD + CMD_CONTROL_NUM);
+        }
+        for(uint8_t j = 0; j < STATS_BUCKETS; j++)
+        {
+            out.print(' ');
+            out.print(stats->hist[i].buckets[j]);
+        }
+        out.println();
+    }
+}
@@ -0,0 +1,102 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     stats.h                                                                                    */
+/* Description:                                                                                   */
+/*     Runtime statistics: fixed buckets latency histograms and throughput counters.              */
+/**************************************************************************************************/
+
+/* Report Format (one record per line, space separated fields):
+ *
+ *     STATS <loops> <lines> <bytes> <dropped> <rx_max>
+ *     SLEEP <sleeps> <asleep_ms> <elapsed_ms>
+ *     HIST <name> <bucket 0> ... <bucket 7>
+ *
+ * STATS reports the main loop iterations, the received lines and bytes, the received bytes lost
+ * (by the Serial ports or the reception rings) and the maximum bytes waiting in a reception ring.
+ * SLEEP reports the number of idle sleeps and the time asleep out of the time elapsed since the
+ * statistics were cleared. Histograms are only reported if they have any sample. Their names are
+ * "rx" (line reception), "parse" (line interpretation), "wake" (from the wake up of the last
+ * received byte of a command to the start of its execution, if the executor was waiting for it)
+ * and "cmd<ID>" (execution of each command type, HID output included). Bucket 0 counts durations
+ * under 64 us and each next one durations under 4 times its previous one limit (256 us, 1 ms,
+ * 4 ms, 16 ms, 65 ms, 262 ms), last one counts the longer ones.
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "duckyparser.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Number of buckets of each histogram
+#define STATS_BUCKETS 8
+
+// Upper limit of first bucket (us, as a power of 2 shift) and growing factor of next ones (shift)
+#define STATS_FIRST_BUCKET_SHIFT 6
+#define STATS_BUCKET_SHIFT 2
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Histograms
+enum _stats_histograms
+{
+    STATS_HIST_RX = 0,
+    STATS_HIST_PARSE,
+    STATS_HIST_WAKE,
+    STATS_HIST_CMD,                          // First command type histogram
+    STATS_HIST_NUM = STATS_HIST_CMD + CMD_NUM - CMD_CONTROL_NUM  // Just executed commands
+};
+
+// Fixed buckets histogram (counters saturate)
+typedef struct
+{
+    uint16_t buckets[STATS_BUCKETS];
+} t_histogram;
+
+// Statistics
+typedef struct
+{
+    t_histogram hist[STATS_HIST_NUM];
+    uint32_t loops;     // Main loop iterations
+    uint32_t lines;     // Received lines
+    uint32_t bytes;     // Received bytes
+    uint32_t dropped;   // Received bytes lost
+    uint8_t rx_max;     // Maximum number of bytes waiting in a reception ring
+    uint32_t sleeps;    // Idle sleeps
+    uint32_t asleep_ms; // Time asleep
+    uint16_t asleep_us; // Time asleep below 1 ms
+    uint32_t since_ms;  // Time when statistics were cleared
+} t_stats;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Clear all statistics
+void stats_reset(t_stats* stats);
+
+// Get the histogram of a command type (STATS_HIST_NUM for device control commands)
+uint8_t stats_cmd_hist(const uint8_t cmd_id);
+
+// Add a duration sample to a histogram
+void stats_record(t_stats* stats, const uint8_t hist, const uint32_t duration_us);
+
+// Add an idle sleep
+void stats_sleep(t_stats* stats, const uint32_t duration_us);
+
+// Write statistics report
+void stats_report(const t_stats* stats, Print& out);
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,154 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     uartserial.cpp                                                                             */
+/* Description:                                                                                   */
+/*     Interrupt driven hardware USART1 (Serial1, pins 0 RX and 1 TX) driver with its own         */
+/*     reception ring buffer, used instead of the Arduino core Serial1 object.                    */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "uartserial.h"
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Single-Producer (reception ISR) Single-Consumer ring buffer with free running 8 bits indexes
+typedef struct
+{
+    volatile uint8_t data[UART_RX_RING_SIZE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint8_t dropped;  // Bytes lost (saturates)
+} t_uart_ring;
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+// Reception ring buffer
+static t_uart_ring uart_ring;
+
+// A byte has been written since the USART was configured (its transmission complete flag is set
+// once it has been sent)
+static bool uart_written = false;
+
+/**************************************************************************************************/
+
+/* AVR USART1 */
+
+#if defined(__AVR__)
+
+// Reception complete interrupt, moves the byte into the ring buffer
+// Core Serial1 object must not be used, it defines this same interrupt handler
+ISR(USART1_RX_vect)
+{
+    uint8_t status = UCSR1A;
+    uint8_t byte = UDR1;
+    uint8_t head = uart_ring.head;
+
+    // Hardware overrun, at least a byte was lost before this one
+    if((status & (1 << DOR1)) && (uart_ring.dropped < 0xFF))
+        uart_ring.dropped = uart_ring.dropped + 1;
+
+    // Discard bytes with framing errors
+    if(status & (1 << FE1))
+        return;
+
+    if((uint8_t)(head - uart_ring.tail) >= UART_RX_RING_SIZE)
+    {
+        if(uart_ring.dropped < 0xFF)
+            uart_ring.dropped = uart_ring.dropped + 1;
+        return;
+    }
+
+    uart_ring.data[head & (UART_RX_RING_SIZE-1)] = byte;
+    uart_ring.head = head + 1;
+}
+
+#endif
+
+/**************************************************************************************************/
+
+/* USART Functions */
+
+// Configure the USART (8N1) and enable its reception interrupt
+// Double speed mode is used, so baud rate error is lower at high bauds (2.1% at 115200 bauds
+// with a 16MHz clock)
+void uart_begin(const uint32_t bauds)
+{
+    uart_ring.head = 0;
+    uart_ring.tail = 0;
+    uart_ring.dropped = 0;
+    uart_written = false;
+
+    #if defined(__AVR__)
+        UBRR1 = (uint16_t)(((F_CPU + (bauds * 4)) / (bauds * 8)) - 1);
+        UCSR1A = (1 << U2X1);
+        UCSR1C = (1 << UCSZ11) | (1 << UCSZ10);
+        UCSR1B = (1 << RXEN1) | (1 << TXEN1) | (1 << RXCIE1);
+    #endif
+}
+
+// Disable the USART (pending received bytes are discarded)
+// The empty data register just means the last byte is being shifted out, the transmission
+// complete flag is set once its stop bit has been sent
+void uart_end(void)
+{
+    #if defined(__AVR__)
+        // Wait for last byte to be transmitted
+        while(uart_written && !(UCSR1A & (1 << TXC1)));
+        UCSR1B = 0;
+    #endif
+
+    uart_ring.tail = uart_ring.head;
+}
+
+// Get the number of received bytes waiting to be read
+uint8_t uart_available(void)
+{
+    return (uint8_t)(uart_ring.head - uart_ring.tail);
+}
+
+// Read a received byte (-1 if none)
+int16_t uart_read(void)
+{
+    uint8_t tail = uart_ring.tail;
+    uint8_t byte = 0;
+
+    if(tail == uart_ring.head)
+        return -1;
+
+    byte = uart_ring.data[tail & (UART_RX_RING_SIZE-1)];
+    uart_ring.tail = tail + 1;
+
+    return byte;
+}
+
+// Write a byte (waits until the transmitter has room for it)
+// Just short replies (flow control and frame acknowledges) are sent, so no transmission buffer.
+// The transmission complete flag is cleared (writing a one to it) before each byte, so it is set
+// just once the last written one has been sent
+void uart_write(const uint8_t byte)
+{
+    #if defined(__AVR__)
+        while(!(UCSR1A & (1 << UDRE1)));
+        UCSR1A = (UCSR1A & (1 << U2X1)) | (1 << TXC1);
+        UDR1 = byte;
+    #endif
+    uart_written = true;
+}
+
+// Get the number of received bytes lost since last call (ring buffer full or hardware overrun)
+uint16_t uart_overflow(void)
+{
+    uint8_t dropped = 0;
+
+    noInterrupts();
+    dropped = uart_ring.dropped;
+    uart_ring.dropped = 0;
+    interrupts();
+
+    return dropped;
+}
@@ -0,0 +1,52 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     uartserial.h                                                                               */
+/* Description:                                                                                   */
+/*     Interrupt driven hardware USART1 (Serial1, pins 0 RX and 1 TX) driver with its own         */
+/*     reception ring buffer, used instead of the Arduino core Serial1 object.                    */
+/**************************************************************************************************/
+
+#ifndef UARTSERIAL_H_
+#define UARTSERIAL_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Reception ring buffer size (must be a power of 2, maximum 128)
+// 128 bytes keep 11ms of data at 115200 bauds while the main loop is busy
+#ifndef UART_RX_RING_SIZE
+    #define UART_RX_RING_SIZE 128
+#endif
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Configure the USART (8N1) and enable its reception interrupt
+void uart_begin(const uint32_t bauds);
+
+// Disable the USART (pending received bytes are discarded)
+void uart_end(void);
+
+// Get the number of received bytes waiting to be read
+uint8_t uart_available(void);
+
+// Read a received byte (-1 if none)
+int16_t uart_read(void);
+
+// Write a byte (waits until the transmitter has room for it)
+void uart_write(const uint8_t byte);
+
+// Get the number of received bytes lost since last call (ring buffer full or hardware overrun)
+uint16_t uart_overflow(void);
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,176 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_bench                                                                                 */
+/* Description:                                                                                   */
+/*     Interpreter benchmark suite (native). Each representative script is run by the firmware    */
+/*     with the virtual clock, so the host time it takes is only spent receiving, interpreting    */
+/*     and executing commands. Reports lines/sec, ns/command and HID reports/command; it is the   */
+/*     baseline to compare every performance change with.                                         */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include "NativeRun.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Times each script is repeated in a run (so the run is long enough to be measured)
+#define BENCH_REPEATS 200
+
+// Benchmark runs header, no delay between commands
+#define BENCH_HEADER "DEFAULT_DELAY 0\n"
+
+// Maximum benchmark input size
+#define BENCH_INPUT_SIZE 65536
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+typedef struct
+{
+    const char* name;
+    const char* script;
+} t_bench_script;
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Representative scripts (without delays, that would only measure virtual clock idle loops)
+static const t_bench_script BENCH_SCRIPTS[] =
+{
+    {
+        "typing",
+        "STRING The quick brown fox jumps over the lazy dog\n"
+        "ENTER\n"
+        "STRING Hello, World! 0123456789 (x + y) * z = {a; b}\n"
+        "ENTER\n"
+    },
+    {
+        "shortcuts",
+        "CTRL c\n"
+        "CTRL-ALT DELETE\n"
+        "ALT F4\n"
+        "GUI r\n"
+        "CTRL-SHIFT ESC\n"
+        "SHIFT TAB\n"
+        "ALT-TAB\n"
+        "a\n"
+    },
+    {
+        "keys",
+        "ENTER\n"
+        "TAB\n"
+        "ESCAPE\n"
+        "DOWNARROW\n"
+        "UP\n"
+        "F12\n"
+        "DELETE\n"
+        "SPACE\n"
+    },
+    {
+        "payload",
+        "REM Open a terminal and run a command\n"
+        "GUI r\n"
+        "STRING cmd\n"
+        "ENTER\n"
+        "STRING echo benchmark > out.txt\n"
+        "ENTER\n"
+        "REPEAT 2\n"
+        "STRING exit\n"
+        "ENTER\n"
+    }
+};
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Count the lines of a script
+static uint32_t script_lines(const char* script)
+{
+    uint32_t lines = 0;
+
+    for(const char* c = script; *c != '\0'; c++)
+    {
+        if(*c == '\n')
+            lines = lines + 1;
+    }
+    return lines;
+}
+
+// Run a script repeated BENCH_REPEATS times and print its benchmark results
+static void bench_script(const t_bench_script* bench)
+{
+    static uint8_t input[BENCH_INPUT_SIZE];
+    size_t header_len = strlen(BENCH_HEADER);
+    size_t script_len = strlen(bench->script);
+    uint32_t lines = script_lines(bench->script) * BENCH_REPEATS;
+    t_native_run_options options;
+    t_native_run run;
+
+    TEST_ASSERT_TRUE(header_len + (script_len * BENCH_REPEATS) <= sizeof(input));
+    memcpy(input, BENCH_HEADER, header_len);
+    for(uint16_t i = 0; i < BENCH_REPEATS; i++)
+        memcpy(&(input[header_len + (i * script_len)]), bench->script, script_len);
+
+    memset(&options, 0, sizeof(options));
+    options.input = input;
+    options.input_len = header_len + (script_len * BENCH_REPEATS);
+    TEST_ASSERT_EQUAL_INT(0, native_run(&options, &run));
+
+    printf("%-12s %8u lines %12.0f lines/sec %10.0f ns/cmd %8.2f reports/cmd\n", bench->name,
+        lines, (lines * 1e9) / run.host_ns, (double)run.host_ns / lines,
+        (double)run.reports_n / lines);
+
+    // Every command is valid and sends reports
+    TEST_ASSERT_NULL(strstr((const char*)run.output, "Invalid"));
+    TEST_ASSERT_GREATER_THAN(lines, run.reports_n);
+    native_run_free(&run);
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_bench_typing(void)
+{
+    bench_script(&(BENCH_SCRIPTS[0]));
+}
+
+void test_bench_shortcuts(void)
+{
+    bench_script(&(BENCH_SCRIPTS[1]));
+}
+
+void test_bench_keys(void)
+{
+    bench_script(&(BENCH_SCRIPTS[2]));
+}
+
+void test_bench_payload(void)
+{
+    bench_script(&(BENCH_SCRIPTS[3]));
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_typing);
+    RUN_TEST(test_bench_shortcuts);
+    RUN_TEST(test_bench_keys);
+    RUN_TEST(test_bench_payload);
+    return UNITY_END();
+}
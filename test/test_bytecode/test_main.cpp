@@ -0,0 +1,330 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_bytecode                                                                              */
+/* Description:                                                                                   */
+/*     Bytecode format tests (native): encode and decode round trip of the HID traces scripts     */
+/*     corpus (test/traces/scripts) commands, stable opcodes of every command type, and a         */
+/*     benchmark of the device CPU time per command of the bytecode decoder against the text      */
+/*     parser and compiler, with the bytes each format takes on the link.                         */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include <time.h>
+#include <string.h>
+#include "duckyparser.h"
+#include "duckybytecode.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Benchmark corpus directory (relative to this source file directory by default)
+#ifndef BENCH_CORPUS_DIR
+    #define BENCH_CORPUS_DIR "../traces/scripts"
+#endif
+
+// Maximum corpus file path length
+#define BENCH_PATH_SIZE 512
+
+// Maximum corpus size
+#define BENCH_CORPUS_SIZE 8192
+
+// Maximum number of corpus commands
+#define BENCH_MAX_COMMANDS 256
+
+// Times the corpus commands are processed in the benchmark
+#define BENCH_PASSES 2000
+
+// Maximum encoded size of a stable opcodes case
+#define OPCODE_CASE_MAX_SIZE 8
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Corpus command, as a text line and as bytecode
+typedef struct
+{
+    const char* line;
+    uint16_t line_len;
+    uint8_t code[DUCKY_BYTECODE_MAX_SIZE];
+    uint16_t code_len;
+    uint8_t cmd;
+} t_bench_command;
+
+// Bytecode of a text line that must not change between builds
+typedef struct
+{
+    const char* line;
+    uint8_t code[OPCODE_CASE_MAX_SIZE];
+    uint8_t code_len;
+} t_opcode_case;
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Benchmark corpus scripts
+static const char* BENCH_CORPUS[] =
+{
+    "commands.txt", "keys.txt", "layouts.txt", "macros.txt", "store.txt"
+};
+
+// Bytecode of each command type (host compiled streams, stored scripts and macros use them)
+static const t_opcode_case OPCODE_CASES[] =
+{
+    { "ENTER", { 0x80, 0x28 }, 2 },
+    { "REPEAT 3", { 0x82, 0x03 }, 2 },
+    { "DEFAULT_DELAY 0", { 0x83, 0x00 }, 2 },
+    { "DELAY 500", { 0x84, 0xF4, 0x03 }, 3 },
+    { "STRING hi", { 0x85, 0x02, 0x68, 0x69 }, 4 },
+    { "STRING_DELAY 5 hi", { 0x86, 0x05, 0x02, 0x68, 0x69 }, 5 },
+    { "CTRL-ALT DELETE", { 0x87, 0x4C }, 2 },
+    { "CTRL-SHIFT ESC", { 0x88, 0x29 }, 2 },
+    { "ALT-SHIFT", { 0x89, 0x00 }, 2 },
+    { "ALT-TAB", { 0x8A }, 1 },
+    { "COMMAND-OPTION ESC", { 0x8B, 0x29 }, 2 },
+    { "GUI r", { 0x8C, 0x15 }, 2 },
+    { "CTRL c", { 0x8D, 0x06 }, 2 },
+    { "ALT F4", { 0x8E, 0x3D }, 2 },
+    { "SHIFT TAB", { 0x8F, 0x2B }, 2 },
+    { "STORE", { 0x90 }, 1 },
+    { "STORE_BOOT", { 0x91 }, 1 },
+    { "END", { 0x92 }, 1 },
+    { "RUN", { 0x93 }, 1 },
+    { "MEMSTATS", { 0x94 }, 1 },
+    { "STATS", { 0x95 }, 1 },
+    { "RESETSTATS", { 0x96 }, 1 },
+    { "DEFINE ab", { 0x97, 0x02, 0x61, 0x62 }, 4 },
+    { "LOOP 3", { 0x98, 0x03 }, 2 },
+    { "CALL ab", { 0x99, 0x02, 0x61, 0x62 }, 4 },
+    { "LAYOUT DE", { 0x9A, 0x02, 0x44, 0x45 }, 4 },
+    { "GUI-SHIFT s", { 0x9B, 0x0A, 0x16 }, 3 },
+    { "ADAPTIVE_DELAY 20", { 0x9C, 0x14 }, 2 }
+};
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+// Corpus and its commands
+static char corpus[BENCH_CORPUS_SIZE];
+static size_t corpus_len = 0;
+static t_bench_command commands[BENCH_MAX_COMMANDS];
+static uint16_t commands_n = 0;
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+// Get the path of a benchmark corpus script
+// A relative corpus directory is taken from the directory of this source file, so the benchmark
+// doesn't depend on where tests are run from
+static void corpus_path(const char* name, char* path, const size_t size)
+{
+    const char* dir_end = strrchr(__FILE__, '/');
+    int dir_len = (dir_end == NULL) ? 0 : (int)(dir_end - __FILE__);
+
+    if((BENCH_CORPUS_DIR[0] == '/') || (dir_end == NULL))
+        snprintf(path, size, "%s/%s", BENCH_CORPUS_DIR, name);
+    else
+        snprintf(path, size, "%.*s/%s/%s", dir_len, __FILE__, BENCH_CORPUS_DIR, name);
+}
+
+// Load the benchmark corpus scripts one after the other, returns its size
+// The test fails if a script is missing, so a benchmark is never silently skipped
+static size_t corpus_load(char* text, const size_t size)
+{
+    char path[BENCH_PATH_SIZE];
+    FILE* file = NULL;
+    size_t len = 0;
+
+    for(size_t i = 0; i < sizeof(BENCH_CORPUS)/sizeof(BENCH_CORPUS[0]); i++)
+    {
+        corpus_path(BENCH_CORPUS[i], path, sizeof(path));
+        file = fopen(path, "rb");
+        if(file == NULL)
+        {
+            printf("Benchmark corpus %s not found\n", path);
+            TEST_FAIL_MESSAGE("Benchmark corpus not found");
+        }
+        len = len + fread(&(text[len]), 1, size - len, file);
+        fclose(file);
+    }
+    TEST_ASSERT_LESS_THAN(size, len);
+
+    return len;
+}
+
+// Tokenize and compile a line
+static int8_t compile(const char* line, const uint16_t len, t_ducky_cmd* cmd)
+{
+    t_ducky_line parsed;
+
+    memset(cmd, 0, sizeof(t_ducky_cmd));
+    if(ducky_parse_line(line, len, &parsed) != RC_OK)
+        return RC_BAD;
+    return ducky_compile(&parsed, cmd);
+}
+
+// Check two compiled commands are the same (fields not used by the command type are ignored)
+static void assert_same_cmd(const t_ducky_cmd* expected, const t_ducky_cmd* cmd)
+{
+    TEST_ASSERT_EQUAL_UINT8(expected->cmd, cmd->cmd);
+    TEST_ASSERT_EQUAL_HEX8(expected->modifiers, cmd->modifiers);
+    TEST_ASSERT_EQUAL_HEX8(expected->key, cmd->key);
+    TEST_ASSERT_EQUAL_UINT32(expected->num, cmd->num);
+    TEST_ASSERT_EQUAL_UINT8(expected->text_len, cmd->text_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected->text, cmd->text, cmd->text_len);
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Each valid corpus command is decoded from its bytecode as it was compiled from its text line
+void test_bytecode_round_trip(void)
+{
+    t_bench_command* command = NULL;
+    t_ducky_cmd compiled;
+    t_ducky_cmd decoded;
+    size_t start = 0;
+    size_t len = 0;
+
+    corpus_len = corpus_load(corpus, sizeof(corpus));
+    for(size_t i = 0; (i < corpus_len) && (commands_n < BENCH_MAX_COMMANDS); i = start + len + 1)
+    {
+        start = i;
+        len = 0;
+        while((start + len < corpus_len) && (corpus[start + len] != '\n'))
+            len = len + 1;
+        if((compile(&(corpus[start]), len, &compiled) != RC_OK) || (compiled.cmd == CMD_REM))
+            continue;
+
+        command = &(commands[commands_n]);
+        command->line = &(corpus[start]);
+        command->line_len = len;
+        command->cmd = compiled.cmd;
+        command->code_len = ducky_bytecode_encode(&compiled, command->code,
+            sizeof(command->code));
+        TEST_ASSERT_GREATER_THAN(0, command->code_len);
+        TEST_ASSERT_TRUE(ducky_bytecode_is_opcode(command->code[0]));
+        TEST_ASSERT_EQUAL_INT16(command->code_len,
+            ducky_bytecode_size(command->code, command->code_len));
+
+        memset(&decoded, 0, sizeof(decoded));
+        TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_bytecode_decode(command->code, command->code_len,
+            &decoded));
+        assert_same_cmd(&compiled, &decoded);
+        commands_n = commands_n + 1;
+    }
+    TEST_ASSERT_GREATER_THAN(0, commands_n);
+}
+
+// Opcodes and operands of every command type don't change, so streams compiled and scripts
+// stored by another build are still valid
+void test_bytecode_opcodes(void)
+{
+    const t_opcode_case* test = NULL;
+    uint8_t code[DUCKY_BYTECODE_MAX_SIZE];
+    uint16_t code_len = 0;
+    t_ducky_cmd cmd;
+
+    for(size_t i = 0; i < sizeof(OPCODE_CASES)/sizeof(OPCODE_CASES[0]); i++)
+    {
+        test = &(OPCODE_CASES[i]);
+        TEST_ASSERT_EQUAL_INT8_MESSAGE(RC_OK, compile(test->line, strlen(test->line), &cmd),
+            test->line);
+        code_len = ducky_bytecode_encode(&cmd, code, sizeof(code));
+        TEST_ASSERT_EQUAL_UINT16_MESSAGE(test->code_len, code_len, test->line);
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(test->code, code, code_len, test->line);
+    }
+}
+
+// Device CPU time per command of the bytecode decoder and of the text parser and compiler, and
+// link bytes per command of each format
+void test_bytecode_benchmark(void)
+{
+    const t_bench_command* command = NULL;
+    volatile uint8_t sink = 0;
+    t_ducky_line parsed;
+    t_ducky_cmd cmd;
+    uint64_t start = 0;
+    uint32_t text_bytes = 0;
+    uint32_t code_bytes = 0;
+    double text_ns = 0;
+    double code_ns = 0;
+
+    TEST_ASSERT_GREATER_THAN(0, commands_n);
+
+    // Text lines parsed and compiled, and bytecode commands decoded
+    start = monotonic_ns();
+    for(uint32_t n = 0; n < BENCH_PASSES; n++)
+    {
+        for(uint16_t c = 0; c < commands_n; c++)
+        {
+            command = &(commands[c]);
+            if(ducky_parse_line(command->line, command->line_len, &parsed) == RC_OK)
+                ducky_compile(&parsed, &cmd);
+            sink = cmd.cmd;
+        }
+    }
+    text_ns = (double)(monotonic_ns() - start) / ((double)BENCH_PASSES * commands_n);
+
+    start = monotonic_ns();
+    for(uint32_t n = 0; n < BENCH_PASSES; n++)
+    {
+        for(uint16_t c = 0; c < commands_n; c++)
+        {
+            command = &(commands[c]);
+            if(ducky_bytecode_size(command->code, command->code_len) > 0)
+                ducky_bytecode_decode(command->code, command->code_len, &cmd);
+            sink = cmd.cmd;
+        }
+    }
+    code_ns = (double)(monotonic_ns() - start) / ((double)BENCH_PASSES * commands_n);
+    (void)sink;
+
+    for(uint16_t c = 0; c < commands_n; c++)
+    {
+        text_bytes = text_bytes + commands[c].line_len + 1;
+        code_bytes = code_bytes + commands[c].code_len;
+    }
+
+    printf("%s: %u commands\n", BENCH_CORPUS_DIR, commands_n);
+    printf("%-22s %12s %14s\n", "", "ns/command", "bytes/command");
+    printf("%-22s %12.1f %14.2f\n", "text parse+compile", text_ns,
+        (double)text_bytes / commands_n);
+    printf("%-22s %12.1f %14.2f\n", "bytecode decode", code_ns,
+        (double)code_bytes / commands_n);
+    printf("bytecode: %.1fx faster, %.1f%% of the text link bytes\n", text_ns / code_ns,
+        100.0 * code_bytes / text_bytes);
+
+    TEST_ASSERT_LESS_THAN(text_bytes, code_bytes);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bytecode_round_trip);
+    RUN_TEST(test_bytecode_opcodes);
+    RUN_TEST(test_bytecode_benchmark);
+    return UNITY_END();
+}
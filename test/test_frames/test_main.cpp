@@ -0,0 +1,519 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_frames                                                                                */
+/* Description:                                                                                   */
+/*     Framed lines tests (native): CRC-16, sequence order, ACK/NAK replies and resynchronization */
+/*     of the line assembler, link bauds negotiation through the firmware, and a loopback of      */
+/*     framed scripts through the firmware that measures the goodput at each supported link rate. */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include "NativeRun.h"
+#include "serialrx.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Maximum frame size (header, payload and CRC)
+#define FRAME_MAX_SIZE (4 + RX_LINE_SIZE + 2)
+
+// Maximum number of lines and replies recorded from the line assembler
+#define MAX_RECORDS 16
+
+// Frames of a loopback run
+#define LOOPBACK_FRAMES 300
+
+// Loopback frames line (a STRING line with all different characters, a single report)
+#define LOOPBACK_LINE "STRING abcdef"
+
+// Serial link bauds of the firmware (SERIAL_BAUDS), maximum bauds it can negotiate in the bauds
+// negotiation tests, and bauds it is asked to switch to
+#define LINK_BAUDS_NOMINAL 19200
+#define LINK_BAUDS_MAX 115200
+#define LINK_BAUDS_SWITCH 57600
+
+// Time to confirm negotiated bauds with a valid frame before they are restored (ms)
+#define LINK_BAUDS_CONFIRM_MS 2000
+
+// Data frames sent after a bauds switch (the first one sets no default delay, next ones type a key)
+#define SWITCH_FRAMES 40
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+static t_rx_channel channel;
+
+// Lines and frame replies got from the line assembler
+static char lines[MAX_RECORDS][RX_LINE_SIZE];
+static uint8_t lines_n = 0;
+static uint8_t replies[MAX_RECORDS];
+static uint8_t replies_seq[MAX_RECORDS];
+static uint8_t replies_n = 0;
+
+// Supported link rates (negotiated on SWSerial and UART transports)
+static const uint32_t LINK_BAUDS[] = { 9600, 19200, 38400, 57600, 115200, 250000 };
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Build a frame, returns its size
+static size_t frame_build(uint8_t* frame, const uint8_t type, const uint8_t seq,
+    const char* payload, const size_t len)
+{
+    uint16_t crc = RX_FRAME_CRC_INIT;
+
+    frame[0] = RX_FRAME_SYNC;
+    frame[1] = type;
+    frame[2] = seq;
+    frame[3] = (uint8_t)len;
+    memcpy(&(frame[4]), payload, len);
+    for(size_t i = 1; i < 4 + len; i++)
+        crc = rx_crc16_update(crc, frame[i]);
+    frame[4 + len] = (uint8_t)(crc >> 8);
+    frame[5 + len] = (uint8_t)(crc & 0xFF);
+
+    return 6 + len;
+}
+
+// Receive bytes as the firmware does: each byte is pushed into the ring, then lines are assembled
+// (and recorded) and frame replies are taken
+static void receive(const uint8_t* bytes, const size_t len)
+{
+    t_span line;
+    uint8_t reply = 0;
+    uint8_t seq = 0;
+
+    for(size_t i = 0; i < len; i++)
+    {
+        TEST_ASSERT_TRUE(rx_ring_push(&(channel.ring), bytes[i]));
+        do
+        {
+            reply = rx_frame_reply(&channel, &seq);
+            if(reply && (replies_n < MAX_RECORDS))
+            {
+                replies[replies_n] = reply;
+                replies_seq[replies_n] = seq;
+                replies_n = replies_n + 1;
+            }
+            if(rx_line_assemble(&channel, &line) == RC_OK)
+            {
+                if(lines_n < MAX_RECORDS)
+                {
+                    memcpy(lines[lines_n], line.ptr, line.len);
+                    lines[lines_n][line.len] = '\0';
+                    lines_n = lines_n + 1;
+                }
+                rx_line_release(&channel);
+            }
+        } while(channel.reply != 0);
+    }
+}
+
+// Build a bauds frame, returns its size
+static size_t frame_build_bauds(uint8_t* frame, const uint8_t seq, const uint32_t bauds)
+{
+    char payload[sizeof(uint32_t)];
+
+    for(uint8_t i = 0; i < sizeof(uint32_t); i++)
+        payload[i] = (char)((bauds >> (8 * i)) & 0xFF);
+
+    return frame_build(frame, RX_FRAME_BAUDS, seq, payload, sizeof(payload));
+}
+
+// Run the firmware with a Serial input at the nominal link bauds, that can negotiate them
+static void run_link(const uint8_t* input, const size_t len, t_native_run* run)
+{
+    t_native_run_options options;
+
+    memset(&options, 0, sizeof(options));
+    options.input = input;
+    options.input_len = len;
+    options.bauds = LINK_BAUDS_NOMINAL;
+    options.bauds_max = LINK_BAUDS_MAX;
+    TEST_ASSERT_EQUAL_INT(0, native_run(&options, run));
+}
+
+// Find a frame reply in some output, returns its position or -1 if it isn't there
+static long output_reply(const uint8_t* output, const size_t len, const uint8_t reply,
+    const uint8_t seq)
+{
+    for(size_t i = 0; i + 1 < len; i++)
+    {
+        if((output[i] == reply) && (output[i+1] == RX_FRAME_REPLY_SEQ(seq)))
+            return (long)i;
+    }
+
+    return -1;
+}
+
+// Receive a data frame
+static void receive_frame(const uint8_t seq, const char* payload)
+{
+    uint8_t frame[FRAME_MAX_SIZE];
+
+    receive(frame, frame_build(frame, RX_FRAME_DATA, seq, payload, strlen(payload)));
+}
+
+// Receive a text
+static void receive_text(const char* text)
+{
+    receive((const uint8_t*)text, strlen(text));
+}
+
+// Check a recorded reply
+static void assert_reply(const uint8_t index, const uint8_t reply, const uint8_t seq)
+{
+    TEST_ASSERT_TRUE(index < replies_n);
+    TEST_ASSERT_EQUAL_HEX8(reply, replies[index]);
+    TEST_ASSERT_EQUAL_HEX8(RX_FRAME_REPLY_SEQ(seq), replies_seq[index]);
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+void setUp(void)
+{
+    rx_channel_init(&channel);
+    lines_n = 0;
+    replies_n = 0;
+}
+
+void tearDown(void) {}
+
+// CRC-16/CCITT-FALSE check value
+void test_frames_crc(void)
+{
+    const char* check = "123456789";
+    uint16_t crc = RX_FRAME_CRC_INIT;
+
+    for(uint8_t i = 0; i < 9; i++)
+        crc = rx_crc16_update(crc, check[i]);
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, crc);
+}
+
+// A valid frame is acknowledged and its payload is a line, also between text lines
+void test_frames_valid(void)
+{
+    receive_text("ENTER\n");
+    receive_frame(7, "STRING framed");
+    receive_text("TAB\n");
+
+    TEST_ASSERT_EQUAL_UINT8(3, lines_n);
+    TEST_ASSERT_EQUAL_STRING("ENTER", lines[0]);
+    TEST_ASSERT_EQUAL_STRING("STRING framed", lines[1]);
+    TEST_ASSERT_EQUAL_STRING("TAB", lines[2]);
+    TEST_ASSERT_EQUAL_UINT8(1, replies_n);
+    assert_reply(0, RX_FRAME_ACK, 7);
+}
+
+// A corrupted frame is rejected and bytes are discarded until next SYNC
+void test_frames_crc_error(void)
+{
+    uint8_t frame[FRAME_MAX_SIZE];
+    size_t len = frame_build(frame, RX_FRAME_DATA, 1, "STRING corrupted", 16);
+
+    frame[8] = frame[8] ^ 0x20;
+    receive(frame, len);
+    receive_text("garbage\n");
+    receive_frame(1, "STRING resent");
+
+    TEST_ASSERT_EQUAL_UINT8(1, lines_n);
+    TEST_ASSERT_EQUAL_STRING("STRING resent", lines[0]);
+    TEST_ASSERT_EQUAL_UINT8(2, replies_n);
+    assert_reply(0, RX_FRAME_NAK, 1);
+    assert_reply(1, RX_FRAME_ACK, 1);
+}
+
+// A frame with a wrong length is rejected
+void test_frames_bad_length(void)
+{
+    const uint8_t frame[] = { RX_FRAME_SYNC, RX_FRAME_DATA, 3, RX_LINE_SIZE, 'x' };
+
+    receive(frame, sizeof(frame));
+    receive_frame(3, "ENTER");
+
+    TEST_ASSERT_EQUAL_UINT8(1, lines_n);
+    TEST_ASSERT_EQUAL_STRING("ENTER", lines[0]);
+    assert_reply(0, RX_FRAME_NAK, 3);
+    assert_reply(1, RX_FRAME_ACK, 3);
+}
+
+// Frames are executed in sequence order: a resent frame is acknowledged but not executed again
+// and a frame that follows a lost one is rejected until the lost one is resent
+void test_frames_sequence(void)
+{
+    receive_frame(254, "a");
+    receive_frame(255, "b");
+    receive_frame(255, "b");
+    receive_frame(1, "d");
+    receive_frame(0, "c");
+    receive_frame(1, "d");
+    receive_frame(254, "a");
+
+    TEST_ASSERT_EQUAL_UINT8(4, lines_n);
+    TEST_ASSERT_EQUAL_STRING("a", lines[0]);
+    TEST_ASSERT_EQUAL_STRING("b", lines[1]);
+    TEST_ASSERT_EQUAL_STRING("c", lines[2]);
+    TEST_ASSERT_EQUAL_STRING("d", lines[3]);
+    TEST_ASSERT_EQUAL_UINT8(7, replies_n);
+    assert_reply(0, RX_FRAME_ACK, 254);
+    assert_reply(1, RX_FRAME_ACK, 255);
+    assert_reply(2, RX_FRAME_ACK, 255);
+    assert_reply(3, RX_FRAME_NAK, 1);
+    assert_reply(4, RX_FRAME_ACK, 0);
+    assert_reply(5, RX_FRAME_ACK, 1);
+    assert_reply(6, RX_FRAME_ACK, 254);
+}
+
+// An end of line out of a frame ends the sequence, next frame is accepted with any sequence
+void test_frames_sequence_reset(void)
+{
+    receive_frame(10, "a");
+    receive_text("\n");
+    receive_frame(10, "b");
+    receive_text("ENTER\n");
+    receive_frame(50, "c");
+
+    TEST_ASSERT_EQUAL_UINT8(4, lines_n);
+    TEST_ASSERT_EQUAL_STRING("b", lines[1]);
+    TEST_ASSERT_EQUAL_STRING("c", lines[3]);
+    assert_reply(1, RX_FRAME_ACK, 10);
+    assert_reply(2, RX_FRAME_ACK, 50);
+}
+
+// Reply sequences of frames numbered as flow control characters are not XON/XOFF
+void test_frames_reply_flow_control(void)
+{
+    static const uint8_t SEQS[] = { RX_XON, RX_XON + 1, RX_XOFF, RX_XON | RX_FRAME_REPLY_MARK,
+        RX_XON + 1, RX_XOFF | RX_FRAME_REPLY_MARK };
+
+    for(uint8_t i = 0; i < sizeof(SEQS); i++)
+        receive_frame(SEQS[i], "a");
+
+    TEST_ASSERT_EQUAL_UINT8(sizeof(SEQS), replies_n);
+    for(uint8_t i = 0; i < replies_n; i++)
+    {
+        TEST_ASSERT_NOT_EQUAL(RX_XON, replies_seq[i]);
+        TEST_ASSERT_NOT_EQUAL(RX_XOFF, replies_seq[i]);
+        TEST_ASSERT_EQUAL_HEX8(SEQS[i] & ~RX_FRAME_REPLY_MARK,
+            replies_seq[i] & ~RX_FRAME_REPLY_MARK);
+    }
+    assert_reply(2, RX_FRAME_ACK, RX_XOFF);
+    assert_reply(3, RX_FRAME_NAK, RX_XON | RX_FRAME_REPLY_MARK);
+}
+
+// A SYNC in a text line (i.e. a frame with a corrupted SYNC) discards it and starts a frame
+void test_frames_sync_in_text(void)
+{
+    uint8_t frame[FRAME_MAX_SIZE];
+    size_t len = frame_build(frame, RX_FRAME_DATA, 5, "ENTER", 5);
+
+    receive_text("partial");
+    receive(frame, len);
+
+    TEST_ASSERT_EQUAL_UINT8(1, lines_n);
+    TEST_ASSERT_EQUAL_STRING("ENTER", lines[0]);
+    assert_reply(0, RX_FRAME_ACK, 5);
+}
+
+// Empty data frames are just acknowledged, bauds frames are requests for the link owner
+void test_frames_empty_and_bauds(void)
+{
+    uint8_t frame[FRAME_MAX_SIZE];
+    const char bauds[] = { (char)0x00, (char)0xC2, (char)0x01, (char)0x00 };
+
+    receive_frame(20, "");
+    receive(frame, frame_build(frame, RX_FRAME_BAUDS, 21, bauds, sizeof(bauds)));
+
+    TEST_ASSERT_EQUAL_UINT8(0, lines_n);
+    TEST_ASSERT_EQUAL_UINT8(1, replies_n);
+    assert_reply(0, RX_FRAME_ACK, 20);
+    TEST_ASSERT_EQUAL_UINT32(115200, channel.bauds_request);
+    TEST_ASSERT_TRUE(channel.frame_received);
+}
+
+// Bauds can't be negotiated on USB Serial, the request is rejected
+void test_frames_bauds_usb(void)
+{
+    uint8_t input[FRAME_MAX_SIZE];
+    const char bauds[] = { (char)0x00, (char)0x96, (char)0x00, (char)0x00 };
+    size_t len = frame_build(input, RX_FRAME_BAUDS, 9, bauds, sizeof(bauds));
+    t_native_run_options options;
+    t_native_run run;
+
+    memset(&options, 0, sizeof(options));
+    options.input = input;
+    options.input_len = len;
+    TEST_ASSERT_EQUAL_INT(0, native_run(&options, &run));
+
+    TEST_ASSERT_NOT_NULL(memchr(run.output, RX_FRAME_NAK, run.output_len));
+    TEST_ASSERT_EQUAL_HEX8(RX_FRAME_REPLY_SEQ(9),
+        ((uint8_t*)memchr(run.output, RX_FRAME_NAK, run.output_len))[1]);
+    native_run_free(&run);
+}
+
+// An accepted bauds request is acknowledged at the previous bauds before the link switches, and a
+// valid frame at the new bauds confirms them
+void test_frames_bauds_switch(void)
+{
+    static uint8_t input[(SWITCH_FRAMES + 1) * FRAME_MAX_SIZE];
+    size_t len = frame_build_bauds(input, 1, LINK_BAUDS_SWITCH);
+    size_t switch_len = len;
+    uint32_t nominal_us = 0;
+    t_native_run run;
+
+    len = len + frame_build(&(input[len]), RX_FRAME_DATA, 2, "DEFAULT_DELAY 0",
+        strlen("DEFAULT_DELAY 0"));
+    for(uint8_t i = 3; i < SWITCH_FRAMES + 2; i++)
+        len = len + frame_build(&(input[len]), RX_FRAME_DATA, i, "TAB", strlen("TAB"));
+    nominal_us = (uint32_t)((len * 10000000ULL) / LINK_BAUDS_NOMINAL);
+
+    run_link(input, len, &run);
+    TEST_ASSERT_EQUAL_UINT32(1, run.bauds_changes);
+    TEST_ASSERT_EQUAL_UINT32(LINK_BAUDS_SWITCH, run.bauds);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, output_reply(run.output, run.bauds_change_output,
+        RX_FRAME_ACK, 1));
+    TEST_ASSERT_GREATER_OR_EQUAL((switch_len * 10000000ULL) / LINK_BAUDS_NOMINAL,
+        run.bauds_change_us);
+
+    // Next frames are received faster at the new bauds, and all of them are acknowledged
+    TEST_ASSERT_LESS_THAN(nominal_us / 2, run.input_closed_us);
+    for(uint8_t i = 2; i < SWITCH_FRAMES + 2; i++)
+    {
+        TEST_ASSERT_GREATER_OR_EQUAL((long)run.bauds_change_output,
+            output_reply(run.output, run.output_len, RX_FRAME_ACK, i));
+    }
+    TEST_ASSERT_EQUAL_UINT32(2 * (SWITCH_FRAMES - 1), run.reports_n);
+    native_run_free(&run);
+}
+
+// Bauds above the link maximum or that are not supported are rejected, and the link keeps its
+// bauds
+void test_frames_bauds_reject(void)
+{
+    uint8_t input[2 * FRAME_MAX_SIZE];
+    size_t len = frame_build_bauds(input, 1, 250000);
+    t_native_run run;
+
+    len = len + frame_build_bauds(&(input[len]), 2, 12345);
+    run_link(input, len, &run);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(0, output_reply(run.output, run.output_len, RX_FRAME_NAK, 1));
+    TEST_ASSERT_GREATER_OR_EQUAL(0, output_reply(run.output, run.output_len, RX_FRAME_NAK, 2));
+    TEST_ASSERT_LESS_THAN(0, output_reply(run.output, run.output_len, RX_FRAME_ACK, 1));
+    TEST_ASSERT_EQUAL_UINT32(0, run.bauds_changes);
+    TEST_ASSERT_EQUAL_UINT32(LINK_BAUDS_NOMINAL, run.bauds);
+    native_run_free(&run);
+}
+
+// New bauds that are not confirmed by a valid frame are replaced by the previous ones
+void test_frames_bauds_restore(void)
+{
+    uint8_t input[FRAME_MAX_SIZE];
+    size_t len = frame_build_bauds(input, 1, LINK_BAUDS_SWITCH);
+    t_native_run run;
+
+    run_link(input, len, &run);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(0, output_reply(run.output, run.output_len, RX_FRAME_ACK, 1));
+    TEST_ASSERT_EQUAL_UINT32(2, run.bauds_changes);
+    TEST_ASSERT_EQUAL_UINT32(LINK_BAUDS_NOMINAL, run.bauds);
+    TEST_ASSERT_UINT32_WITHIN(10000, LINK_BAUDS_CONFIRM_MS * 1000UL, run.bauds_change_us);
+    native_run_free(&run);
+}
+
+// Loopback of a framed script through the firmware at each supported link rate (the sender
+// honours XOFF): every frame is acknowledged and executed, goodput is the payload bytes received
+// per second
+void test_frames_loopback_goodput(void)
+{
+    static uint8_t input[LOOPBACK_FRAMES * FRAME_MAX_SIZE];
+    size_t len = 0;
+    size_t payload = 0;
+    uint16_t acks = 0;
+    uint16_t naks = 0;
+    uint32_t presses = 0;
+    t_native_run_options options;
+    t_native_run run;
+
+    len = frame_build(input, RX_FRAME_DATA, 0, "DEFAULT_DELAY 0", strlen("DEFAULT_DELAY 0"));
+    payload = strlen("DEFAULT_DELAY 0");
+    for(uint16_t i = 1; i < LOOPBACK_FRAMES; i++)
+    {
+        len = len + frame_build(&(input[len]), RX_FRAME_DATA, (uint8_t)i, LOOPBACK_LINE,
+            strlen(LOOPBACK_LINE));
+        payload = payload + strlen(LOOPBACK_LINE);
+    }
+
+    printf("%8s %10s %12s %12s %8s\n", "bauds", "frames", "link B/s", "goodput B/s", "eff");
+    for(uint8_t b = 0; b < sizeof(LINK_BAUDS)/sizeof(LINK_BAUDS[0]); b++)
+    {
+        memset(&options, 0, sizeof(options));
+        options.input = input;
+        options.input_len = len;
+        options.bauds = LINK_BAUDS[b];
+        options.xonxoff = true;
+        TEST_ASSERT_EQUAL_INT(0, native_run(&options, &run));
+
+        // Replies (a sequence follows each ACK or NAK, it is never a XON/XOFF character)
+        acks = 0;
+        naks = 0;
+        for(size_t i = 0; i + 1 < run.output_len; i++)
+        {
+            if((run.output[i] != RX_FRAME_ACK) && (run.output[i] != RX_FRAME_NAK))
+                continue;
+            if(run.output[i] == RX_FRAME_ACK)
+            {
+                TEST_ASSERT_EQUAL_HEX8(RX_FRAME_REPLY_SEQ(acks), run.output[i+1]);
+                acks = acks + 1;
+            }
+            else
+                naks = naks + 1;
+            i = i + 1;
+        }
+        presses = 0;
+        for(uint32_t i = 0; i < run.reports_n; i++)
+        {
+            if(run.reports[i].report.keys[0] != 0)
+                presses = presses + 1;
+        }
+
+        printf("%8u %10u %12u %12u %7.1f%%\n", LINK_BAUDS[b], acks, LINK_BAUDS[b] / 10,
+            (uint32_t)((payload * 1000000ULL) / run.input_closed_us),
+            (100.0 * payload * 10000000ULL) / ((double)run.input_closed_us * LINK_BAUDS[b]));
+        TEST_ASSERT_EQUAL_UINT16(LOOPBACK_FRAMES, acks);
+        TEST_ASSERT_EQUAL_UINT16(0, naks);
+        TEST_ASSERT_EQUAL_UINT32(LOOPBACK_FRAMES - 1, presses);
+        native_run_free(&run);
+    }
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_frames_crc);
+    RUN_TEST(test_frames_valid);
+    RUN_TEST(test_frames_crc_error);
+    RUN_TEST(test_frames_bad_length);
+    RUN_TEST(test_frames_sequence);
+    RUN_TEST(test_frames_sequence_reset);
+    RUN_TEST(test_frames_reply_flow_control);
+    RUN_TEST(test_frames_sync_in_text);
+    RUN_TEST(test_frames_empty_and_bauds);
+    RUN_TEST(test_frames_bauds_usb);
+    RUN_TEST(test_frames_bauds_switch);
+    RUN_TEST(test_frames_bauds_reject);
+    RUN_TEST(test_frames_bauds_restore);
+    RUN_TEST(test_frames_loopback_goodput);
+    return UNITY_END();
+}
@@ -0,0 +1,166 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_idle                                                                                  */
+/* Description:                                                                                   */
+/*     Idle sleep tests (native): the firmware sleeps only while the reception rings, the         */
+/*     commands queue and the executor have nothing to do, and it keeps sleeping while received   */
+/*     lines wait for room in a full queue during a delay.                                        */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include "NativeRun.h"
+#include "cmdqueue.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Commands of the busy scripts (their lines are many times the commands queue depth and the
+// reception ring size)
+#define BUSY_COMMANDS (50 * CMD_QUEUE_DEPTH)
+
+// Commands of the stored script test
+#define STORE_COMMANDS 20
+
+// Delay command of the delay tests (ms)
+#define IDLE_DELAY_MS 50
+
+// Script buffers size
+#define SCRIPT_SIZE 4096
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+static t_native_run run;
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Run a script with an unpaced Serial input
+static void run_script(const char* script)
+{
+    t_native_run_options options;
+
+    memset(&options, 0, sizeof(options));
+    options.input = (const uint8_t*)script;
+    options.input_len = strlen(script);
+    TEST_ASSERT_EQUAL_INT(0, native_run(&options, &run));
+    TEST_ASSERT_LESS_OR_EQUAL(NATIVE_RUN_MAX_SLEEPS, run.sleeps_n);
+    TEST_ASSERT_LESS_OR_EQUAL(NATIVE_RUN_MAX_REPORTS, run.reports_n);
+}
+
+// Append some TAB lines to a script, returns its new length
+static size_t script_tabs(char* script, size_t len, const uint16_t tabs)
+{
+    for(uint16_t i = 0; i < tabs; i++)
+        len = len + snprintf(&(script[len]), SCRIPT_SIZE - len, "TAB\n");
+
+    return len;
+}
+
+// Count the idle sleeps of the run between two times (us)
+static uint32_t sleeps_between(const uint32_t start_us, const uint32_t end_us)
+{
+    uint32_t sleeps = 0;
+
+    for(uint32_t i = 0; i < run.sleeps_n; i++)
+    {
+        if((run.sleeps_us[i] >= start_us) && (run.sleeps_us[i] < end_us))
+            sleeps = sleeps + 1;
+    }
+
+    return sleeps;
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+void setUp(void) {}
+
+void tearDown(void)
+{
+    native_run_free(&run);
+}
+
+// No sleep while commands are queued or received lines are waiting, the firmware sleeps once
+// every command has been executed
+void test_idle_busy_commands(void)
+{
+    static char script[SCRIPT_SIZE];
+    size_t len = snprintf(script, sizeof(script), "DEFAULT_DELAY 0\n");
+
+    script_tabs(script, len, BUSY_COMMANDS);
+    run_script(script);
+
+    TEST_ASSERT_EQUAL_UINT32(2 * BUSY_COMMANDS, run.reports_n);
+    TEST_ASSERT_EQUAL_UINT32(0, sleeps_between(0, run.reports[run.reports_n - 1].us));
+    TEST_ASSERT_GREATER_THAN(0, run.sleeps_n);
+}
+
+// No sleep while a loop is being replayed
+void test_idle_busy_replay(void)
+{
+    static char script[SCRIPT_SIZE];
+
+    snprintf(script, sizeof(script), "DEFAULT_DELAY 0\nLOOP %u\nTAB\nEND\n", BUSY_COMMANDS);
+    run_script(script);
+
+    TEST_ASSERT_EQUAL_UINT32(2 * BUSY_COMMANDS, run.reports_n);
+    TEST_ASSERT_EQUAL_UINT32(0, sleeps_between(0, run.reports[run.reports_n - 1].us));
+}
+
+// No sleep while a stored script is being recorded into the EEPROM (its writes end without an
+// interrupt) nor while the received lines wait for them, until the stored script is replayed
+void test_idle_busy_store(void)
+{
+    static char script[SCRIPT_SIZE];
+    size_t len = snprintf(script, sizeof(script), "DEFAULT_DELAY 0\nSTORE\n");
+
+    len = script_tabs(script, len, STORE_COMMANDS);
+    snprintf(&(script[len]), sizeof(script) - len, "END\nRUN\n");
+    run_script(script);
+
+    TEST_ASSERT_EQUAL_UINT32(2 * STORE_COMMANDS, run.reports_n);
+    TEST_ASSERT_EQUAL_UINT32(0, sleeps_between(0, run.reports[run.reports_n - 1].us));
+}
+
+// The executor waiting for a delay deadline sleeps every timer tick, also while the received
+// lines wait for room in the full commands queue, and those commands run without sleeps after it
+void test_idle_delay(void)
+{
+    static char script[SCRIPT_SIZE];
+    size_t len = snprintf(script, sizeof(script), "DEFAULT_DELAY 0\nTAB\nDELAY %u\n",
+        IDLE_DELAY_MS);
+    uint32_t delay_start_us = 0;
+    uint32_t delay_end_us = 0;
+
+    script_tabs(script, len, BUSY_COMMANDS);
+    run_script(script);
+
+    TEST_ASSERT_EQUAL_UINT32(2 * (BUSY_COMMANDS + 1), run.reports_n);
+    delay_start_us = run.reports[1].us;
+    delay_end_us = run.reports[2].us;
+    TEST_ASSERT_UINT32_WITHIN(1000, IDLE_DELAY_MS * 1000UL, delay_end_us - delay_start_us);
+    TEST_ASSERT_UINT32_WITHIN(1, IDLE_DELAY_MS, sleeps_between(delay_start_us, delay_end_us));
+    TEST_ASSERT_EQUAL_UINT32(0, sleeps_between(delay_end_us,
+        run.reports[run.reports_n - 1].us));
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_idle_busy_commands);
+    RUN_TEST(test_idle_busy_replay);
+    RUN_TEST(test_idle_busy_store);
+    RUN_TEST(test_idle_delay);
+    return UNITY_END();
+}
@@ -0,0 +1,356 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_keys                                                                                  */
+/* Description:                                                                                   */
+/*     Ducky Script key names lookup tests (native), and microbenchmark of the lookup cost before */
+/*     (original strcmp() chain) and after (single character path and sorted names table).        */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include <time.h>
+#include "duckykeys.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Lookups of each key name in the microbenchmark
+#define BENCH_LOOKUPS 20000
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+typedef struct
+{
+    const char* name;
+    uint8_t key;
+} t_key_case;
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Multi-character key names (every name in the table and its expected key code)
+static const t_key_case NAMES[] =
+{
+    { "APP", KEY_MENU }, { "BREAK", KEY_PAUSE }, { "CAPSLOCK", KEY_CAPS_LOCK },
+    { "CAPS_LOCK", KEY_CAPS_LOCK }, { "DEL", KEY_DELETE }, { "DELETE", KEY_DELETE },
+    { "DOWN", KEY_DOWN }, { "DOWNARROW", KEY_DOWN }, { "END", KEY_END }, { "ENTER", KEY_ENTER },
+    { "ESC", KEY_ESC }, { "ESCAPE", KEY_ESC }, { "F1", KEY_F1 }, { "F10", KEY_F10 },
+    { "F11", KEY_F11 }, { "F12", KEY_F12 }, { "F2", KEY_F2 }, { "F3", KEY_F3 }, { "F4", KEY_F4 },
+    { "F5", KEY_F5 }, { "F6", KEY_F6 }, { "F7", KEY_F7 }, { "F8", KEY_F8 }, { "F9", KEY_F9 },
+    { "HOME", KEY_HOME }, { "INSERT", KEY_INSERT }, { "LEFT", KEY_LEFT },
+    { "LEFTARROW", KEY_LEFT }, { "MEDIA_MUTE", KEY_MEDIA_MUTE },
+    { "MEDIA_PLAY_PAUSE", KEY_MEDIA_PLAY_PAUSE }, { "MEDIA_STOP", KEY_MEDIA_STOP },
+    { "MEDIA_VOLUME_DEC", KEY_MEDIA_VOLUME_DEC }, { "MEDIA_VOLUME_INC", KEY_MEDIA_VOLUME_INC },
+    { "MENU", KEY_MENU }, { "MUTE", KEY_MEDIA_MUTE }, { "NUMLOCK", KEY_NUM_LOCK },
+    { "NUM_LOCK", KEY_NUM_LOCK }, { "PAGEDOWN", KEY_PAGEDOWN }, { "PAGEUP", KEY_PAGEUP },
+    { "PAUSE", KEY_MEDIA_PLAY_PAUSE }, { "PLAY", KEY_MEDIA_PLAY_PAUSE }, { "POWER", KEY_POWER },
+    { "PRINTSCREEN", KEY_PRINTSCREEN }, { "RIGHT", KEY_RIGHT }, { "RIGHTARROW", KEY_RIGHT },
+    { "SCROLLLOCK", KEY_SCROLL_LOCK }, { "SCROLL_LOCK", KEY_SCROLL_LOCK }, { "SPACE", KEY_SPACE },
+    { "STOP", KEY_MEDIA_STOP }, { "TAB", KEY_TAB }, { "UP", KEY_UP }, { "UPARROW", KEY_UP },
+    { "VOLUMEDOWN", KEY_MEDIA_VOLUME_DEC }, { "VOLUMEUP", KEY_MEDIA_VOLUME_INC }
+};
+
+// Names that are not keys (prefixes, extensions, other case and too long names)
+static const char* const NOT_KEYS[] =
+{
+    "DOW", "DOWNARROWS", "ENTE", "ENTERR", "enter", "Enter", "F0", "F13", "MEDIA_",
+    "AAPP", "ZZZ", "MEDIA_PLAY_PAUSE_", "VOLUMEUPVOLUMEUP_", "!", " ", "-", "~"
+};
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+// Original strcmp() chain lookup (null terminated key name)
+static uint8_t strcmp_key_to_hid_byte(const char* key)
+{
+    if(strcmp(key, "POWER") == 0)
+        return KEY_POWER;
+    if(strcmp(key, "HOME") == 0)
+        return KEY_HOME;
+    if(strcmp(key, "INSERT") == 0)
+        return KEY_INSERT;
+    if(strcmp(key, "PAGEUP") == 0)
+        return KEY_PAGEUP;
+    if(strcmp(key, "PAGEDOWN") == 0)
+        return KEY_PAGEDOWN;
+    if(strcmp(key, "PRINTSCREEN") == 0)
+        return KEY_PRINTSCREEN;
+    if(strcmp(key, "ENTER") == 0)
+        return KEY_ENTER;
+    if(strcmp(key, "SPACE") == 0)
+        return KEY_SPACE;
+    if(strcmp(key, "TAB") == 0)
+        return KEY_TAB;
+    if(strcmp(key, "END") == 0)
+        return KEY_END;
+    if(strcmp(key, "BREAK") == 0)
+        return KEY_PAUSE;
+    if((strcmp(key, "LEFTARROW") == 0) || (strcmp(key, "LEFT") == 0))
+        return KEY_LEFT;
+    if((strcmp(key, "RIGHTARROW") == 0) || (strcmp(key, "RIGHT") == 0))
+        return KEY_RIGHT;
+    if((strcmp(key, "DOWNARROW") == 0) || (strcmp(key, "DOWN") == 0))
+        return KEY_DOWN;
+    if((strcmp(key, "UPARROW") == 0) || (strcmp(key, "UP") == 0))
+        return KEY_UP;
+    if((strcmp(key, "ESCAPE") == 0) || (strcmp(key, "ESC") == 0))
+        return KEY_ESC;
+    if((strcmp(key, "DELETE") == 0) || (strcmp(key, "DEL") == 0))
+        return KEY_DELETE;
+    if((strcmp(key, "MENU") == 0) || (strcmp(key, "APP") == 0))
+        return KEY_MENU;
+    if((strcmp(key, "NUMLOCK") == 0) || (strcmp(key, "NUM_LOCK") == 0))
+        return KEY_NUM_LOCK;
+    if((strcmp(key, "CAPSLOCK") == 0) || (strcmp(key, "CAPS_LOCK") == 0))
+        return KEY_CAPS_LOCK;
+    if((strcmp(key, "SCROLLLOCK") == 0) || (strcmp(key, "SCROLL_LOCK") == 0))
+        return KEY_SCROLL_LOCK;
+    if((strcmp(key, "MEDIA_PLAY_PAUSE") == 0) ||
+        (strcmp(key, "PLAY") == 0) || (strcmp(key, "PAUSE") == 0))
+    {
+        return KEY_MEDIA_PLAY_PAUSE;
+    }
+    if((strcmp(key, "MEDIA_STOP") == 0) || (strcmp(key, "STOP") == 0))
+        return KEY_MEDIA_STOP;
+    if((strcmp(key, "MEDIA_MUTE") == 0) || (strcmp(key, "MUTE") == 0))
+        return KEY_MEDIA_MUTE;
+    if((strcmp(key, "MEDIA_VOLUME_INC") == 0) || (strcmp(key, "VOLUMEUP") == 0))
+        return KEY_MEDIA_VOLUME_INC;
+    if((strcmp(key, "MEDIA_VOLUME_DEC") == 0) || (strcmp(key, "VOLUMEDOWN") == 0))
+        return KEY_MEDIA_VOLUME_DEC;
+    if((strcmp(key, "a") == 0) || (strcmp(key, "A") == 0))
+        return KEY_A;
+    if((strcmp(key, "b") == 0) || (strcmp(key, "B") == 0))
+        return KEY_B;
+    if((strcmp(key, "c") == 0) || (strcmp(key, "C") == 0))
+        return KEY_C;
+    if((strcmp(key, "d") == 0) || (strcmp(key, "D") == 0))
+        return KEY_D;
+    if((strcmp(key, "e") == 0) || (strcmp(key, "E") == 0))
+        return KEY_E;
+    if((strcmp(key, "f") == 0) || (strcmp(key, "F") == 0))
+        return KEY_F;
+    if((strcmp(key, "g") == 0) || (strcmp(key, "G") == 0))
+        return KEY_G;
+    if((strcmp(key, "h") == 0) || (strcmp(key, "H") == 0))
+        return KEY_H;
+    if((strcmp(key, "i") == 0) || (strcmp(key, "I") == 0))
+        return KEY_I;
+    if((strcmp(key, "j") == 0) || (strcmp(key, "J") == 0))
+        return KEY_J;
+    if((strcmp(key, "k") == 0) || (strcmp(key, "K") == 0))
+        return KEY_K;
+    if((strcmp(key, "l") == 0) || (strcmp(key, "L") == 0))
+        return KEY_L;
+    if((strcmp(key, "m") == 0) || (strcmp(key, "M") == 0))
+        return KEY_M;
+    if((strcmp(key, "n") == 0) || (strcmp(key, "N") == 0))
+        return KEY_N;
+    if((strcmp(key, "o") == 0) || (strcmp(key, "O") == 0))
+        return KEY_O;
+    if((strcmp(key, "p") == 0) || (strcmp(key, "P") == 0))
+        return KEY_P;
+    if((strcmp(key, "q") == 0) || (strcmp(key, "Q") == 0))
+        return KEY_Q;
+    if((strcmp(key, "r") == 0) || (strcmp(key, "R") == 0))
+        return KEY_R;
+    if((strcmp(key, "s") == 0) || (strcmp(key, "S") == 0))
+        return KEY_S;
+    if((strcmp(key, "t") == 0) || (strcmp(key, "T") == 0))
+        return KEY_T;
+    if((strcmp(key, "u") == 0) || (strcmp(key, "U") == 0))
+        return KEY_U;
+    if((strcmp(key, "v") == 0) || (strcmp(key, "V") == 0))
+        return KEY_V;
+    if((strcmp(key, "w") == 0) || (strcmp(key, "W") == 0))
+        return KEY_W;
+    if((strcmp(key, "x") == 0) || (strcmp(key, "X") == 0))
+        return KEY_X;
+    if((strcmp(key, "y") == 0) || (strcmp(key, "Y") == 0))
+        return KEY_Y;
+    if((strcmp(key, "z") == 0) || (strcmp(key, "Z") == 0))
+        return KEY_Z;
+    if(strcmp(key, "0") == 0)
+        return KEY_0;
+    if(strcmp(key, "1") == 0)
+        return KEY_1;
+    if(strcmp(key, "2") == 0)
+        return KEY_2;
+    if(strcmp(key, "3") == 0)
+        return KEY_3;
+    if(strcmp(key, "4") == 0)
+        return KEY_4;
+    if(strcmp(key, "5") == 0)
+        return KEY_5;
+    if(strcmp(key, "6") == 0)
+        return KEY_6;
+    if(strcmp(key, "7") == 0)
+        return KEY_7;
+    if(strcmp(key, "8") == 0)
+        return KEY_8;
+    if(strcmp(key, "9") == 0)
+        return KEY_9;
+    if(strcmp(key, "F1") == 0)
+        return KEY_F1;
+    if(strcmp(key, "F2") == 0)
+        return KEY_F2;
+    if(strcmp(key, "F3") == 0)
+        return KEY_F3;
+    if(strcmp(key, "F4") == 0)
+        return KEY_F4;
+    if(strcmp(key, "F5") == 0)
+        return KEY_F5;
+    if(strcmp(key, "F6") == 0)
+        return KEY_F6;
+    if(strcmp(key, "F7") == 0)
+        return KEY_F7;
+    if(strcmp(key, "F8") == 0)
+        return KEY_F8;
+    if(strcmp(key, "F9") == 0)
+        return KEY_F9;
+
+    return KEY_UNDEFINED_ERROR;
+}
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Measure the mean cost of a lookup of some key names (ns), before (strcmp() chain) or after
+static double bench_lookup(const char* const* names, const size_t names_n, const bool before)
+{
+    volatile uint8_t sink = 0;
+    size_t lens[64];
+    uint64_t start = 0;
+
+    for(size_t i = 0; i < names_n; i++)
+        lens[i] = strlen(names[i]);
+
+    start = monotonic_ns();
+    for(uint32_t n = 0; n < BENCH_LOOKUPS; n++)
+    {
+        for(size_t i = 0; i < names_n; i++)
+        {
+            if(before)
+                sink = strcmp_key_to_hid_byte(names[i]);
+            else
+                sink = ducky_key_to_hid_byte(names[i], lens[i]);
+        }
+    }
+    (void)sink;
+
+    return (double)(monotonic_ns() - start) / ((double)BENCH_LOOKUPS * names_n);
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Every multi-character name gets its key code (same as the original lookup, that lacked F10-F12)
+void test_keys_names(void)
+{
+    for(size_t i = 0; i < sizeof(NAMES)/sizeof(NAMES[0]); i++)
+    {
+        TEST_ASSERT_EQUAL_HEX8_MESSAGE(NAMES[i].key,
+            ducky_key_to_hid_byte(NAMES[i].name, strlen(NAMES[i].name)), NAMES[i].name);
+        if((NAMES[i].key != KEY_F10) && (NAMES[i].key != KEY_F11) && (NAMES[i].key != KEY_F12))
+        {
+            TEST_ASSERT_EQUAL_HEX8_MESSAGE(strcmp_key_to_hid_byte(NAMES[i].name),
+                NAMES[i].key, NAMES[i].name);
+        }
+    }
+}
+
+// Letters (any case) and digits get their key codes, same as the original lookup
+void test_keys_single_chars(void)
+{
+    char key[2] = { 0, 0 };
+
+    for(uint8_t c = 0; c < 128; c++)
+    {
+        key[0] = c;
+        TEST_ASSERT_EQUAL_HEX8_MESSAGE(strcmp_key_to_hid_byte(key), ducky_key_to_hid_byte(key, 1),
+            key);
+    }
+    TEST_ASSERT_EQUAL_HEX8(KEY_A, ducky_key_to_hid_byte("a", 1));
+    TEST_ASSERT_EQUAL_HEX8(KEY_Z, ducky_key_to_hid_byte("Z", 1));
+    TEST_ASSERT_EQUAL_HEX8(KEY_1, ducky_key_to_hid_byte("1", 1));
+    TEST_ASSERT_EQUAL_HEX8(KEY_0, ducky_key_to_hid_byte("0", 1));
+}
+
+// Names that are not keys, and empty names, are undefined
+void test_keys_not_found(void)
+{
+    for(size_t i = 0; i < sizeof(NOT_KEYS)/sizeof(NOT_KEYS[0]); i++)
+    {
+        TEST_ASSERT_EQUAL_HEX8_MESSAGE(KEY_UNDEFINED_ERROR,
+            ducky_key_to_hid_byte(NOT_KEYS[i], strlen(NOT_KEYS[i])), NOT_KEYS[i]);
+    }
+    TEST_ASSERT_EQUAL_HEX8(KEY_UNDEFINED_ERROR, ducky_key_to_hid_byte("", 0));
+}
+
+// Names are spans of a line (not null terminated)
+void test_keys_spans(void)
+{
+    TEST_ASSERT_EQUAL_HEX8(KEY_ENTER, ducky_key_to_hid_byte("ENTER ESC", 5));
+    TEST_ASSERT_EQUAL_HEX8(KEY_DELETE, ducky_key_to_hid_byte("DELETE", 6));
+    TEST_ASSERT_EQUAL_HEX8(KEY_DELETE, ducky_key_to_hid_byte("DELETE", 3));
+    TEST_ASSERT_EQUAL_HEX8(KEY_DOWN, ducky_key_to_hid_byte("DOWNARROW", 4));
+    TEST_ASSERT_EQUAL_HEX8(KEY_F1, ducky_key_to_hid_byte("F12", 2));
+    TEST_ASSERT_EQUAL_HEX8(KEY_R, ducky_key_to_hid_byte("r\n", 1));
+}
+
+// Lookup cost before and after, for keys at the start and end of the original chain
+// Letters and digits (last in the chain) take a single function call now
+void test_keys_benchmark(void)
+{
+    static const char* const FIRST[] = { "POWER", "HOME", "INSERT", "PAGEUP", "ENTER", "TAB" };
+    static const char* const CHARS[] = { "a", "R", "z", "0", "5", "9" };
+    static const char* const LAST[] = { "MEDIA_VOLUME_DEC", "VOLUMEDOWN", "F7", "F8", "F9" };
+    static const char* const BAD[] = { "DOW", "enter", "F13", "Q1", "SPACEBAR" };
+    double first[2] = { bench_lookup(FIRST, 6, true), bench_lookup(FIRST, 6, false) };
+    double chars[2] = { bench_lookup(CHARS, 6, true), bench_lookup(CHARS, 6, false) };
+    double last[2] = { bench_lookup(LAST, 5, true), bench_lookup(LAST, 5, false) };
+    double bad[2] = { bench_lookup(BAD, 5, true), bench_lookup(BAD, 5, false) };
+
+    printf("%-24s %12s %12s\n", "key lookup (ns)", "before", "after");
+    printf("%-24s %12.1f %12.1f\n", "first chain names", first[0], first[1]);
+    printf("%-24s %12.1f %12.1f\n", "letters and digits", chars[0], chars[1]);
+    printf("%-24s %12.1f %12.1f\n", "last chain names", last[0], last[1]);
+    printf("%-24s %12.1f %12.1f\n", "not keys", bad[0], bad[1]);
+
+    TEST_ASSERT_TRUE(chars[1] < chars[0]);
+    TEST_ASSERT_TRUE(bad[1] < bad[0]);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_keys_names);
+    RUN_TEST(test_keys_single_chars);
+    RUN_TEST(test_keys_not_found);
+    RUN_TEST(test_keys_spans);
+    RUN_TEST(test_keys_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,242 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_layouts                                                                               */
+/* Description:                                                                                   */
+/*     Keyboard layouts tests (native): characters that differ between layouts get their layout  */
+/*     keystroke, and every printable character of each layout table is typed with the reports   */
+/*     it defines (dead keys followed by a space), packing runs of keys into single reports.      */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include <NativeHID.h>
+#include "hidkeys.h"
+#include "hidstring.h"
+#include "NativeRun.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Keymap modifiers
+#define SHIFT HID_KEYMAP_SHIFT
+#define ALTGR HID_KEYMAP_ALTGR
+#define DEAD HID_KEYMAP_DEAD
+
+// Maximum number of recorded reports
+#define MAX_REPORTS 64
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+typedef struct
+{
+    const char* layout;
+    char c;
+    uint8_t modifiers;
+    uint8_t key;
+} t_layout_case;
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Layouts names
+static const char* const LAYOUTS[HID_LAYOUT_NUM] = { "US", "UK", "DE", "FR", "ES" };
+
+// Characters that differ between layouts (Windows layouts)
+static const t_layout_case CASES[] =
+{
+    { "US", '@', SHIFT, 0x1F }, { "US", '#', SHIFT, 0x20 }, { "US", '"', SHIFT, 0x34 },
+    { "US", '\\', 0, 0x31 }, { "US", 'y', 0, 0x1C }, { "US", 'z', 0, 0x1D },
+
+    { "UK", '@', SHIFT, 0x34 }, { "UK", '"', SHIFT, 0x1F }, { "UK", '#', 0, 0x31 },
+    { "UK", '~', SHIFT, 0x31 }, { "UK", '\\', 0, 0x64 }, { "UK", '|', SHIFT, 0x64 },
+
+    { "DE", 'y', 0, 0x1D }, { "DE", 'z', 0, 0x1C }, { "DE", '@', ALTGR, 0x14 },
+    { "DE", '/', SHIFT, 0x24 }, { "DE", '-', 0, 0x38 }, { "DE", '\\', ALTGR, 0x2D },
+    { "DE", '{', ALTGR, 0x24 }, { "DE", '<', 0, 0x64 }, { "DE", '^', DEAD, 0x35 },
+    { "DE", '`', DEAD | SHIFT, 0x2E },
+
+    { "FR", 'a', 0, 0x14 }, { "FR", 'q', 0, 0x04 }, { "FR", 'z', 0, 0x1A },
+    { "FR", 'w', 0, 0x1D }, { "FR", 'm', 0, 0x33 }, { "FR", '1', SHIFT, 0x1E },
+    { "FR", '&', 0, 0x1E }, { "FR", '@', ALTGR, 0x27 }, { "FR", '!', 0, 0x38 },
+    { "FR", '~', DEAD | ALTGR, 0x1F },
+
+    { "ES", '@', ALTGR, 0x1F }, { "ES", '"', SHIFT, 0x1F }, { "ES", '/', SHIFT, 0x24 },
+    { "ES", '\\', ALTGR, 0x35 }, { "ES", '|', ALTGR, 0x1E }, { "ES", '^', DEAD | SHIFT, 0x2F },
+    { "ES", '`', DEAD, 0x2F }
+};
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+// Reports sent by the Keyboard mock
+static t_native_hid_report reports[MAX_REPORTS];
+static uint16_t reports_n = 0;
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Record a sent report
+static void record_report(const t_native_hid_report* report, const uint32_t us)
+{
+    if(reports_n < MAX_REPORTS)
+        reports[reports_n] = *report;
+    reports_n = reports_n + 1;
+}
+
+// Select a layout by its name
+static void select_layout(const char* name)
+{
+    TEST_ASSERT_EQUAL_INT8(RC_OK, hid_layout_select(name, strlen(name)));
+}
+
+// Check a report
+static void assert_report(const uint16_t index, const uint8_t modifiers, const uint8_t key)
+{
+    TEST_ASSERT_TRUE(index < reports_n);
+    TEST_ASSERT_EQUAL_HEX8(modifiers, reports[index].modifiers);
+    TEST_ASSERT_EQUAL_HEX8(key, reports[index].keys[0]);
+    for(uint8_t i = 1; i < 6; i++)
+        TEST_ASSERT_EQUAL_HEX8(0, reports[index].keys[i]);
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+void setUp(void)
+{
+    reports_n = 0;
+}
+
+void tearDown(void)
+{
+    select_layout("US");
+}
+
+// Layouts are selected by name
+void test_layouts_select(void)
+{
+    for(uint8_t i = 0; i < HID_LAYOUT_NUM; i++)
+        select_layout(LAYOUTS[i]);
+    TEST_ASSERT_EQUAL_INT8(RC_INVALID_INPUT, hid_layout_select("XX", 2));
+    TEST_ASSERT_EQUAL_INT8(RC_INVALID_INPUT, hid_layout_select("U", 1));
+    TEST_ASSERT_EQUAL_INT8(RC_INVALID_INPUT, hid_layout_select("USA", 3));
+}
+
+// Characters that differ between layouts get their layout keystroke
+void test_layouts_tables(void)
+{
+    t_hid_keystroke keystroke;
+    char message[32];
+
+    for(size_t i = 0; i < sizeof(CASES)/sizeof(CASES[0]); i++)
+    {
+        select_layout(CASES[i].layout);
+        keystroke = hid_ascii_to_keystroke(CASES[i].c);
+        snprintf(message, sizeof(message), "%s '%c'", CASES[i].layout, CASES[i].c);
+        TEST_ASSERT_EQUAL_HEX8_MESSAGE(CASES[i].modifiers, keystroke.modifiers, message);
+        TEST_ASSERT_EQUAL_HEX8_MESSAGE(CASES[i].key, keystroke.key, message);
+    }
+}
+
+// Every printable character of each layout is typed with the reports of its table keystroke:
+// its key and modifiers pressed and then released, dead keys followed by a space
+void test_layouts_reports(void)
+{
+    t_hid_keystroke keystroke;
+    uint16_t expected = 0;
+    char message[32];
+
+    for(uint8_t l = 0; l < HID_LAYOUT_NUM; l++)
+    {
+        select_layout(LAYOUTS[l]);
+        for(char c = ' '; c <= '~'; c++)
+        {
+            snprintf(message, sizeof(message), "%s '%c'", LAYOUTS[l], c);
+            keystroke = hid_ascii_to_keystroke(c);
+            TEST_ASSERT_TRUE_MESSAGE(keystroke.key != 0, message);
+
+            reports_n = 0;
+            expected = (keystroke.modifiers & DEAD) ? 4 : 2;
+            TEST_ASSERT_EQUAL_UINT16(expected, hid_string_write(&c, 1));
+            TEST_ASSERT_EQUAL_UINT16(expected, reports_n);
+            assert_report(0, keystroke.modifiers & ~DEAD, keystroke.key);
+            assert_report(1, 0, 0);
+            if(keystroke.modifiers & DEAD)
+            {
+                assert_report(2, 0, KEY_SPACE);
+                assert_report(3, 0, 0);
+            }
+        }
+    }
+}
+
+// Distinct keys with the same modifiers share a report (up to 6), a repeated key or a modifiers
+// change end the run, and a dead key ends it after being packed
+void test_layouts_packing(void)
+{
+    select_layout("US");
+    TEST_ASSERT_EQUAL_UINT16(2, hid_string_write("abcdef", 6));
+    TEST_ASSERT_EQUAL_HEX8(0x04, reports[0].keys[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x09, reports[0].keys[5]);
+    TEST_ASSERT_EQUAL_UINT16(4, hid_string_write("abcdefg", 7));
+    TEST_ASSERT_EQUAL_UINT16(4, hid_string_write("aa", 2));
+    TEST_ASSERT_EQUAL_UINT16(4, hid_string_write("aB", 2));
+    TEST_ASSERT_EQUAL_UINT16(2, hid_string_write("AB", 2));
+
+    select_layout("DE");
+    TEST_ASSERT_EQUAL_UINT16(2, hid_string_write("abcdef", 6));
+    reports_n = 0;
+    TEST_ASSERT_EQUAL_UINT16(4, hid_string_write("a^b", 3));
+    TEST_ASSERT_EQUAL_HEX8(0x04, reports[0].keys[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x35, reports[0].keys[1]);
+    TEST_ASSERT_EQUAL_HEX8(KEY_SPACE, reports[2].keys[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x05, reports[2].keys[1]);
+}
+
+// LAYOUT command selects the layout of the following STRING commands
+void test_layouts_command(void)
+{
+    const char* script = "DEFAULT_DELAY 0\nSTRING zy\nLAYOUT DE\nSTRING zy\nLAYOUT FR\n"
+        "STRING a\nLAYOUT XX\nSTRING a\n";
+    t_native_run_options options;
+    t_native_run run;
+
+    memset(&options, 0, sizeof(options));
+    options.input = (const uint8_t*)script;
+    options.input_len = strlen(script);
+    TEST_ASSERT_EQUAL_INT(0, native_run(&options, &run));
+
+    TEST_ASSERT_EQUAL_UINT32(8, run.reports_n);
+    TEST_ASSERT_EQUAL_HEX8(0x1D, run.reports[0].report.keys[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x1C, run.reports[0].report.keys[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x1C, run.reports[2].report.keys[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x1D, run.reports[2].report.keys[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x14, run.reports[4].report.keys[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x14, run.reports[6].report.keys[0]);
+    native_run_free(&run);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    native_hid_set_hook(record_report);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_layouts_select);
+    RUN_TEST(test_layouts_tables);
+    RUN_TEST(test_layouts_reports);
+    RUN_TEST(test_layouts_packing);
+    RUN_TEST(test_layouts_command);
+    return UNITY_END();
+}
@@ -0,0 +1,231 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_lz                                                                                    */
+/* Description:                                                                                   */
+/*     Compressed text lines tests (native): every line of the HID traces scripts corpus          */
+/*     (test/traces/scripts) is encoded by the duckylz host encoder and decoded back by the       */
+/*     device decoder, and a benchmark reports the compression ratio and decode time per byte.    */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include <time.h>
+#include <string.h>
+#include "duckylz.h"
+
+// duckylz host encoder, without its main function
+#define DUCKYLZ_NO_MAIN
+#include "../../tools/duckylz/duckylz.cpp"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Benchmark corpus directory (relative to this source file directory by default)
+#ifndef BENCH_CORPUS_DIR
+    #define BENCH_CORPUS_DIR "../traces/scripts"
+#endif
+
+// Maximum corpus file path length
+#define BENCH_PATH_SIZE 512
+
+// Maximum corpus size
+#define BENCH_CORPUS_SIZE 8192
+
+// Times the compressed corpus is decoded in the benchmark
+#define BENCH_PASSES 2000
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Benchmark corpus scripts
+static const char* BENCH_CORPUS[] =
+{
+    "commands.txt", "keys.txt", "layouts.txt", "macros.txt", "store.txt"
+};
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+// Corpus and its compressed lines
+static char corpus[BENCH_CORPUS_SIZE];
+static size_t corpus_len = 0;
+static uint8_t encoded[2 * BENCH_CORPUS_SIZE];
+static size_t encoded_len = 0;
+
+// Bytes of the encoded lines (their text, without comment and empty lines)
+static size_t text_len = 0;
+
+// Lines too long to be decoded in the device line buffer (sent as text lines)
+static uint16_t long_lines = 0;
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+// Get the path of a benchmark corpus script
+// A relative corpus directory is taken from the directory of this source file, so the benchmark
+// doesn't depend on where tests are run from
+static void corpus_path(const char* name, char* path, const size_t size)
+{
+    const char* dir_end = strrchr(__FILE__, '/');
+    int dir_len = (dir_end == NULL) ? 0 : (int)(dir_end - __FILE__);
+
+    if((BENCH_CORPUS_DIR[0] == '/') || (dir_end == NULL))
+        snprintf(path, size, "%s/%s", BENCH_CORPUS_DIR, name);
+    else
+        snprintf(path, size, "%.*s/%s/%s", dir_len, __FILE__, BENCH_CORPUS_DIR, name);
+}
+
+// Load the benchmark corpus scripts one after the other, returns its size
+// The test fails if a script is missing, so a benchmark is never silently skipped
+static size_t corpus_load(char* text, const size_t size)
+{
+    char path[BENCH_PATH_SIZE];
+    FILE* file = NULL;
+    size_t len = 0;
+
+    for(size_t i = 0; i < sizeof(BENCH_CORPUS)/sizeof(BENCH_CORPUS[0]); i++)
+    {
+        corpus_path(BENCH_CORPUS[i], path, sizeof(path));
+        file = fopen(path, "rb");
+        if(file == NULL)
+        {
+            printf("Benchmark corpus %s not found\n", path);
+            TEST_FAIL_MESSAGE("Benchmark corpus not found");
+        }
+        len = len + fread(&(text[len]), 1, size - len, file);
+        fclose(file);
+    }
+    TEST_ASSERT_LESS_THAN(size, len);
+
+    return len;
+}
+
+// Decode compressed lines with the device decoder, returns the number of decoded characters
+static size_t decode(t_lz_state* lz, const uint8_t* code, const size_t len)
+{
+    char line[DEVICE_RX_LINE_SIZE];
+    uint16_t line_len = 0;
+    size_t decoded = 0;
+
+    for(size_t i = 0; i < len; i++)
+    {
+        if((code[i] == LZ_LINE_MARK) || (code[i] == '\n'))
+        {
+            decoded = decoded + line_len;
+            line_len = 0;
+            continue;
+        }
+        line_len = ducky_lz_decode(lz, code[i], line, line_len, sizeof(line));
+    }
+
+    return decoded;
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Each corpus line is decoded back by the device decoder as it was, with the history of the
+// previous lines
+void test_lz_round_trip(void)
+{
+    static t_encoder enc;
+    static t_lz_state lz;
+    char decoded[DEVICE_RX_LINE_SIZE];
+    uint16_t decoded_len = 0;
+    uint16_t code_len = 0;
+    size_t start = 0;
+    size_t len = 0;
+
+    corpus_len = corpus_load(corpus, sizeof(corpus));
+    for(uint8_t i = 0; i < LZ_DICT_MAX_ENTRIES; i++)
+        enc.dict_len[i] = ducky_lz_dict_entry(i, enc.dict[i]);
+    enc.dict_n = ducky_lz_dict_entries();
+
+    for(size_t i = 0; i < corpus_len; i = start + len + 1)
+    {
+        start = i;
+        len = 0;
+        while((start + len < corpus_len) && (corpus[start + len] != '\n'))
+            len = len + 1;
+
+        // Comment and empty lines are not sent
+        if((len == 0) || (strncmp(&(corpus[start]), "REM", 3) == 0))
+            continue;
+        if(len >= DEVICE_RX_LINE_SIZE)
+        {
+            long_lines = long_lines + 1;
+            continue;
+        }
+
+        code_len = encode_line(&enc, &(corpus[start]), len, &(encoded[encoded_len]));
+        TEST_ASSERT_EQUAL_HEX8(LZ_LINE_MARK, encoded[encoded_len]);
+        TEST_ASSERT_EQUAL_HEX8('\n', encoded[encoded_len + code_len - 1]);
+
+        decoded_len = 0;
+        for(uint16_t c = 1; c < code_len - 1; c++)
+        {
+            TEST_ASSERT_NOT_EQUAL('\n', encoded[encoded_len + c]);
+            decoded_len = ducky_lz_decode(&lz, encoded[encoded_len + c], decoded, decoded_len,
+                sizeof(decoded));
+        }
+        TEST_ASSERT_EQUAL_UINT16(len, decoded_len);
+        TEST_ASSERT_EQUAL_MEMORY(&(corpus[start]), decoded, len);
+
+        encoded_len = encoded_len + code_len;
+        text_len = text_len + len + 1;
+    }
+    TEST_ASSERT_GREATER_THAN(0, encoded_len);
+}
+
+// Compression ratio of the corpus and device decoder time per byte
+void test_lz_benchmark(void)
+{
+    static t_lz_state lz;
+    volatile size_t sink = 0;
+    uint64_t start = 0;
+    double decode_ns = 0;
+
+    TEST_ASSERT_GREATER_THAN(0, encoded_len);
+    start = monotonic_ns();
+    for(uint32_t n = 0; n < BENCH_PASSES; n++)
+        sink = decode(&lz, encoded, encoded_len);
+    decode_ns = (double)(monotonic_ns() - start) / BENCH_PASSES;
+    (void)sink;
+
+    printf("%s: %u text bytes, %u compressed bytes (ratio %.2fx, %u long lines sent as text)\n",
+        BENCH_CORPUS_DIR, (unsigned)text_len, (unsigned)encoded_len,
+        (double)text_len / encoded_len, long_lines);
+    printf("decode: %.1f ns/compressed byte, %.1f ns/text byte\n", decode_ns / encoded_len,
+        decode_ns / text_len);
+
+    TEST_ASSERT_LESS_THAN(text_len, encoded_len);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_lz_round_trip);
+    RUN_TEST(test_lz_benchmark);
+    return UNITY_END();
+}
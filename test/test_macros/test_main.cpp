@@ -0,0 +1,384 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_macros                                                                                */
+/* Description:                                                                                   */
+/*     On-device macros and loops tests (native): record and replay, a full arena, failed         */
+/*     redefinitions, too many nested blocks, blocks discarded until their END through the        */
+/*     firmware, and a benchmark of the link bytes saved by LOOP and DEFINE/CALL against the      */
+/*     expanded script.                                                                           */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include "NativeRun.h"
+#include "duckymacro.h"
+#include "hidkeys.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Link speed of the benchmark (bits per second)
+#define LINK_BAUDS 9600
+
+// Script buffers size
+#define SCRIPT_SIZE 8192
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Benchmark script, written with macros and loops and expanded
+typedef struct
+{
+    const char* name;
+    const char* macros;
+    const char* line;   // Line repeated in the expanded script
+    uint16_t repeats;
+} t_bench_script;
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Benchmark scripts
+static const t_bench_script BENCH_SCRIPTS[] =
+{
+    { "loop", "LOOP 100\nSTRING hello\nENTER\nEND\n", "STRING hello\nENTER\n", 100 },
+    { "nested", "LOOP 10\nLOOP 10\nTAB\nEND\nENTER\nEND\n", "TAB\nTAB\nTAB\nTAB\nTAB\n"
+        "TAB\nTAB\nTAB\nTAB\nTAB\nENTER\n", 10 },
+    { "define", "DEFINE login\nSTRING admin\nTAB\nSTRING password\nENTER\nEND\n"
+        "LOOP 20\nCALL login\nEND\n", "STRING admin\nTAB\nSTRING password\nENTER\n", 20 }
+};
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+// Macros arena of the unit tests
+static t_macros macros;
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Compile a line into a command record
+static void compile(const char* line, t_ducky_cmd* cmd)
+{
+    t_ducky_line parsed;
+
+    memset(cmd, 0, sizeof(t_ducky_cmd));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_parse_line(line, strlen(line), &parsed));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_compile(&parsed, cmd));
+}
+
+// Process a line as the firmware does with macros commands
+static int8_t process(const char* line)
+{
+    t_ducky_cmd cmd;
+
+    compile(line, &cmd);
+    switch(cmd.cmd)
+    {
+        case CMD_DEFINE:
+            return macro_define_start(&macros, &cmd);
+        case CMD_LOOP:
+            return macro_loop_start(&macros, &cmd);
+        case CMD_CALL:
+            return macro_call(&macros, &cmd);
+        case CMD_END:
+            return macro_end(&macros);
+        default:
+            return macro_record(&macros, &cmd);
+    }
+}
+
+// Replay the macros, returning the number of replayed commands and the last return code
+static uint16_t replay(int8_t* rc)
+{
+    t_ducky_cmd cmd;
+    uint16_t commands = 0;
+
+    while((*rc = macro_run_next(&macros, &cmd)) == RC_OK)
+        commands = commands + 1;
+
+    return commands;
+}
+
+// Run the firmware with a Serial input
+static void run_input(const char* input, const uint32_t bauds, t_native_run* run)
+{
+    t_native_run_options options;
+
+    memset(&options, 0, sizeof(options));
+    options.input = (const uint8_t*)input;
+    options.input_len = strlen(input);
+    options.bauds = bauds;
+    TEST_ASSERT_EQUAL_INT(0, native_run(&options, run));
+}
+
+// Check two runs sent the same reports (their times can differ)
+static void assert_same_reports(const t_native_run* expected, const t_native_run* run)
+{
+    TEST_ASSERT_EQUAL_UINT32(expected->reports_n, run->reports_n);
+    for(uint32_t i = 0; i < run->reports_n; i++)
+    {
+        TEST_ASSERT_EQUAL_MEMORY(&(expected->reports[i].report), &(run->reports[i].report),
+            sizeof(t_native_hid_report));
+    }
+}
+
+// Get the time of the last report of a run (ms)
+static double last_report_ms(const t_native_run* run)
+{
+    if(run->reports_n == 0)
+        return 0;
+    return run->reports[run->reports_n - 1].us / 1000.0;
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+void setUp(void)
+{
+    memset(&macros, 0, sizeof(macros));
+}
+
+void tearDown(void) {}
+
+// A defined macro is replayed by CALL, and a top level loop by its END
+void test_macros_replay(void)
+{
+    int8_t rc = RC_OK;
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("DEFINE two"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("TAB"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("ENTER"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("END"));
+    TEST_ASSERT_FALSE(macro_running(&macros));
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("CALL two"));
+    TEST_ASSERT_TRUE(macro_running(&macros));
+    TEST_ASSERT_EQUAL_UINT16(2, replay(&rc));
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, rc);
+
+    // Loop calling the macro, with a nested loop
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("LOOP 3"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("CALL two"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("LOOP 4"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("SPACE"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("END"));
+    TEST_ASSERT_FALSE(macro_running(&macros));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("END"));
+    TEST_ASSERT_EQUAL_UINT16(3 * (2 + 4), replay(&rc));
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, rc);
+
+    // Unknown macro
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, process("CALL three"));
+}
+
+// Recording stops once a command doesn't fit in the arena, previous definitions are kept
+void test_macros_arena_full(void)
+{
+    uint16_t length = 0;
+    uint16_t commands = 0;
+    int8_t rc = RC_OK;
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("DEFINE tab"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("TAB"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("END"));
+    length = macros.length;
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("DEFINE full"));
+    while(process("STRING abcdefghijklmnopqrstuvwxyz") == RC_OK)
+        commands = commands + 1;
+    TEST_ASSERT_GREATER_THAN(0, commands);
+    TEST_ASSERT_LESS_OR_EQUAL(MACRO_ARENA_SIZE, macros.record_position);
+    TEST_ASSERT_FALSE(macros.recording);
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, process("END"));
+    TEST_ASSERT_EQUAL_UINT16(length, macros.length);
+
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, process("CALL full"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("CALL tab"));
+    TEST_ASSERT_EQUAL_UINT16(1, replay(&rc));
+
+    // A top level loop body uses the arena left after the definitions
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("LOOP 2"));
+    while(process("STRING abcdefghijklmnopqrstuvwxyz") == RC_OK);
+    TEST_ASSERT_FALSE(macros.recording);
+    TEST_ASSERT_EQUAL_UINT16(length, macros.length);
+
+    // Definitions can't be nested and their names are bounded
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("DEFINE outer"));
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, process("DEFINE inner"));
+    macro_record_abort(&macros);
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, process("DEFINE abcdefghijklmnopq"));
+}
+
+// A redefinition replaces a macro once it ends, and a failed one keeps the previous definition
+void test_macros_redefine(void)
+{
+    uint16_t length = 0;
+    int8_t rc = RC_OK;
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("DEFINE two"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("TAB"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("ENTER"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("END"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("DEFINE one"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("SPACE"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("END"));
+    length = macros.length;
+
+    // Redefinition that doesn't fit in the arena
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("DEFINE two"));
+    while(process("STRING abcdefghijklmnopqrstuvwxyz") == RC_OK);
+    TEST_ASSERT_FALSE(macros.recording);
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, process("END"));
+    TEST_ASSERT_EQUAL_UINT16(length, macros.length);
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("CALL two"));
+    TEST_ASSERT_EQUAL_UINT16(2, replay(&rc));
+
+    // Redefinition aborted (as the firmware does on an invalid line)
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("DEFINE two"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("TAB"));
+    macro_record_abort(&macros);
+    TEST_ASSERT_EQUAL_UINT16(length, macros.length);
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("CALL two"));
+    TEST_ASSERT_EQUAL_UINT16(2, replay(&rc));
+
+    // Redefinition that ends, the following definitions are kept
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("DEFINE two"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("TAB"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("TAB"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("TAB"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("END"));
+    TEST_ASSERT_EQUAL_UINT16(length + 2, macros.length);
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("CALL two"));
+    TEST_ASSERT_EQUAL_UINT16(3, replay(&rc));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("CALL one"));
+    TEST_ASSERT_EQUAL_UINT16(1, replay(&rc));
+}
+
+// Replay stops with an error once blocks are nested deeper than the replay stack
+void test_macros_nesting_overflow(void)
+{
+    int8_t rc = RC_OK;
+
+    // Top level loop and nested loops up to the stack depth
+    for(uint8_t i = 0; i < MACRO_STACK_DEPTH; i++)
+        TEST_ASSERT_EQUAL_INT8(RC_OK, process("LOOP 2"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("TAB"));
+    for(uint8_t i = 0; i < MACRO_STACK_DEPTH; i++)
+        TEST_ASSERT_EQUAL_INT8(RC_OK, process("END"));
+    TEST_ASSERT_EQUAL_UINT16(1 << MACRO_STACK_DEPTH, replay(&rc));
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, rc);
+
+    // One more level
+    for(uint8_t i = 0; i <= MACRO_STACK_DEPTH; i++)
+        TEST_ASSERT_EQUAL_INT8(RC_OK, process("LOOP 2"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("TAB"));
+    for(uint8_t i = 0; i <= MACRO_STACK_DEPTH; i++)
+        TEST_ASSERT_EQUAL_INT8(RC_OK, process("END"));
+    TEST_ASSERT_EQUAL_UINT16(0, replay(&rc));
+    TEST_ASSERT_EQUAL_INT8(RC_INVALID_INPUT, rc);
+    TEST_ASSERT_FALSE(macro_running(&macros));
+
+    // A recursive macro
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("DEFINE self"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("TAB"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("CALL self"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("END"));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, process("CALL self"));
+    TEST_ASSERT_EQUAL_UINT16(MACRO_STACK_DEPTH, replay(&rc));
+    TEST_ASSERT_EQUAL_INT8(RC_INVALID_INPUT, rc);
+    TEST_ASSERT_FALSE(macro_running(&macros));
+}
+
+// Blocks that can't be recorded are discarded until their END, nested ENDs included, and the
+// firmware keeps running the following commands
+void test_macros_firmware_discard(void)
+{
+    static char input[SCRIPT_SIZE];
+    size_t len = snprintf(input, sizeof(input), "DEFAULT_DELAY 0\nLOOP 2\nLOOP 2\nSPACE\nEND\n");
+    t_native_run run;
+
+    for(uint8_t i = 0; i < 10; i++)
+    {
+        len = len + snprintf(&(input[len]), sizeof(input) - len,
+            "STRING abcdefghijklmnopqrstuvwxyz\n");
+    }
+    len = len + snprintf(&(input[len]), sizeof(input) - len,
+        "LOOP 2\nSPACE\nEND\nEND\nDEFINE abcdefghijklmnopq\nSPACE\nEND\nTAB\n");
+    run_input(input, 0, &run);
+
+    TEST_ASSERT_EQUAL_UINT32(2, run.reports_n);
+    TEST_ASSERT_EQUAL_HEX8(KEY_TAB, run.reports[0].report.keys[0]);
+    TEST_ASSERT_NOT_NULL(strstr((const char*)run.output, "discarded until its END"));
+    native_run_free(&run);
+
+    // Too many nested blocks stop the replay with an error
+    run_input("DEFAULT_DELAY 0\nDEFINE self\nTAB\nCALL self\nEND\nCALL self\nENTER\n", 0, &run);
+    TEST_ASSERT_EQUAL_UINT32(2 * (MACRO_STACK_DEPTH + 1), run.reports_n);
+    TEST_ASSERT_EQUAL_HEX8(KEY_ENTER, run.reports[run.reports_n - 2].report.keys[0]);
+    TEST_ASSERT_NOT_NULL(strstr((const char*)run.output, "too many nested blocks"));
+    native_run_free(&run);
+}
+
+// Link bytes saved by macros and loops, with the same reports as the expanded script
+void test_macros_bench_link_bytes(void)
+{
+    static char macro_input[SCRIPT_SIZE];
+    static char expanded_input[SCRIPT_SIZE];
+    const t_bench_script* script = NULL;
+    t_native_run macro_run;
+    t_native_run expanded_run;
+    size_t macro_len = 0;
+    size_t expanded_len = 0;
+
+    printf("\nMacros link bytes at %u bauds:\n", LINK_BAUDS);
+    printf("%-8s %10s %10s %8s %12s %12s\n", "script", "expanded", "macros", "saved", "expanded ms",
+        "macros ms");
+    for(size_t i = 0; i < sizeof(BENCH_SCRIPTS)/sizeof(BENCH_SCRIPTS[0]); i++)
+    {
+        script = &(BENCH_SCRIPTS[i]);
+        macro_len = snprintf(macro_input, sizeof(macro_input), "DEFAULT_DELAY 0\n%s",
+            script->macros);
+        expanded_len = snprintf(expanded_input, sizeof(expanded_input), "DEFAULT_DELAY 0\n");
+        for(uint16_t r = 0; r < script->repeats; r++)
+        {
+            expanded_len = expanded_len + snprintf(&(expanded_input[expanded_len]),
+                sizeof(expanded_input) - expanded_len, "%s", script->line);
+        }
+        TEST_ASSERT_LESS_THAN(sizeof(expanded_input), expanded_len);
+
+        run_input(macro_input, LINK_BAUDS, &macro_run);
+        run_input(expanded_input, LINK_BAUDS, &expanded_run);
+        assert_same_reports(&expanded_run, &macro_run);
+        TEST_ASSERT_LESS_THAN(expanded_len, macro_len);
+
+        printf("%-8s %10u %10u %7.1f%% %12.1f %12.1f\n", script->name, (unsigned)expanded_len,
+            (unsigned)macro_len, 100.0 * (expanded_len - macro_len) / expanded_len,
+            last_report_ms(&expanded_run), last_report_ms(&macro_run));
+        native_run_free(&macro_run);
+        native_run_free(&expanded_run);
+    }
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_macros_replay);
+    RUN_TEST(test_macros_arena_full);
+    RUN_TEST(test_macros_redefine);
+    RUN_TEST(test_macros_nesting_overflow);
+    RUN_TEST(test_macros_firmware_discard);
+    RUN_TEST(test_macros_bench_link_bytes);
+    return UNITY_END();
+}
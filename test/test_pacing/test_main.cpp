@@ -0,0 +1,165 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_pacing                                                                                */
+/* Description:                                                                                   */
+/*     Adaptive keystrokes pacing tests (native): probes are echoed by the simulated host LEDs    */
+/*     output reports with different report times, the estimated round trip and the delay         */
+/*     between characters converge to them, and the probe LED original state is restored.         */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include <HID-Project.h>
+#include "pacing.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Maximum wait for the host of the tests (ms)
+#define PACING_MAX_MS 100
+
+// Time step while waiting for a probe echo (us), as the main loop polls it
+#define POLL_STEP_US 50
+
+// Probes sent until the round trip estimate converges
+#define CONVERGE_PROBES 20
+
+// Allowed round trip estimate error (us)
+#define RTT_TOLERANCE_US (2 * POLL_STEP_US)
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Simulated host times to process each report (us)
+// A probe press waits for the release of the previous probe, so its round trip is twice the time
+static const uint32_t HOST_REPORT_US[] = { 750, 2000, 6000, 20000 };
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+static t_pacing pacing;
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Sent reports hook (reports are not recorded)
+static void report_hook(const t_native_hid_report* report, const uint32_t us) {}
+
+// Send a probe and wait for its echo (or its maximum wait), returns the time waited (us)
+static uint32_t probe_wait(void)
+{
+    uint32_t start = micros();
+
+    pacing_probe(&pacing);
+    while(!pacing_probe_done(&pacing))
+        delayMicroseconds(POLL_STEP_US);
+
+    return micros() - start;
+}
+
+// Let the simulated host process every report sent
+static void host_drain(void)
+{
+    delay(PACING_MAX_MS * 2);
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+void setUp(void)
+{
+    memset(&pacing, 0, sizeof(pacing));
+    native_hid_set_host(0);
+    host_drain();
+}
+
+void tearDown(void)
+{
+    native_hid_set_host(0);
+    host_drain();
+}
+
+// Round trip estimate and delay between characters converge to each host round trip time, also
+// when it changes
+void test_pacing_converges(void)
+{
+    uint32_t rtt_us = 0;
+
+    pacing_enable(&pacing, PACING_MAX_MS);
+    for(uint8_t i = 0; i < sizeof(HOST_REPORT_US)/sizeof(HOST_REPORT_US[0]); i++)
+    {
+        rtt_us = 2 * HOST_REPORT_US[i];
+        native_hid_set_host(HOST_REPORT_US[i]);
+        for(uint8_t p = 0; p < CONVERGE_PROBES; p++)
+            probe_wait();
+
+        TEST_ASSERT_UINT32_WITHIN(RTT_TOLERANCE_US, rtt_us, pacing.rtt_us);
+        TEST_ASSERT_UINT32_WITHIN(1, (rtt_us + 999) / 1000,
+            pacing_char_delay(&pacing, PACING_MAX_MS));
+    }
+
+    // Bounded by the maximum delay, and by the minimum probe wait for an immediate host
+    TEST_ASSERT_EQUAL_UINT32(20, pacing_char_delay(&pacing, 20));
+    native_hid_set_host(0);
+    for(uint8_t p = 0; p < 2 * CONVERGE_PROBES; p++)
+        probe_wait();
+    TEST_ASSERT_UINT32_WITHIN(RTT_TOLERANCE_US, PACING_MIN_MS * 1000UL, pacing.rtt_us);
+    TEST_ASSERT_UINT32_WITHIN(1, PACING_MIN_MS, pacing_char_delay(&pacing, PACING_MAX_MS));
+}
+
+// A host slower than the maximum wait paces at the maximum wait, and an estimate is only used
+// once adaptive pacing is enabled
+void test_pacing_timeout(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(PACING_MAX_MS, pacing_char_delay(&pacing, PACING_MAX_MS));
+
+    pacing_enable(&pacing, 10);
+    native_hid_set_host(50000);
+    for(uint8_t p = 0; p < 4; p++)
+        TEST_ASSERT_UINT32_WITHIN(POLL_STEP_US, 10000, probe_wait());
+    TEST_ASSERT_EQUAL_UINT32(10, pacing_char_delay(&pacing, PACING_MAX_MS));
+
+    pacing_enable(&pacing, 0);
+    TEST_ASSERT_EQUAL_UINT32(PACING_MAX_MS, pacing_char_delay(&pacing, PACING_MAX_MS));
+}
+
+// Once idle, the probe LED gets back to its state before the first probe
+void test_pacing_restore(void)
+{
+    uint8_t leds = Keyboard.getLeds();
+
+    pacing_enable(&pacing, PACING_MAX_MS);
+    native_hid_set_host(3000);
+    for(uint8_t p = 0; p < 3; p++)
+        probe_wait();
+    TEST_ASSERT_NOT_EQUAL(leds & PACING_PROBE_LED, Keyboard.getLeds() & PACING_PROBE_LED);
+
+    while(pacing.probed)
+    {
+        pacing_idle(&pacing);
+        delayMicroseconds(POLL_STEP_US);
+    }
+    TEST_ASSERT_EQUAL_HEX8(leds, Keyboard.getLeds());
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    native_virtual_time();
+    native_hid_set_hook(report_hook);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_pacing_converges);
+    RUN_TEST(test_pacing_timeout);
+    RUN_TEST(test_pacing_restore);
+    return UNITY_END();
+}
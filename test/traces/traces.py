@@ -0,0 +1,22 @@
+# PlatformIO extra script of the native environment: HID reports traces targets
+# pio run -e native -t traces: Check test/traces scripts traces against the golden ones
+# pio run -e native -t traces-update: Record the golden traces again (intended output changes)
+
+Import("env")
+
+program = "$BUILD_DIR/${PROGNAME}${PROGSUFFIX}"
+run_script = "$PROJECT_DIR/test/traces/run.sh"
+
+env.AddCustomTarget(
+    name="traces",
+    dependencies=program,
+    actions="sh %s %s" % (run_script, program),
+    title="HID traces",
+    description="Compare test/traces scripts HID reports against their golden traces")
+
+env.AddCustomTarget(
+    name="traces-update",
+    dependencies=program,
+    actions="sh %s -u %s" % (run_script, program),
+    title="HID traces update",
+    description="Record test/traces golden traces with the current firmware")
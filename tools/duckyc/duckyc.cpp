@@ -0,0 +1,146 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckyc                                                                                     */
+/* Description:                                                                                   */
+/*     Host (Linux) compiler of Ducky Script text files into the device bytecode format.          */
+/* Build:                                                                                         */
+/*     g++ -std=gnu++11 -Isrc -Ilib/ArduinoNative/src tools/duckyc/duckyc.cpp src/duckykeys.cpp   */
+/*         src/duckyparser.cpp src/duckybytecode.cpp -o duckyc                                    */
+/* Usage:                                                                                         */
+/*     duckyc script.txt [output.bin]                                                             */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "duckyparser.h"
+#include "duckybytecode.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Device line reception buffer size (bytecode commands must fit in it)
+#define DEVICE_RX_LINE_SIZE SERIAL_RX_BUFFER_SIZE
+
+// Maximum length of script lines read
+#define MAX_LINE_LENGTH 1024
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Compile a script file into bytecode
+int compile_script(FILE* in, FILE* out);
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char* argv[])
+{
+    FILE* in = NULL;
+    FILE* out = stdout;
+    int rc = 0;
+
+    if((argc < 2) || (argc > 3))
+    {
+        fprintf(stderr, "Usage: %s script.txt [output.bin]\n", argv[0]);
+        return 1;
+    }
+
+    in = fopen(argv[1], "r");
+    if(in == NULL)
+    {
+        fprintf(stderr, "Error: Can't open input file %s\n", argv[1]);
+        return 1;
+    }
+
+    if(argc == 3)
+    {
+        out = fopen(argv[2], "wb");
+        if(out == NULL)
+        {
+            fprintf(stderr, "Error: Can't open output file %s\n", argv[2]);
+            fclose(in);
+            return 1;
+        }
+    }
+
+    rc = compile_script(in, out);
+
+    fclose(in);
+    if(out != stdout)
+        fclose(out);
+
+    return rc;
+}
+
+/**************************************************************************************************/
+
+/* Compiler Functions */
+
+// Compile a script file into bytecode
+// Comment lines are not encoded. Bytes on wire statistics are written to stderr
+int compile_script(FILE* in, FILE* out)
+{
+    char line[MAX_LINE_LENGTH];
+    uint8_t code[DUCKY_BYTECODE_MAX_SIZE];
+    t_ducky_line parsed;
+    t_ducky_cmd cmd;
+    uint32_t line_num = 0;
+    uint32_t commands = 0;
+    uint32_t text_bytes = 0;
+    uint32_t code_bytes = 0;
+    uint16_t code_len = 0;
+    size_t len = 0;
+
+    while(fgets(line, sizeof(line), in) != NULL)
+    {
+        line_num = line_num + 1;
+        len = strlen(line);
+        text_bytes = text_bytes + len;
+
+        // Remove end of line characters
+        while((len > 0) && ((line[len-1] == '\n') || (line[len-1] == '\r')))
+            len = len - 1;
+        line[len] = '\0';
+
+        if(len >= DEVICE_RX_LINE_SIZE)
+        {
+            fprintf(stderr, "Error: Line %u too long for the device\n", line_num);
+            return 1;
+        }
+
+        // Ignore empty and comment lines
+        if(ducky_parse_line(line, len, &parsed) != RC_OK)
+            continue;
+        if(parsed.cmd == CMD_REM)
+            continue;
+
+        if(ducky_compile(&parsed, &cmd) != RC_OK)
+        {
+            fprintf(stderr, "Error: Invalid command at line %u: %s\n", line_num, line);
+            return 1;
+        }
+
+        code_len = ducky_bytecode_encode(&cmd, code, DEVICE_RX_LINE_SIZE);
+        if(code_len == 0)
+        {
+            fprintf(stderr, "Error: Command at line %u can't be encoded\n", line_num);
+            return 1;
+        }
+
+        fwrite(code, 1, code_len, out);
+        commands = commands + 1;
+        code_bytes = code_bytes + code_len;
+    }
+
+    fprintf(stderr, "Commands: %u\n", commands);
+    fprintf(stderr, "Text bytes: %u\n", text_bytes);
+    fprintf(stderr, "Bytecode bytes: %u\n", code_bytes);
+    if(code_bytes > 0)
+        fprintf(stderr, "Reduction: %.2fx\n", (double)text_bytes / code_bytes);
+
+    return 0;
+}
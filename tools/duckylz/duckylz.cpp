@@ -0,0 +1,306 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckylz                                                                                    */
+/* Description:                                                                                   */
+/*     Host (Linux) encoder of Ducky Script text files into device compressed lines. Every line   */
+/*     is checked by decoding it with the device decoder, and compression statistics are written  */
+/*     to stderr.                                                                                 */
+/* Build:                                                                                         */
+/*     g++ -std=gnu++11 -O2 -Isrc -Ilib/ArduinoNative/src tools/duckylz/duckylz.cpp               */
+/*         src/duckylz.cpp -o duckylz                                                             */
+/* Usage:                                                                                         */
+/*     duckylz script.txt [output.bin]                                                            */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include <time.h>
+#include "duckylz.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Device line reception buffer size (decoded lines must fit in it)
+#define DEVICE_RX_LINE_SIZE SERIAL_RX_BUFFER_SIZE
+
+// Maximum length of script lines read
+#define MAX_LINE_LENGTH 1024
+
+// Maximum size of the encoded script kept to measure decoding time
+#define MAX_ENCODED_SIZE (1024 * 1024)
+
+// Serial link bits per byte (start, 8 data and stop bits) and bauds
+#define LINK_BITS_PER_BYTE 10
+#define LINK_BAUDS 19200
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Encoder state (mirrors decoder history)
+typedef struct
+{
+    char history[LZ_WINDOW_SIZE];
+    uint8_t history_len;
+    char dict[LZ_DICT_MAX_ENTRIES][LZ_REF_MAX_LENGTH];
+    uint8_t dict_len[LZ_DICT_MAX_ENTRIES];
+    uint8_t dict_n;
+} t_encoder;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Encode a script file into compressed lines
+int encode_script(FILE* in, FILE* out);
+
+// Encode a text line into a compressed line, returns encoded size
+uint16_t encode_line(t_encoder* enc, const char* line, const uint16_t len, uint8_t* code);
+
+// Get the average time to decode encoded data with the device decoder (ns per encoded byte)
+double decode_time(const uint8_t* code, const uint32_t code_len);
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+// Left out with DUCKYLZ_NO_MAIN, so the encoder can be built into a test program
+#ifndef DUCKYLZ_NO_MAIN
+int main(int argc, char* argv[])
+{
+    FILE* in = NULL;
+    FILE* out = stdout;
+    int rc = 0;
+
+    if((argc < 2) || (argc > 3))
+    {
+        fprintf(stderr, "Usage: %s script.txt [output.bin]\n", argv[0]);
+        return 1;
+    }
+
+    in = fopen(argv[1], "r");
+    if(in == NULL)
+    {
+        fprintf(stderr, "Error: Can't open input file %s\n", argv[1]);
+        return 1;
+    }
+
+    if(argc == 3)
+    {
+        out = fopen(argv[2], "wb");
+        if(out == NULL)
+        {
+            fprintf(stderr, "Error: Can't open output file %s\n", argv[2]);
+            fclose(in);
+            return 1;
+        }
+    }
+
+    rc = encode_script(in, out);
+
+    fclose(in);
+    if(out != stdout)
+        fclose(out);
+
+    return rc;
+}
+#endif
+
+/**************************************************************************************************/
+
+/* Encoder Functions */
+
+// Encode a script file into compressed lines
+// Comment and empty lines are not encoded. Each encoded line is decoded back with the device
+// decoder to check it
+int encode_script(FILE* in, FILE* out)
+{
+    static t_encoder enc;
+    static t_lz_state lz;
+    static uint8_t encoded[MAX_ENCODED_SIZE];
+    char line[MAX_LINE_LENGTH];
+    char decoded[DEVICE_RX_LINE_SIZE];
+    uint8_t code[2 * MAX_LINE_LENGTH];
+    uint32_t line_num = 0;
+    uint32_t text_bytes = 0;
+    uint32_t code_bytes = 0;
+    uint16_t code_len = 0;
+    uint16_t decoded_len = 0;
+    size_t len = 0;
+
+    for(uint8_t i = 0; i < LZ_DICT_MAX_ENTRIES; i++)
+        enc.dict_len[i] = ducky_lz_dict_entry(i, enc.dict[i]);
+    enc.dict_n = ducky_lz_dict_entries();
+
+    while(fgets(line, sizeof(line), in) != NULL)
+    {
+        line_num = line_num + 1;
+        len = strlen(line);
+        text_bytes = text_bytes + len;
+
+        // Remove end of line characters
+        while((len > 0) && ((line[len-1] == '\n') || (line[len-1] == '\r')))
+            len = len - 1;
+        line[len] = '\0';
+
+        // Ignore empty and comment lines
+        while((len > 0) && (line[0] == ' '))
+            memmove(line, line + 1, len--);
+        if((len == 0) || (strncmp(line, "REM", 3) == 0) || (strncmp(line, "//", 2) == 0))
+            continue;
+
+        if(len >= DEVICE_RX_LINE_SIZE)
+        {
+            fprintf(stderr, "Error: Line %u too long for the device\n", line_num);
+            return 1;
+        }
+        for(size_t i = 0; i < len; i++)
+        {
+            if((uint8_t)line[i] >= LZ_DICT_TOKEN)
+            {
+                fprintf(stderr, "Error: Non ASCII character at line %u\n", line_num);
+                return 1;
+            }
+        }
+
+        code_len = encode_line(&enc, line, len, code);
+
+        // Check it with the device decoder
+        decoded_len = 0;
+        for(uint16_t i = 1; i < code_len - 1; i++)
+            decoded_len = ducky_lz_decode(&lz, code[i], decoded, decoded_len, sizeof(decoded));
+        if((decoded_len != len) || (memcmp(decoded, line, len) != 0))
+        {
+            fprintf(stderr, "Error: Line %u can't be decoded back\n", line_num);
+            return 1;
+        }
+
+        fwrite(code, 1, code_len, out);
+        if(code_bytes + code_len <= MAX_ENCODED_SIZE)
+            memcpy(&(encoded[code_bytes]), code, code_len);
+        code_bytes = code_bytes + code_len;
+    }
+
+    fprintf(stderr, "Text bytes: %u\n", text_bytes);
+    fprintf(stderr, "Compressed bytes: %u\n", code_bytes);
+    if(code_bytes == 0)
+        return 0;
+    fprintf(stderr, "Compression ratio: %.2fx\n", (double)text_bytes / code_bytes);
+    fprintf(stderr, "Transfer time at %u bauds: %.2f s -> %.2f s\n", LINK_BAUDS,
+        (double)text_bytes * LINK_BITS_PER_BYTE / LINK_BAUDS,
+        (double)code_bytes * LINK_BITS_PER_BYTE / LINK_BAUDS);
+    if(code_bytes <= MAX_ENCODED_SIZE)
+        fprintf(stderr, "Host decode time: %.1f ns/byte\n", decode_time(encoded, code_bytes));
+
+    return 0;
+}
+
+// Encode a text line into a compressed line, returns encoded size
+// Greedy encoding: at each position, the dictionary entry or back-reference that saves more bytes
+// is used, or a literal if none of them saves any
+uint16_t encode_line(t_encoder* enc, const char* line, const uint16_t len, uint8_t* code)
+{
+    char stream[LZ_WINDOW_SIZE + MAX_LINE_LENGTH];
+    uint16_t start = enc->history_len;
+    uint16_t code_len = 0;
+    uint16_t pos = 0;
+    uint16_t l = 0;
+    int16_t gain = 0;
+    int16_t best_gain = 0;
+    uint8_t best_token = 0;
+    uint8_t best_distance = 0;
+    uint8_t best_len = 0;
+
+    // Decoded characters, history followed by the line
+    memcpy(stream, enc->history, enc->history_len);
+    memcpy(&(stream[start]), line, len);
+
+    code[code_len++] = LZ_LINE_MARK;
+    while(pos < len)
+    {
+        best_gain = 0;
+
+        // Dictionary entries
+        for(uint8_t i = 0; i < enc->dict_n; i++)
+        {
+            l = enc->dict_len[i];
+            if((l > len - pos) || (memcmp(&(line[pos]), enc->dict[i], l) != 0))
+                continue;
+            gain = l - 1;
+            if(gain > best_gain)
+            {
+                best_gain = gain;
+                best_token = LZ_DICT_TOKEN | i;
+                best_len = l;
+            }
+        }
+
+        // Back-references (may overlap the characters being decoded)
+        for(uint16_t d = 1; (d <= LZ_WINDOW_SIZE) && (d <= start + pos); d++)
+        {
+            l = 0;
+            while((pos + l < len) && (l < LZ_REF_MAX_LENGTH) &&
+                  (stream[start + pos + l - d] == stream[start + pos + l]))
+                l = l + 1;
+            if(l < LZ_REF_MIN_LENGTH)
+                continue;
+            gain = l - 2;
+            if(gain > best_gain)
+            {
+                best_gain = gain;
+                best_token = LZ_REF_TOKEN | (l - LZ_REF_MIN_LENGTH);
+                best_distance = LZ_DICT_TOKEN | (d - 1);
+                best_len = l;
+            }
+        }
+
+        if(best_gain <= 0)
+        {
+            code[code_len++] = (uint8_t)line[pos];
+            pos = pos + 1;
+            continue;
+        }
+        code[code_len++] = best_token;
+        if((best_token & LZ_TOKEN_MASK) == LZ_REF_TOKEN)
+            code[code_len++] = best_distance;
+        pos = pos + best_len;
+    }
+    code[code_len++] = '\n';
+
+    // Keep last decoded characters as history
+    l = start + len;
+    enc->history_len = (l < LZ_WINDOW_SIZE) ? l : LZ_WINDOW_SIZE;
+    memcpy(enc->history, &(stream[l - enc->history_len]), enc->history_len);
+
+    return code_len;
+}
+
+// Get the average time to decode encoded data with the device decoder (ns per encoded byte)
+double decode_time(const uint8_t* code, const uint32_t code_len)
+{
+    static t_lz_state lz;
+    char line[DEVICE_RX_LINE_SIZE];
+    uint16_t line_len = 0;
+    uint32_t runs = 0;
+    clock_t start = clock();
+    clock_t elapsed = 0;
+
+    do
+    {
+        for(uint32_t i = 0; i < code_len; i++)
+        {
+            if((code[i] == LZ_LINE_MARK) || (code[i] == '\n'))
+            {
+                line_len = 0;
+                continue;
+            }
+            line_len = ducky_lz_decode(&lz, code[i], line, line_len, sizeof(line));
+        }
+        runs = runs + 1;
+        elapsed = clock() - start;
+    } while(elapsed < CLOCKS_PER_SEC / 5);
+
+    return (1e9 * elapsed / CLOCKS_PER_SEC) / ((double)runs * code_len);
+}
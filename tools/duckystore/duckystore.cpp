@@ -0,0 +1,175 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckystore                                                                                 */
+/* Description:                                                                                   */
+/*     Host (Linux) builder of device EEPROM script images. It compiles a Ducky Script text file  */
+/*     into the upload stream to store it in the device (STORE, bytecode commands and END) and,   */
+/*     optionally, into a raw EEPROM image (i.e. to be used as native build NATIVE_EEPROM file).  */
+/* Build:                                                                                         */
+/*     g++ -std=gnu++11 -Isrc -Ilib/ArduinoNative/src tools/duckystore/duckystore.cpp             */
+/*         src/duckykeys.cpp src/duckyparser.cpp src/duckybytecode.cpp -o duckystore              */
+/* Usage:                                                                                         */
+/*     duckystore [-b] script.txt upload.bin [eeprom.bin]                                         */
+/*     (-b: Replay the script at device boot)                                                     */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "duckyparser.h"
+#include "duckybytecode.h"
+#include "scriptstore.h"
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Device line reception buffer size (bytecode commands must fit in it)
+#define DEVICE_RX_LINE_SIZE SERIAL_RX_BUFFER_SIZE
+
+// Maximum length of script lines read
+#define MAX_LINE_LENGTH 1024
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Compile a script file into an EEPROM image
+int build_image(FILE* in, uint8_t* image, const uint8_t flags);
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char* argv[])
+{
+    uint8_t image[STORE_EEPROM_SIZE];
+    uint16_t length = 0;
+    uint8_t flags = 0;
+    int arg = 1;
+    FILE* in = NULL;
+    FILE* out = NULL;
+
+    if((argc > 1) && (strcmp(argv[1], "-b") == 0))
+    {
+        flags = STORE_FLAG_BOOT;
+        arg = arg + 1;
+    }
+    if((argc - arg < 2) || (argc - arg > 3))
+    {
+        fprintf(stderr, "Usage: %s [-b] script.txt upload.bin [eeprom.bin]\n", argv[0]);
+        return 1;
+    }
+
+    in = fopen(argv[arg], "r");
+    if(in == NULL)
+    {
+        fprintf(stderr, "Error: Can't open input file %s\n", argv[arg]);
+        return 1;
+    }
+    memset(image, 0xFF, sizeof(image));
+    if(build_image(in, image, flags) != 0)
+    {
+        fclose(in);
+        return 1;
+    }
+    fclose(in);
+    length = image[3] | (image[4] << 8);
+
+    // Upload stream
+    out = fopen(argv[arg+1], "wb");
+    if(out == NULL)
+    {
+        fprintf(stderr, "Error: Can't open output file %s\n", argv[arg+1]);
+        return 1;
+    }
+    fputs((flags & STORE_FLAG_BOOT) ? "STORE_BOOT\n" : "STORE\n", out);
+    fwrite(&(image[STORE_HEADER_SIZE]), 1, length, out);
+    fputs("END\n", out);
+    fclose(out);
+
+    // Raw EEPROM image
+    if(argc - arg == 3)
+    {
+        out = fopen(argv[arg+2], "wb");
+        if(out == NULL)
+        {
+            fprintf(stderr, "Error: Can't open output file %s\n", argv[arg+2]);
+            return 1;
+        }
+        fwrite(image, 1, sizeof(image), out);
+        fclose(out);
+    }
+
+    return 0;
+}
+
+/**************************************************************************************************/
+
+/* Image Functions */
+
+// Compile a script file into an EEPROM image
+// Comment lines are not stored. Image size statistics are written to stderr
+int build_image(FILE* in, uint8_t* image, const uint8_t flags)
+{
+    char line[MAX_LINE_LENGTH];
+    t_ducky_line parsed;
+    t_ducky_cmd cmd;
+    uint32_t line_num = 0;
+    uint32_t commands = 0;
+    uint16_t length = 0;
+    uint16_t code_len = 0;
+    size_t len = 0;
+
+    while(fgets(line, sizeof(line), in) != NULL)
+    {
+        line_num = line_num + 1;
+        len = strlen(line);
+
+        // Remove end of line characters
+        while((len > 0) && ((line[len-1] == '\n') || (line[len-1] == '\r')))
+            len = len - 1;
+        line[len] = '\0';
+
+        if(len >= DEVICE_RX_LINE_SIZE)
+        {
+            fprintf(stderr, "Error: Line %u too long for the device\n", line_num);
+            return 1;
+        }
+
+        // Ignore empty and comment lines
+        if(ducky_parse_line(line, len, &parsed) != RC_OK)
+            continue;
+        if(parsed.cmd == CMD_REM)
+            continue;
+
+        if((ducky_compile(&parsed, &cmd) != RC_OK) || ducky_cmd_is_control(cmd.cmd))
+        {
+            fprintf(stderr, "Error: Invalid command at line %u: %s\n", line_num, line);
+            return 1;
+        }
+
+        code_len = ducky_bytecode_encode(&cmd, &(image[STORE_HEADER_SIZE + length]),
+            STORE_CAPACITY - length);
+        if(code_len == 0)
+        {
+            fprintf(stderr, "Error: Script doesn't fit in the store (line %u)\n", line_num);
+            return 1;
+        }
+
+        commands = commands + 1;
+        length = length + code_len;
+    }
+
+    image[0] = STORE_MAGIC_0;
+    image[1] = STORE_MAGIC_1;
+    image[2] = flags;
+    image[3] = length & 0xFF;
+    image[4] = length >> 8;
+
+    fprintf(stderr, "Commands: %u\n", commands);
+    fprintf(stderr, "Image bytes: %u / %u (%.1f%%)\n", STORE_HEADER_SIZE + length,
+        STORE_EEPROM_SIZE, (100.0 * (STORE_HEADER_SIZE + length)) / STORE_EEPROM_SIZE);
+
+    return 0;
+}
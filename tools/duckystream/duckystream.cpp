@@ -0,0 +1,717 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     duckystream                                                                                */
+/* Description:                                                                                   */
+/*     Host (Linux) streaming client. It sends a Ducky Script text file to the device as framed   */
+/*     lines (REM and empty lines removed), keeping a bounded window of frames waiting for their  */
+/*     acknowledgment (a rejected or unacknowledged frame is resent with all the ones after it),  */
+/*     and reports lines and bytes throughput and acknowledgment latencies. The device can be a   */
+/*     serial port or a command (i.e. the native build) run on a pseudo-terminal.                 */
+/* Build:                                                                                         */
+/*     g++ -std=gnu++11 -O2 -Isrc -Ilib/ArduinoNative/src tools/duckystream/duckystream.cpp       */
+/*         src/serialrx.cpp src/duckylz.cpp src/duckybytecode.cpp src/duckyparser.cpp             */
+/*         src/duckykeys.cpp -o duckystream                                                       */
+/* Usage:                                                                                         */
+/*     duckystream [-w window] [-t timeout_ms] [-b bauds] -d /dev/ttyACM0 script.txt              */
+/*     duckystream [-w window] [-t timeout_ms] -e ".pio/build/native/program" script.txt          */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <Arduino.h>
+#include "serialrx.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Device frame payload maximum size (longer lines are sent as plain text lines)
+#define FRAME_PAYLOAD_MAX (RX_LINE_SIZE - 1)
+
+// Frame bytes besides the payload (sync, type, sequence, length and CRC)
+#define FRAME_OVERHEAD 6
+
+// Default number of frames waiting for acknowledgment (device commands queue depth)
+#define DEFAULT_WINDOW 4
+
+// Maximum number of frames waiting for acknowledgment
+#define MAX_WINDOW 32
+
+// Default time to wait for the acknowledgment of the oldest sent frame (ms)
+#define DEFAULT_TIMEOUT_MS 10000
+
+// Default serial port bauds
+#define DEFAULT_BAUDS 19200
+
+// Resend attempts of a frame rejected or without acknowledgment
+#define MAX_RESENDS 3
+
+// Plain text lines are written in chunks of this size, so a device XOFF is handled while writing
+#define TEXT_CHUNK 16
+
+// Maximum length of script lines read
+#define MAX_LINE_LENGTH 1024
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Script line to be sent
+typedef struct
+{
+    char* text;
+    uint16_t len;
+} t_line;
+
+// Frame waiting for acknowledgment
+typedef struct
+{
+    uint32_t line;      // Script line index
+    uint8_t seq;
+    uint8_t resends;
+    uint64_t sent_us;
+} t_inflight;
+
+// Streaming state
+typedef struct
+{
+    int fd;
+    uint32_t lines_n;   // Script lines
+    uint32_t window;
+    uint32_t timeout_ms;
+    t_inflight inflight[MAX_WINDOW];
+    uint32_t inflight_head;
+    uint32_t inflight_n;
+    uint8_t next_seq;
+    bool paused;        // Device sent XOFF
+    uint64_t paused_us; // Time of the XOFF
+    uint8_t reply;      // ACK/NAK waiting for its sequence byte (0 if none)
+    bool go_back;       // A frame has been rejected, frames in flight have to be resent
+    bool recovering;    // Frames in flight have been resent, until the oldest one is acknowledged
+    uint32_t* latencies_us;
+    uint32_t acked;
+    uint64_t bytes;
+    uint32_t naks;
+    uint32_t resends;
+} t_stream;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Load the lines of a script file to be sent, without REM and empty lines
+int load_script(const char* path, t_line** lines, uint32_t* n, uint32_t* skipped);
+
+// Open and configure a serial port (raw mode, no flow control)
+int open_serial(const char* path, const uint32_t bauds);
+
+// Run a command with its stdin and stdout on a pseudo-terminal, returns the master side
+int open_command(const char* command, pid_t* pid);
+
+// Send all the script lines, returns 0 once all of them have been acknowledged
+int stream_script(t_stream* stream, const t_line* lines, const uint32_t n);
+
+// Send a data frame with a script line (or an empty one) and add it to the frames in flight
+int send_frame(t_stream* stream, const t_line* lines, const uint32_t index);
+
+// Resend all the frames in flight, starting with the oldest one
+int go_back(t_stream* stream, const t_line* lines);
+
+// Write a data frame with a script line (or an empty one, for a line too long for a frame)
+int write_frame(t_stream* stream, const t_line* line, const uint8_t seq);
+
+// Write a plain text line in chunks, waiting while the device has sent XOFF
+int write_text(t_stream* stream, const t_line* line);
+
+// Wait for received bytes up to a time and handle them
+int poll_device(t_stream* stream, const int timeout_ms);
+
+// Handle received bytes (acknowledgments and flow control)
+int receive(t_stream* stream);
+
+// Write the streaming results
+void print_results(const t_stream* stream, const uint32_t lines, const uint32_t skipped,
+    const uint64_t elapsed_us);
+
+// Get a monotonic time (us)
+uint64_t now_us(void);
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char* argv[])
+{
+    t_stream stream;
+    t_line* lines = NULL;
+    uint32_t n = 0;
+    uint32_t skipped = 0;
+    uint32_t bauds = DEFAULT_BAUDS;
+    const char* device = NULL;
+    const char* command = NULL;
+    pid_t pid = -1;
+    uint64_t start_us = 0;
+    uint64_t elapsed_us = 0;
+    int rc = 0;
+    int arg = 1;
+
+    memset(&stream, 0, sizeof(stream));
+    stream.window = DEFAULT_WINDOW;
+    stream.timeout_ms = DEFAULT_TIMEOUT_MS;
+
+    while((arg + 1 < argc) && (argv[arg][0] == '-'))
+    {
+        if(strcmp(argv[arg], "-w") == 0)
+            stream.window = strtoul(argv[arg+1], NULL, 10);
+        else if(strcmp(argv[arg], "-t") == 0)
+            stream.timeout_ms = strtoul(argv[arg+1], NULL, 10);
+        else if(strcmp(argv[arg], "-b") == 0)
+            bauds = strtoul(argv[arg+1], NULL, 10);
+        else if(strcmp(argv[arg], "-d") == 0)
+            device = argv[arg+1];
+        else if(strcmp(argv[arg], "-e") == 0)
+            command = argv[arg+1];
+        else
+            break;
+        arg = arg + 2;
+    }
+    if((argc - arg != 1) || ((device == NULL) == (command == NULL)) || (stream.window == 0) ||
+       (stream.window > MAX_WINDOW))
+    {
+        fprintf(stderr, "Usage: %s [-w window] [-t timeout_ms] [-b bauds] "
+            "(-d serial_port | -e command) script.txt\n", argv[0]);
+        fprintf(stderr, "  (window: 1 to %u frames, %u by default)\n", MAX_WINDOW,
+            DEFAULT_WINDOW);
+        return 1;
+    }
+
+    if(load_script(argv[arg], &lines, &n, &skipped) != 0)
+        return 1;
+    stream.latencies_us = (uint32_t*)malloc((n + 1) * sizeof(uint32_t));
+    if(stream.latencies_us == NULL)
+    {
+        fprintf(stderr, "Error: Not enough memory\n");
+        return 1;
+    }
+
+    if(device != NULL)
+        stream.fd = open_serial(device, bauds);
+    else
+        stream.fd = open_command(command, &pid);
+    if(stream.fd < 0)
+        return 1;
+
+    start_us = now_us();
+    rc = stream_script(&stream, lines, n);
+    elapsed_us = now_us() - start_us;
+
+    // Let the command end (it exits once its input is closed and it is idle)
+    close(stream.fd);
+    if(pid > 0)
+        waitpid(pid, NULL, 0);
+
+    print_results(&stream, n, skipped, elapsed_us);
+
+    for(uint32_t i = 0; i < n; i++)
+        free(lines[i].text);
+    free(lines);
+    free(stream.latencies_us);
+
+    return rc;
+}
+
+/**************************************************************************************************/
+
+/* Script Functions */
+
+// Load the lines of a script file to be sent, without REM and empty lines
+int load_script(const char* path, t_line** lines, uint32_t* n, uint32_t* skipped)
+{
+    FILE* in = NULL;
+    char line[MAX_LINE_LENGTH];
+    t_ducky_line parsed;
+    t_line* grown = NULL;
+    uint32_t capacity = 0;
+    size_t len = 0;
+
+    in = fopen(path, "r");
+    if(in == NULL)
+    {
+        fprintf(stderr, "Error: Can't open input file %s\n", path);
+        return 1;
+    }
+
+    while(fgets(line, sizeof(line), in) != NULL)
+    {
+        // Remove end of line characters
+        len = strlen(line);
+        while((len > 0) && ((line[len-1] == '\n') || (line[len-1] == '\r')))
+            len = len - 1;
+        line[len] = '\0';
+
+        // Ignore empty and comment lines
+        if((ducky_parse_line(line, len, &parsed) != RC_OK) || (parsed.cmd == CMD_REM))
+        {
+            *skipped = *skipped + 1;
+            continue;
+        }
+
+        if(*n == capacity)
+        {
+            capacity = (capacity == 0) ? 256 : capacity * 2;
+            grown = (t_line*)realloc(*lines, capacity * sizeof(t_line));
+            if(grown == NULL)
+            {
+                fprintf(stderr, "Error: Not enough memory for script %s\n", path);
+                fclose(in);
+                return 1;
+            }
+            *lines = grown;
+        }
+        (*lines)[*n].text = strdup(line);
+        (*lines)[*n].len = len;
+        *n = *n + 1;
+    }
+
+    fclose(in);
+
+    return 0;
+}
+
+/**************************************************************************************************/
+
+/* Device Functions */
+
+// Get the termios speed of a bauds rate (B0 if it is not supported)
+static speed_t bauds_to_speed(const uint32_t bauds)
+{
+    switch(bauds)
+    {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        default: return B0;
+    }
+}
+
+// Open and configure a serial port (raw mode, no flow control)
+// XON/XOFF sent by the device are handled by the client, the line discipline must not take them
+int open_serial(const char* path, const uint32_t bauds)
+{
+    struct termios tty;
+    speed_t speed = bauds_to_speed(bauds);
+    int fd = -1;
+
+    if(speed == B0)
+    {
+        fprintf(stderr, "Error: Unsupported bauds %u\n", bauds);
+        return -1;
+    }
+
+    fd = open(path, O_RDWR | O_NOCTTY);
+    if((fd < 0) || (tcgetattr(fd, &tty) != 0))
+    {
+        fprintf(stderr, "Error: Can't open serial port %s\n", path);
+        if(fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    cfmakeraw(&tty);
+    tty.c_cflag = tty.c_cflag | CLOCAL | CREAD;
+    tty.c_cflag = tty.c_cflag & ~CRTSCTS;
+    cfsetispeed(&tty, speed);
+    cfsetospeed(&tty, speed);
+    tcsetattr(fd, TCSANOW, &tty);
+    tcflush(fd, TCIOFLUSH);
+
+    return fd;
+}
+
+// Run a command with its stdin and stdout on a pseudo-terminal, returns the master side
+// The command stderr is kept (native build HID reports)
+int open_command(const char* command, pid_t* pid)
+{
+    struct termios tty;
+    int master = -1;
+    int slave = -1;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if((master < 0) || (grantpt(master) != 0) || (unlockpt(master) != 0))
+    {
+        fprintf(stderr, "Error: Can't create a pseudo-terminal\n");
+        return -1;
+    }
+    slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if((slave < 0) || (tcgetattr(slave, &tty) != 0))
+    {
+        fprintf(stderr, "Error: Can't open the pseudo-terminal\n");
+        close(master);
+        return -1;
+    }
+    cfmakeraw(&tty);
+    tcsetattr(slave, TCSANOW, &tty);
+
+    *pid = fork();
+    if(*pid < 0)
+    {
+        fprintf(stderr, "Error: Can't run command %s\n", command);
+        close(slave);
+        close(master);
+        return -1;
+    }
+    if(*pid == 0)
+    {
+        close(master);
+        setsid();
+        dup2(slave, STDIN_FILENO);
+        dup2(slave, STDOUT_FILENO);
+        close(slave);
+        execl("/bin/sh", "sh", "-c", command, (char*)NULL);
+        _exit(127);
+    }
+
+    close(slave);
+    signal(SIGPIPE, SIG_IGN);
+
+    return master;
+}
+
+/**************************************************************************************************/
+
+/* Streaming Functions */
+
+// Send all the script lines, returns 0 once all of them have been acknowledged
+// An end of line (to end any partial line and the device frames sequence) and an empty frame
+// (ping) are sent first. Lines too long for a frame (streamed STRING lines) are sent as plain
+// text lines, unchecked, once all previous frames are acknowledged, followed by an empty frame
+// whose acknowledgment means the line has been received
+int stream_script(t_stream* stream, const t_line* lines, const uint32_t n)
+{
+    t_inflight* oldest = NULL;
+    uint32_t next = 0;
+    uint64_t waited_ms = 0;
+
+    stream->lines_n = n;
+
+    // Ping (line index n)
+    if((write(stream->fd, "\n", 1) != 1) || (send_frame(stream, lines, n) != 0))
+        return 1;
+
+    while((next < n) || (stream->inflight_n > 0))
+    {
+        // Fill the window (a plain text line waits for all previous frames)
+        while((next < n) && (stream->inflight_n < stream->window) && !stream->paused)
+        {
+            if((lines[next].len > FRAME_PAYLOAD_MAX) && (stream->inflight_n > 0))
+                break;
+            if(send_frame(stream, lines, next) != 0)
+                return 1;
+            next = next + 1;
+        }
+
+        if(poll_device(stream, 10) != 0)
+            return 1;
+
+        // Rejected frame, or oldest frame acknowledgment timeout
+        if(stream->inflight_n == 0)
+            continue;
+        oldest = &(stream->inflight[stream->inflight_head]);
+        waited_ms = (now_us() - oldest->sent_us) / 1000;
+        if(!stream->go_back && (waited_ms < stream->timeout_ms))
+            continue;
+        if(oldest->resends >= MAX_RESENDS)
+        {
+            if(stream->go_back)
+                fprintf(stderr, "Error: Line %u rejected by the device\n", oldest->line + 1);
+            else
+            {
+                fprintf(stderr, "Error: No acknowledgment of line %u in %u ms\n",
+                    oldest->line + 1, stream->timeout_ms);
+            }
+            return 1;
+        }
+        if(go_back(stream, lines) != 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+// Send a data frame with a script line (or an empty one) and add it to the frames in flight
+// Line index out of the script lines is an empty frame (ping)
+int send_frame(t_stream* stream, const t_line* lines, const uint32_t index)
+{
+    const t_line* line = (index < stream->lines_n) ? &(lines[index]) : NULL;
+    uint32_t slot = 0;
+
+    // Line too long for a frame, send it as a plain text line and acknowledge it with a ping
+    if((line != NULL) && (line->len > FRAME_PAYLOAD_MAX) && (write_text(stream, line) != 0))
+        return 1;
+    if(write_frame(stream, line, stream->next_seq) != 0)
+        return 1;
+
+    slot = (stream->inflight_head + stream->inflight_n) % MAX_WINDOW;
+    stream->inflight[slot].line = index;
+    stream->inflight[slot].seq = stream->next_seq;
+    stream->inflight[slot].resends = 0;
+    stream->inflight[slot].sent_us = now_us();
+    stream->inflight_n = stream->inflight_n + 1;
+    stream->next_seq = stream->next_seq + 1;
+
+    return 0;
+}
+
+// Resend all the frames in flight, starting with the oldest one
+// The device rejects the frames that follow a lost one and just acknowledges the already accepted
+// ones. Replies of the frames sent before going back are ignored (but acknowledgments), until the
+// oldest one is acknowledged. A plain text line is not written again, only its empty frame. The
+// resend attempts are counted for the oldest frame (the other ones are resent as it is lost)
+int go_back(t_stream* stream, const t_line* lines)
+{
+    t_inflight* frame = NULL;
+    const t_line* line = NULL;
+
+    for(uint32_t i = 0; i < stream->inflight_n; i++)
+    {
+        frame = &(stream->inflight[(stream->inflight_head + i) % MAX_WINDOW]);
+        line = (frame->line < stream->lines_n) ? &(lines[frame->line]) : NULL;
+        if(write_frame(stream, line, frame->seq) != 0)
+            return 1;
+        frame->sent_us = now_us();
+        stream->resends = stream->resends + 1;
+    }
+    frame = &(stream->inflight[stream->inflight_head]);
+    frame->resends = frame->resends + 1;
+    stream->go_back = false;
+    stream->recovering = true;
+
+    return 0;
+}
+
+// Write a data frame with a script line (or an empty one, for a line too long for a frame)
+int write_frame(t_stream* stream, const t_line* line, const uint8_t seq)
+{
+    uint8_t frame[FRAME_PAYLOAD_MAX + FRAME_OVERHEAD];
+    uint8_t length = 0;
+    uint16_t crc = RX_FRAME_CRC_INIT;
+
+    if((line != NULL) && (line->len <= FRAME_PAYLOAD_MAX))
+        length = line->len;
+
+    frame[0] = RX_FRAME_SYNC;
+    frame[1] = RX_FRAME_DATA;
+    frame[2] = seq;
+    frame[3] = length;
+    if(length > 0)
+        memcpy(&(frame[4]), line->text, length);
+    for(uint8_t i = 1; i < 4 + length; i++)
+        crc = rx_crc16_update(crc, frame[i]);
+    frame[4 + length] = crc >> 8;
+    frame[5 + length] = crc & 0xFF;
+    if(write(stream->fd, frame, length + FRAME_OVERHEAD) != length + FRAME_OVERHEAD)
+    {
+        fprintf(stderr, "Error: Can't write to device\n");
+        return 1;
+    }
+    stream->bytes = stream->bytes + length + FRAME_OVERHEAD;
+
+    return 0;
+}
+
+// Write a plain text line in chunks, waiting while the device has sent XOFF
+int write_text(t_stream* stream, const t_line* line)
+{
+    uint32_t sent = 0;
+    uint32_t size = 0;
+
+    while(sent <= line->len)
+    {
+        if(poll_device(stream, stream->paused ? 10 : 0) != 0)
+            return 1;
+        if(stream->paused)
+        {
+            if((now_us() - stream->paused_us) / 1000 < stream->timeout_ms)
+                continue;
+            fprintf(stderr, "Error: Device paused for more than %u ms\n", stream->timeout_ms);
+            return 1;
+        }
+
+        // Text chunk, or end of line
+        size = (line->len - sent < TEXT_CHUNK) ? line->len - sent : TEXT_CHUNK;
+        if(((size > 0) && (write(stream->fd, &(line->text[sent]), size) != (ssize_t)size)) ||
+           ((size == 0) && (write(stream->fd, "\n", 1) != 1)))
+        {
+            fprintf(stderr, "Error: Can't write to device\n");
+            return 1;
+        }
+        size = (size > 0) ? size : 1;
+        sent = sent + size;
+        stream->bytes = stream->bytes + size;
+    }
+
+    return 0;
+}
+
+// Wait for received bytes up to a time and handle them
+int poll_device(t_stream* stream, const int timeout_ms)
+{
+    struct pollfd fds;
+    int rc = 0;
+
+    fds.fd = stream->fd;
+    fds.events = POLLIN;
+    fds.revents = 0;
+    rc = poll(&fds, 1, timeout_ms);
+    if((rc > 0) && (fds.revents & (POLLERR | POLLHUP)) && !(fds.revents & POLLIN))
+    {
+        fprintf(stderr, "Error: Device closed\n");
+        return 1;
+    }
+    if((rc > 0) && (receive(stream) != 0))
+        return 1;
+
+    return 0;
+}
+
+// Handle received bytes (acknowledgments and flow control)
+// Device text output (i.e. startup log messages) is ignored. Replies are [ACK|NAK][sequence], with
+// the 7 low bits of the frame sequence and the high bit set (never a XON/XOFF character). An
+// acknowledgment is cumulative (the device accepts frames in order), and replies of frames not in
+// flight anymore are ignored
+int receive(t_stream* stream)
+{
+    uint8_t buffer[256];
+    t_inflight* frame = NULL;
+    uint32_t found = 0;
+    uint8_t reply = 0;
+    ssize_t n = 0;
+    uint8_t byte = 0;
+
+    n = read(stream->fd, buffer, sizeof(buffer));
+    if(n <= 0)
+    {
+        fprintf(stderr, "Error: Device closed\n");
+        return 1;
+    }
+
+    for(ssize_t i = 0; i < n; i++)
+    {
+        byte = buffer[i];
+
+        // Reply sequence
+        if(stream->reply != 0)
+        {
+            reply = stream->reply;
+            stream->reply = 0;
+            for(found = 0; found < stream->inflight_n; found++)
+            {
+                frame = &(stream->inflight[(stream->inflight_head + found) % MAX_WINDOW]);
+                if(RX_FRAME_REPLY_SEQ(frame->seq) == byte)
+                    break;
+            }
+            if(found == stream->inflight_n)
+                continue;
+
+            // Rejected frame, the frames after the oldest one are rejected while recovering
+            if(reply == RX_FRAME_NAK)
+            {
+                if(stream->recovering && (found > 0))
+                    continue;
+                stream->naks = stream->naks + 1;
+                stream->go_back = true;
+                stream->recovering = true;
+                continue;
+            }
+
+            // Acknowledged frame and all the ones sent before it
+            for(uint32_t j = 0; j <= found; j++)
+            {
+                frame = &(stream->inflight[stream->inflight_head]);
+                stream->latencies_us[stream->acked] = (uint32_t)(now_us() - frame->sent_us);
+                stream->acked = stream->acked + 1;
+                stream->inflight_head = (stream->inflight_head + 1) % MAX_WINDOW;
+                stream->inflight_n = stream->inflight_n - 1;
+            }
+            stream->go_back = false;
+            stream->recovering = false;
+            continue;
+        }
+
+        if((byte == RX_FRAME_ACK) || (byte == RX_FRAME_NAK))
+            stream->reply = byte;
+        else if(byte == RX_XOFF)
+        {
+            stream->paused = true;
+            stream->paused_us = now_us();
+        }
+        else if(byte == RX_XON)
+            stream->paused = false;
+    }
+
+    return 0;
+}
+
+/**************************************************************************************************/
+
+/* Results Functions */
+
+// Compare two latencies (qsort)
+static int compare_u32(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+// Write the streaming results
+// Latency is measured from a frame being sent to its acknowledgment (line received and queued by
+// the device), the first acknowledgment (ping) is not included
+void print_results(const t_stream* stream, const uint32_t lines, const uint32_t skipped,
+    const uint64_t elapsed_us)
+{
+    uint32_t* sorted = NULL;
+    uint32_t n = (stream->acked > 0) ? stream->acked - 1 : 0;
+    double seconds = elapsed_us / 1000000.0;
+    const uint8_t percentiles[] = { 50, 90, 99 };
+
+    printf("Lines: %u sent (%u REM and empty lines skipped), %u acknowledged\n", lines, skipped, n);
+    printf("Bytes: %llu\n", (unsigned long long)stream->bytes);
+    printf("Time: %.3f s\n", seconds);
+    if(seconds > 0)
+    {
+        printf("Throughput: %.1f lines/s, %.1f bytes/s\n", n / seconds,
+            stream->bytes / seconds);
+    }
+    printf("Resent frames: %u, rejected frames: %u\n", stream->resends, stream->naks);
+    if(n == 0)
+        return;
+
+    sorted = &(stream->latencies_us[1]);
+    qsort(sorted, n, sizeof(uint32_t), compare_u32);
+    printf("Acknowledgment latency:");
+    for(uint8_t i = 0; i < sizeof(percentiles); i++)
+        printf(" p%u %u us,", percentiles[i], sorted[((n - 1) * percentiles[i]) / 100]);
+    printf(" max %u us\n", sorted[n - 1]);
+}
+
+// Get a monotonic time (us)
+uint64_t now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
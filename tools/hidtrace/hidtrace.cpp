@@ -0,0 +1,234 @@
+/**************************************************************************************************/
+/* Name:                                                                                          */
+/*     hidtrace                                                                                   */
+/* Description:                                                                                   */
+/*     Host (Linux) comparator of native build HID reports traces. A trace is checked against a   */
+/*     golden one: reports content has to match byte for byte, and each report time (from the    */
+/*     first report) can't differ more than a tolerance. Exits with 0 if the traces match.        */
+/* Build:                                                                                         */
+/*     g++ -std=gnu++11 -O2 tools/hidtrace/hidtrace.cpp -o hidtrace                               */
+/* Usage:                                                                                         */
+/*     hidtrace [-t tolerance_us] golden.trace new.trace                                          */
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/**************************************************************************************************/
+
+/* Defines */
+
+// Default report time tolerance (us)
+#define DEFAULT_TOLERANCE_US 1000
+
+// Report bytes (modifiers and 6 keys)
+#define REPORT_SIZE 7
+
+// Maximum number of differences written of each type
+#define MAX_DIFFS_SHOWN 10
+
+// Maximum length of trace lines read
+#define MAX_LINE_LENGTH 256
+
+/**************************************************************************************************/
+
+/* Data Types */
+
+// Recorded HID report
+typedef struct
+{
+    uint32_t us;
+    uint8_t data[REPORT_SIZE];
+} t_report;
+
+// HID reports trace
+typedef struct
+{
+    t_report* reports;
+    uint32_t n;
+} t_trace;
+
+/**************************************************************************************************/
+
+/* Functions Prototypes */
+
+// Load the HID reports of a trace file (other lines are ignored, so stderr output can be used)
+int load_trace(const char* path, t_trace* trace);
+
+// Compare a trace against a golden one, returns the number of differences found
+uint32_t compare_traces(const t_trace* golden, const t_trace* trace, const uint32_t tolerance_us);
+
+// Write a report
+void print_report(const char* label, const t_report* report, const uint32_t us);
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(int argc, char* argv[])
+{
+    t_trace golden = { NULL, 0 };
+    t_trace trace = { NULL, 0 };
+    uint32_t tolerance_us = DEFAULT_TOLERANCE_US;
+    uint32_t diffs = 0;
+    int arg = 1;
+
+    if((argc > 2) && (strcmp(argv[1], "-t") == 0))
+    {
+        tolerance_us = strtoul(argv[2], NULL, 10);
+        arg = 3;
+    }
+    if(argc - arg != 2)
+    {
+        fprintf(stderr, "Usage: %s [-t tolerance_us] golden.trace new.trace\n", argv[0]);
+        return 1;
+    }
+
+    if((load_trace(argv[arg], &golden) != 0) || (load_trace(argv[arg+1], &trace) != 0))
+        return 1;
+
+    diffs = compare_traces(&golden, &trace, tolerance_us);
+
+    free(golden.reports);
+    free(trace.reports);
+
+    if(diffs != 0)
+    {
+        printf("FAIL: %u differences\n", diffs);
+        return 1;
+    }
+    printf("OK\n");
+
+    return 0;
+}
+
+/**************************************************************************************************/
+
+/* Trace Functions */
+
+// Load the HID reports of a trace file (other lines are ignored, so stderr output can be used)
+// Report lines format: "HID <us> <modifiers> <key1> ... <key6>" (hexadecimal bytes)
+int load_trace(const char* path, t_trace* trace)
+{
+    FILE* in = NULL;
+    char line[MAX_LINE_LENGTH];
+    unsigned int v[REPORT_SIZE];
+    unsigned int us = 0;
+    uint32_t capacity = 0;
+    t_report* reports = NULL;
+
+    in = fopen(path, "r");
+    if(in == NULL)
+    {
+        fprintf(stderr, "Error: Can't open trace file %s\n", path);
+        return 1;
+    }
+
+    while(fgets(line, sizeof(line), in) != NULL)
+    {
+        if(sscanf(line, "HID %u %x %x %x %x %x %x %x", &us, &v[0], &v[1], &v[2], &v[3], &v[4],
+                &v[5], &v[6]) != 1 + REPORT_SIZE)
+            continue;
+
+        if(trace->n == capacity)
+        {
+            capacity = (capacity == 0) ? 256 : capacity * 2;
+            reports = (t_report*)realloc(trace->reports, capacity * sizeof(t_report));
+            if(reports == NULL)
+            {
+                fprintf(stderr, "Error: Not enough memory for trace %s\n", path);
+                fclose(in);
+                return 1;
+            }
+            trace->reports = reports;
+        }
+
+        trace->reports[trace->n].us = us;
+        for(uint8_t i = 0; i < REPORT_SIZE; i++)
+            trace->reports[trace->n].data[i] = (uint8_t)v[i];
+        trace->n = trace->n + 1;
+    }
+
+    fclose(in);
+
+    return 0;
+}
+
+// Compare a trace against a golden one, returns the number of differences found
+// Report times are compared from the first report of each trace, so the time until the first
+// report doesn't shift the whole trace
+uint32_t compare_traces(const t_trace* golden, const t_trace* trace, const uint32_t tolerance_us)
+{
+    uint32_t n = (golden->n < trace->n) ? golden->n : trace->n;
+    uint32_t content_diffs = 0;
+    uint32_t timing_diffs = 0;
+    int64_t max_drift = 0;
+    int64_t drift = 0;
+    uint32_t golden_us = 0;
+    uint32_t trace_us = 0;
+
+    if(golden->n != trace->n)
+    {
+        printf("Reports: %u golden, %u new\n", golden->n, trace->n);
+        content_diffs = content_diffs + 1;
+    }
+
+    for(uint32_t i = 0; i < n; i++)
+    {
+        golden_us = golden->reports[i].us - golden->reports[0].us;
+        trace_us = trace->reports[i].us - trace->reports[0].us;
+
+        // Content
+        if(memcmp(golden->reports[i].data, trace->reports[i].data, REPORT_SIZE) != 0)
+        {
+            if(content_diffs < MAX_DIFFS_SHOWN)
+            {
+                printf("Report %u content differs:\n", i);
+                print_report("golden", &(golden->reports[i]), golden_us);
+                print_report("new", &(trace->reports[i]), trace_us);
+            }
+            content_diffs = content_diffs + 1;
+            continue;
+        }
+
+        // Timing
+        drift = (int64_t)trace_us - (int64_t)golden_us;
+        if(llabs(drift) > llabs(max_drift))
+            max_drift = drift;
+        if(llabs(drift) > tolerance_us)
+        {
+            if(timing_diffs < MAX_DIFFS_SHOWN)
+            {
+                printf("Report %u time differs %+lld us:\n", i, (long long)drift);
+                print_report("golden", &(golden->reports[i]), golden_us);
+                print_report("new", &(trace->reports[i]), trace_us);
+            }
+            timing_diffs = timing_diffs + 1;
+        }
+    }
+
+    printf("Content differences: %u\n", content_diffs);
+    printf("Timing differences (> %u us): %u\n", tolerance_us, timing_diffs);
+    printf("Maximum time drift: %+lld us\n", (long long)max_drift);
+    if((golden->n > 0) && (trace->n > 0))
+    {
+        printf("Output time: %u us golden, %u us new\n",
+            golden->reports[golden->n - 1].us - golden->reports[0].us,
+            trace->reports[trace->n - 1].us - trace->reports[0].us);
+    }
+
+    return content_diffs + timing_diffs;
+}
+
+// Write a report
+void print_report(const char* label, const t_report* report, const uint32_t us)
+{
+    printf("  %-6s %10u us:", label, us);
+    for(uint8_t i = 0; i < REPORT_SIZE; i++)
+        printf(" %02X", report->data[i]);
+    printf("\n");
+}